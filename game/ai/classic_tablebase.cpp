@@ -0,0 +1,211 @@
+#include "classic_tablebase.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', 'T', 'T', 'B' };
+
+// Exhaustive negamax over every position reachable from the empty board.
+// There is no cutoff on a found win: the table must also cover positions the
+// players only reach after a mistake. The output table doubles as the memo: a slot is Unknown until its canonical
+// position has been solved. The eight symmetric base-3 keys are kept up to
+// date incrementally, so the canonical key costs eight additions per move.
+class Generator {
+public:
+    Generator(int N, std::vector<uchar>& table)
+        : N_(N), cells_(N * N), table_(table), board_(N * N, 0) {
+        std::vector<quint64> pow3(cells_, 1);
+        for (int i = 1; i < cells_; ++i) pow3[i] = pow3[i - 1] * 3;
+
+        for (int s = 0; s < kSymmetryCount; ++s) {
+            weight_[s].assign(cells_, 0);
+            keys_[s] = 0;
+            for (int p = 0; p < cells_; ++p) {
+                int tr = 0, tc = 0;
+                transformCell(s, N, p / N, p % N, tr, tc);
+                weight_[s][tr * N + tc] = pow3[cells_ - 1 - p];
+                keys_[s] += pow3[p];
+            }
+        }
+    }
+
+    void run() { solve(1, 0); }
+
+private:
+    quint64 canonicalKey() const {
+        quint64 best = keys_[0];
+        for (int s = 1; s < kSymmetryCount; ++s) {
+            if (keys_[s] < best) best = keys_[s];
+        }
+        return best;
+    }
+
+    ClassicTablebase::Value get(quint64 key) const {
+        return static_cast<ClassicTablebase::Value>((table_[key >> 2] >> ((key & 3) * 2)) & 3);
+    }
+
+    void set(quint64 key, ClassicTablebase::Value v) {
+        table_[key >> 2] = static_cast<uchar>(table_[key >> 2] | (v << ((key & 3) * 2)));
+    }
+
+    void place(int cell, int player) {
+        board_[cell] = player;
+        for (int s = 0; s < kSymmetryCount; ++s) {
+            if (player == 1) keys_[s] += weight_[s][cell];
+            else keys_[s] -= weight_[s][cell];
+        }
+    }
+
+    void unplace(int cell, int player) {
+        board_[cell] = 0;
+        for (int s = 0; s < kSymmetryCount; ++s) {
+            if (player == 1) keys_[s] -= weight_[s][cell];
+            else keys_[s] += weight_[s][cell];
+        }
+    }
+
+    bool winsThrough(int cell, int player) const {
+        const int r = cell / N_;
+        const int c = cell % N_;
+
+        bool row = true, col = true, diag = (r == c), anti = (r + c == N_ - 1);
+        for (int k = 0; k < N_; ++k) {
+            row = row && board_[r * N_ + k] == player;
+            col = col && board_[k * N_ + c] == player;
+            diag = diag && board_[k * N_ + k] == player;
+            anti = anti && board_[k * N_ + (N_ - 1 - k)] == player;
+        }
+        return row || col || diag || anti;
+    }
+
+    // Value of the current (non-terminal) position for the side to move.
+    ClassicTablebase::Value solve(int player, int moves) {
+        const quint64 key = canonicalKey();
+        const ClassicTablebase::Value cached = get(key);
+        if (cached != ClassicTablebase::Unknown) return cached;
+
+        ClassicTablebase::Value best = ClassicTablebase::Loss;
+
+        for (int cell = 0; cell < cells_; ++cell) {
+            if (board_[cell] != 0) continue;
+
+            place(cell, player);
+
+            ClassicTablebase::Value v = ClassicTablebase::Draw;
+            if (winsThrough(cell, player)) {
+                v = ClassicTablebase::Win;
+            } else if (moves + 1 < cells_) {
+                const ClassicTablebase::Value reply = solve(-player, moves + 1);
+                if (reply == ClassicTablebase::Loss) v = ClassicTablebase::Win;
+                else if (reply == ClassicTablebase::Win) v = ClassicTablebase::Loss;
+            }
+
+            unplace(cell, player);
+
+            if (v == ClassicTablebase::Win || (v == ClassicTablebase::Draw && best == ClassicTablebase::Loss)) {
+                best = v;
+            }
+        }
+
+        set(key, best);
+        return best;
+    }
+
+private:
+    int N_;
+    int cells_;
+    std::vector<uchar>& table_;
+    std::vector<int> board_;
+    std::vector<quint64> weight_[kSymmetryCount];
+    quint64 keys_[kSymmetryCount];
+};
+
+} // namespace
+
+ClassicTablebase::ClassicTablebase(const QString& path)
+    : path_(path) {}
+
+ClassicTablebase::~ClassicTablebase() {
+    if (data_) file_.unmap(const_cast<uchar*>(data_));
+}
+
+quint64 ClassicTablebase::entryCount(int boardSize) {
+    quint64 n = 1;
+    for (int i = 0; i < boardSize * boardSize; ++i) n *= 3;
+    return n;
+}
+
+bool ClassicTablebase::available() {
+    std::call_once(mapOnce_, [this]() {
+        file_.setFileName(path_);
+        if (!file_.open(QIODevice::ReadOnly)) return;
+
+        char header[kHeaderSize];
+        if (file_.read(header, kHeaderSize) != kHeaderSize || std::memcmp(header, kMagic, 4) != 0) return;
+
+        quint32 version = 0;
+        quint32 size = 0;
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&size, header + 8, 4);
+        if (version != kVersion || size < 2 || size > 4) return;
+
+        const quint64 entries = entryCount(static_cast<int>(size));
+        const qint64 bytes = kHeaderSize + static_cast<qint64>((entries + 3) / 4);
+        if (file_.size() != bytes) return;
+
+        uchar* mapped = file_.map(0, bytes);
+        if (!mapped) return;
+
+        data_ = mapped + kHeaderSize;
+        entries_ = entries;
+        boardSize_ = static_cast<int>(size);
+    });
+
+    return data_ != nullptr;
+}
+
+int ClassicTablebase::boardSize() {
+    return available() ? boardSize_ : 0;
+}
+
+ClassicTablebase::Value ClassicTablebase::probe(quint64 canonicalKey) {
+    if (!available() || canonicalKey >= entries_) return Unknown;
+    return static_cast<Value>((data_[canonicalKey >> 2] >> ((canonicalKey & 3) * 2)) & 3);
+}
+
+bool ClassicTablebase::generate(int boardSize, const QString& path, QString* error) {
+    if (boardSize < 2 || boardSize > 4) {
+        if (error) *error = QStringLiteral("unsupported board size");
+        return false;
+    }
+
+    const quint64 entries = entryCount(boardSize);
+    std::vector<uchar> table(static_cast<size_t>((entries + 3) / 4), 0);
+
+    Generator gen(boardSize, table);
+    gen.run();
+
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize] = {};
+    const quint32 version = kVersion;
+    const quint32 size = static_cast<quint32>(boardSize);
+    std::memcpy(header, kMagic, 4);
+    std::memcpy(header + 4, &version, 4);
+    std::memcpy(header + 8, &size, 4);
+
+    const qint64 bytes = static_cast<qint64>(table.size());
+    if (out.write(header, kHeaderSize) != kHeaderSize ||
+        out.write(reinterpret_cast<const char*>(table.data()), bytes) != bytes) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    return true;
+}
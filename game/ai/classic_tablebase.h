@@ -0,0 +1,91 @@
+#pragma once
+
+#include "game/ai/symmetry.h"
+#include "game/modes/igame_mode.h"
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <mutex>
+
+// Win/draw/loss table for Classic boards above 3x3, produced offline by the
+// classic_tablebase tool. Entries are 2 bits, addressed by the base-3 board
+// key minimised over symmetries (classicCanonicalKey), and give the result for
+// the side to move. Only canonical slots are filled; the rest stay Unknown.
+//
+// File layout: 16-byte header ("TTTB", version, board size, reserved), then
+// ceil(3^(N*N) / 4) bytes of packed entries. The file is memory-mapped on the
+// first probe, never read or computed at startup.
+class ClassicTablebase {
+public:
+    enum Value : quint8 { Unknown = 0, Win = 1, Draw = 2, Loss = 3 };
+
+    explicit ClassicTablebase(const QString& path);
+    ~ClassicTablebase();
+
+    ClassicTablebase(const ClassicTablebase&) = delete;
+    ClassicTablebase& operator=(const ClassicTablebase&) = delete;
+
+    QString path() const { return path_; }
+
+    // Maps the file if that has not been tried yet. Thread-safe.
+    bool available();
+    int boardSize();
+
+    Value probe(quint64 canonicalKey);
+
+    // Picks a move that keeps the best proven result. Returns false when the
+    // table is missing, built for another size, or lacks an entry.
+    template <class Mode>
+    bool pickMove(const Mode& state, int& outR, int& outC);
+
+    static quint64 entryCount(int boardSize);
+    static bool generate(int boardSize, const QString& path, QString* error = nullptr);
+
+private:
+    static constexpr quint32 kVersion = 1;
+    static constexpr qint64 kHeaderSize = 16;
+
+    QString path_;
+    QFile file_;
+    std::once_flag mapOnce_;
+    const uchar* data_ = nullptr;
+    quint64 entries_ = 0;
+    int boardSize_ = 0;
+};
+
+template <class Mode>
+bool ClassicTablebase::pickMove(const Mode& state, int& outR, int& outC) {
+    if (!available() || state.boardSize() != boardSize_) return false;
+
+    const int N = state.boardSize();
+    const int me = state.currentPlayer();
+    int bestRank = -1;
+
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+
+            Mode child = state;
+            const MoveOutcome out = child.applyMove(r, c);
+
+            int rank = 0;
+            if (out.finished) {
+                rank = (out.classicWinner == me) ? 2 : (out.classicWinner == 0 ? 1 : 0);
+            } else {
+                const Value v = probe(classicCanonicalKey(child));
+                if (v == Unknown) return false;
+                rank = (v == Loss) ? 2 : (v == Draw ? 1 : 0);
+            }
+
+            if (rank > bestRank) {
+                bestRank = rank;
+                outR = r;
+                outC = c;
+            }
+        }
+    }
+
+    return bestRank >= 0;
+}
@@ -0,0 +1,449 @@
+#include "kinarow_prover.h"
+
+#include <algorithm>
+#include <utility>
+
+KInARowProver::Result KInARowProver::solve(const std::vector<qint8>& board, int N, int K, int toMove,
+                                           const Limits& limits, int& bestCell) {
+    nodeCount_ = 0;
+    if (K < 3 || N < K) return Result::Unknown;
+
+    setup(board, N, K);
+    deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.maxMillis);
+
+    int best = -1;
+    if (prove(toMove, toMove, limits, best)) {
+        bestCell = best;
+        return Result::Win;
+    }
+
+    int unused = -1;
+    if (prove(-toMove, toMove, limits, unused)) return Result::Loss;
+
+    return Result::Unknown;
+}
+
+void KInARowProver::setup(const std::vector<qint8>& board, int N, int K) {
+    N_ = N;
+    K_ = K;
+    board_ = board;
+
+    empties_ = 0;
+    for (qint8 v : board_) {
+        if (v == 0) empties_++;
+    }
+
+    // Every run of K cells along a row, column or diagonal.
+    static const int dirs[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+    windows_.clear();
+    for (const auto& d : dirs) {
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                const int er = r + (K - 1) * d[0];
+                const int ec = c + (K - 1) * d[1];
+                if (er < 0 || ec < 0 || er >= N || ec >= N) continue;
+                for (int k = 0; k < K; ++k) windows_.push_back((r + k * d[0]) * N + (c + k * d[1]));
+            }
+        }
+    }
+
+    const int windowCount = static_cast<int>(windows_.size()) / K;
+
+    cellWindowsAt_.assign(N * N + 1, 0);
+    for (int cell : windows_) cellWindowsAt_[cell + 1]++;
+    for (int i = 0; i < N * N; ++i) cellWindowsAt_[i + 1] += cellWindowsAt_[i];
+
+    cellWindows_.assign(windows_.size(), 0);
+    std::vector<int> fill(cellWindowsAt_.begin(), cellWindowsAt_.end() - 1);
+    for (int w = 0; w < windowCount; ++w) {
+        for (int k = 0; k < K; ++k) cellWindows_[fill[windows_[w * K + k]]++] = w;
+    }
+
+    for (int s = 0; s < 2; ++s) count_[s].assign(windowCount, 0);
+    fours_[0] = fours_[1] = 0;
+    threes_[0] = threes_[1] = 0;
+    for (int w = 0; w < windowCount; ++w) {
+        for (int k = 0; k < K; ++k) {
+            const int v = board_[windows_[w * K + k]];
+            if (v != 0) count_[sideOf(v)][w]++;
+        }
+        account(w, 1);
+    }
+
+    stamp_.assign(N * N, 0);
+    stampValue_ = 0;
+}
+
+void KInARowProver::account(int w, int sign) {
+    for (int s = 0; s < 2; ++s) {
+        if (count_[1 - s][w] != 0) continue;
+        if (count_[s][w] == K_ - 1) fours_[s] += sign;
+        else if (count_[s][w] == K_ - 2) threes_[s] += sign;
+    }
+}
+
+bool KInARowProver::place(int cell, int player) {
+    const int s = sideOf(player);
+    bool won = false;
+
+    for (int i = cellWindowsAt_[cell]; i < cellWindowsAt_[cell + 1]; ++i) {
+        const int w = cellWindows_[i];
+        account(w, -1);
+        if (++count_[s][w] == K_) won = true;
+        account(w, 1);
+    }
+
+    board_[cell] = static_cast<qint8>(player);
+    empties_--;
+    return won;
+}
+
+void KInARowProver::remove(int cell) {
+    const int s = sideOf(board_[cell]);
+
+    for (int i = cellWindowsAt_[cell]; i < cellWindowsAt_[cell + 1]; ++i) {
+        const int w = cellWindows_[i];
+        account(w, -1);
+        --count_[s][w];
+        account(w, 1);
+    }
+
+    board_[cell] = 0;
+    empties_++;
+}
+
+void KInARowProver::newStamp() {
+    if (++stampValue_ == 0) {
+        std::fill(stamp_.begin(), stamp_.end(), 0);
+        stampValue_ = 1;
+    }
+}
+
+bool KInARowProver::markOnce(int cell) {
+    if (stamp_[cell] == stampValue_) return false;
+    stamp_[cell] = stampValue_;
+    return true;
+}
+
+// Cells where `player` completes K right now. Starts a new stamp.
+void KInARowProver::completionCells(int player, std::vector<int>& out) {
+    const int s = sideOf(player);
+    const int windowCount = static_cast<int>(count_[s].size());
+
+    out.clear();
+    newStamp();
+    for (int w = 0; w < windowCount; ++w) {
+        if (count_[s][w] != K_ - 1 || count_[1 - s][w] != 0) continue;
+        for (int k = 0; k < K_; ++k) {
+            const int cell = windows_[w * K_ + k];
+            if (board_[cell] == 0 && markOnce(cell)) out.push_back(cell);
+        }
+    }
+}
+
+// Cells that would give `player` a four. Appends; uses the current stamp.
+void KInARowProver::fourMoves(int player, std::vector<int>& out) {
+    const int s = sideOf(player);
+    const int windowCount = static_cast<int>(count_[s].size());
+
+    for (int w = 0; w < windowCount; ++w) {
+        if (count_[s][w] != K_ - 2 || count_[1 - s][w] != 0) continue;
+        for (int k = 0; k < K_; ++k) {
+            const int cell = windows_[w * K_ + k];
+            if (board_[cell] == 0 && markOnce(cell)) out.push_back(cell);
+        }
+    }
+}
+
+// A window one stone short of a four pairs its two empty cells: taking one
+// leaves the other as a completion cell. A cell paired with two different
+// cells is a double: playing it makes two fours at once.
+namespace {
+
+using CellPairs = std::vector<std::pair<int, int>>;
+
+template <class Fn>
+void forEachDouble(CellPairs& pairs, Fn fn) {
+    std::sort(pairs.begin(), pairs.end());
+    size_t i = 0;
+    while (i < pairs.size()) {
+        size_t j = i;
+        int distinct = 0;
+        int prev = -1;
+        while (j < pairs.size() && pairs[j].first == pairs[i].first) {
+            if (pairs[j].second != prev) {
+                distinct++;
+                prev = pairs[j].second;
+            }
+            j++;
+        }
+        if (distinct >= 2 && !fn(pairs.begin() + i, pairs.begin() + j)) return;
+        i = j;
+    }
+}
+
+}
+
+bool KInARowProver::hasDoubleCell(int player) {
+    const int s = sideOf(player);
+    if (threes_[s] < 2) return false;
+
+    const int windowCount = static_cast<int>(count_[s].size());
+
+    CellPairs pairs;
+    for (int w = 0; w < windowCount; ++w) {
+        if (count_[s][w] != K_ - 2 || count_[1 - s][w] != 0) continue;
+        int e[2];
+        int n = 0;
+        for (int k = 0; k < K_ && n < 2; ++k) {
+            const int cell = windows_[w * K_ + k];
+            if (board_[cell] == 0) e[n++] = cell;
+        }
+        pairs.emplace_back(e[0], e[1]);
+        pairs.emplace_back(e[1], e[0]);
+    }
+
+    bool found = false;
+    forEachDouble(pairs, [&found](CellPairs::iterator, CellPairs::iterator) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+// Every double cell of `player` and the cells it pairs with: the defender
+// must take one of them or the double stays playable. Appends; uses the
+// current stamp.
+void KInARowProver::doubleDefence(int player, std::vector<int>& out) {
+    const int s = sideOf(player);
+    if (threes_[s] < 2) return;
+
+    const int windowCount = static_cast<int>(count_[s].size());
+
+    CellPairs pairs;
+    for (int w = 0; w < windowCount; ++w) {
+        if (count_[s][w] != K_ - 2 || count_[1 - s][w] != 0) continue;
+        int e[2];
+        int n = 0;
+        for (int k = 0; k < K_ && n < 2; ++k) {
+            const int cell = windows_[w * K_ + k];
+            if (board_[cell] == 0) e[n++] = cell;
+        }
+        pairs.emplace_back(e[0], e[1]);
+        pairs.emplace_back(e[1], e[0]);
+    }
+
+    forEachDouble(pairs, [this, &out](CellPairs::iterator first, CellPairs::iterator last) {
+        if (markOnce(first->first)) out.push_back(first->first);
+        for (auto it = first; it != last; ++it) {
+            if (markOnce(it->second)) out.push_back(it->second);
+        }
+        return true;
+    });
+}
+
+bool KInARowProver::makesThreat(int cell, int player) {
+    place(cell, player);
+    const bool threat = fours_[sideOf(player)] > 0 || hasDoubleCell(player);
+    remove(cell);
+    return threat;
+}
+
+void KInARowProver::evaluate(Node& n, int toMove, bool moverWon) {
+    const int A = attacker_;
+    const int D = -A;
+
+    auto proven = [&n]() { n.pn = 0; n.dn = kInf; };
+    auto disproven = [&n]() { n.pn = kInf; n.dn = 0; };
+
+    n.pn = 1;
+    n.dn = 1;
+
+    if (moverWon) {
+        if (-toMove == A) proven();
+        else disproven();
+        return;
+    }
+    if (empties_ == 0) {
+        disproven();
+        return;
+    }
+
+    std::vector<int> cells;
+    if (!n.andNode) {
+        if (fours_[sideOf(A)] > 0) {
+            proven();
+        } else if (fours_[sideOf(D)] > 0) {
+            completionCells(D, cells);
+            if (cells.size() > 1) disproven();
+        }
+        return;
+    }
+
+    if (fours_[sideOf(D)] > 0) {
+        disproven();
+    } else if (fours_[sideOf(A)] > 0) {
+        completionCells(A, cells);
+        if (cells.size() > 1) proven();
+    } else if (!hasDoubleCell(A)) {
+        disproven();
+    }
+}
+
+void KInARowProver::generate(const Node& n, int toMove, std::vector<int>& moves) {
+    const int A = attacker_;
+    const int D = -A;
+    Q_UNUSED(toMove);
+
+    moves.clear();
+
+    if (!n.andNode) {
+        if (fours_[sideOf(D)] > 0) {
+            std::vector<int> block;
+            completionCells(D, block);
+            if (!block.empty() && makesThreat(block.front(), A)) moves.push_back(block.front());
+            return;
+        }
+
+        newStamp();
+        fourMoves(A, moves);
+
+        // Threes: cells in windows two stones short of a four.
+        std::vector<int> quiet;
+        const int sA = sideOf(A);
+        const int windowCount = static_cast<int>(count_[sA].size());
+        for (int w = 0; w < windowCount; ++w) {
+            if (count_[sA][w] != K_ - 3 || count_[1 - sA][w] != 0) continue;
+            for (int k = 0; k < K_; ++k) {
+                const int cell = windows_[w * K_ + k];
+                if (board_[cell] == 0 && markOnce(cell)) quiet.push_back(cell);
+            }
+        }
+        for (int cell : quiet) {
+            if (makesThreat(cell, A)) moves.push_back(cell);
+        }
+        return;
+    }
+
+    if (fours_[sideOf(A)] > 0) {
+        completionCells(A, moves);
+        moves.resize(1);
+        return;
+    }
+
+    newStamp();
+    doubleDefence(A, moves);
+    fourMoves(D, moves);
+}
+
+void KInARowProver::refresh(Node& n) {
+    if (!n.expanded || n.childCount == 0) return;
+
+    quint32 minValue = kInf;
+    quint32 sum = 0;
+    for (int i = 0; i < n.childCount; ++i) {
+        const Node& ch = pool_[n.firstChild + i];
+        const quint32 minOf = n.andNode ? ch.dn : ch.pn;
+        const quint32 sumOf = n.andNode ? ch.pn : ch.dn;
+        minValue = std::min(minValue, minOf);
+        sum = std::min<quint32>(kInf, sum + sumOf);
+    }
+
+    if (n.andNode) {
+        n.pn = sum;
+        n.dn = minValue;
+    } else {
+        n.pn = minValue;
+        n.dn = sum;
+    }
+}
+
+bool KInARowProver::prove(int attacker, int toMove, const Limits& limits, int& bestCell) {
+    attacker_ = attacker;
+    pool_.clear();
+
+    Node root;
+    root.andNode = (toMove != attacker);
+    evaluate(root, toMove, false);
+    pool_.push_back(root);
+
+    std::vector<int> moves;
+    int iterations = 0;
+
+    while (pool_[0].pn != 0 && pool_[0].dn != 0) {
+        if (static_cast<int>(pool_.size()) >= limits.maxNodes) break;
+        if ((++iterations & 255) == 0) {
+            if (std::chrono::steady_clock::now() > deadline_ || searchCancelled(limits.cancel)) break;
+            if (progress_) progress_->post(0, -1, -1, 0, nodeCount_ + static_cast<qint64>(pool_.size()));
+        }
+
+        // Descend to the most-proving leaf, playing the moves on the way.
+        int cur = 0;
+        int side = toMove;
+        while (pool_[cur].expanded) {
+            const Node& n = pool_[cur];
+            int pick = n.firstChild;
+            for (int i = 1; i < n.childCount; ++i) {
+                const Node& ch = pool_[n.firstChild + i];
+                const Node& best = pool_[pick];
+                if (n.andNode ? (ch.dn < best.dn) : (ch.pn < best.pn)) pick = n.firstChild + i;
+            }
+            place(pool_[pick].move, side);
+            side = -side;
+            cur = pick;
+        }
+
+        generate(pool_[cur], side, moves);
+
+        const int first = static_cast<int>(pool_.size());
+        for (int m : moves) {
+            Node ch;
+            ch.parent = cur;
+            ch.move = m;
+            ch.andNode = !pool_[cur].andNode;
+            const bool won = place(m, side);
+            evaluate(ch, -side, won);
+            remove(m);
+            pool_.push_back(ch);
+        }
+
+        Node& leaf = pool_[cur];
+        leaf.expanded = true;
+        leaf.firstChild = first;
+        leaf.childCount = static_cast<int>(moves.size());
+        if (moves.empty()) {
+            leaf.pn = kInf;
+            leaf.dn = 0;
+        } else {
+            refresh(leaf);
+        }
+
+        // Back up to the root, taking the moves back.
+        while (cur != 0) {
+            remove(pool_[cur].move);
+            cur = pool_[cur].parent;
+            refresh(pool_[cur]);
+        }
+    }
+
+    nodeCount_ += static_cast<qint64>(pool_.size());
+
+    const Node& r = pool_[0];
+    if (r.pn != 0) return false;
+
+    if (!r.andNode) {
+        for (int i = 0; i < r.childCount; ++i) {
+            if (pool_[r.firstChild + i].pn == 0) {
+                bestCell = pool_[r.firstChild + i].move;
+                break;
+            }
+        }
+        // Proven without expansion: the attacker already has a four.
+        if (bestCell < 0) {
+            std::vector<int> cells;
+            completionCells(attacker_, cells);
+            if (!cells.empty()) bestCell = cells.front();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "game/ai/search_progress.h"
+
+#include <QtGlobal>
+
+#include <chrono>
+#include <vector>
+
+// Proof-number search for K-in-a-row restricted to threat sequences. The
+// attacker only plays moves that make a four (K - 1 stones in an open window)
+// or a three (a cell from which the next move would make two fours); the
+// defender only answers a four by blocking it and a three by taking one of
+// its cells or making a four of its own. Any other defence loses by force,
+// so proofs found this way hold for the full game, while positions that need
+// quiet moves come back Unknown.
+//
+// The tree lives in a node pool capped by Limits::maxNodes; when the pool or
+// the time budget runs out, or the cancel flag is set, the answer is Unknown.
+class KInARowProver {
+public:
+    enum class Result { Unknown, Win, Loss };
+
+    struct Limits {
+        int maxNodes = 200000;
+        int maxMillis = 200;
+        const std::atomic<bool>* cancel = nullptr;  // checked with the clock
+    };
+
+    // Result is from the point of view of the side to move. For Win,
+    // bestR/bestC is the first move of the proof.
+    template <class Mode>
+    Result solve(const Mode& state, const Limits& limits, int& bestR, int& bestC) {
+        const int N = state.boardSize();
+        std::vector<qint8> board(N * N);
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) board[r * N + c] = static_cast<qint8>(state.cellOwner(r, c));
+        }
+
+        int best = -1;
+        const Result res = solve(board, N, state.winLine(), state.currentPlayer(), limits, best);
+        if (best >= 0) {
+            bestR = best / N;
+            bestC = best % N;
+        }
+        return res;
+    }
+
+    Result solve(const std::vector<qint8>& board, int N, int K, int toMove, const Limits& limits, int& bestCell);
+
+    qint64 nodes() const { return nodeCount_; }
+
+    // The size of the proof tree is posted here on every time check.
+    void setProgress(SearchProgressChannel* progress) { progress_ = progress; }
+
+private:
+    static constexpr quint32 kInf = 0x3FFFFFFF;
+
+    struct Node {
+        quint32 pn = 1;
+        quint32 dn = 1;
+        int parent = -1;
+        int firstChild = -1;
+        int childCount = 0;
+        int move = -1;
+        bool andNode = false;
+        bool expanded = false;
+    };
+
+    void setup(const std::vector<qint8>& board, int N, int K);
+    bool prove(int attacker, int toMove, const Limits& limits, int& bestCell);
+
+    static int sideOf(int player) { return player == 1 ? 0 : 1; }
+
+    bool place(int cell, int player);
+    void remove(int cell);
+    void account(int w, int sign);
+
+    void completionCells(int player, std::vector<int>& out);
+    bool hasDoubleCell(int player);
+    void doubleDefence(int player, std::vector<int>& out);
+    void fourMoves(int player, std::vector<int>& out);
+    bool makesThreat(int cell, int player);
+
+    void evaluate(Node& n, int toMove, bool moverWon);
+    void generate(const Node& n, int toMove, std::vector<int>& moves);
+    void refresh(Node& n);
+
+    void newStamp();
+    bool markOnce(int cell);
+
+private:
+    int N_ = 0;
+    int K_ = 0;
+    int attacker_ = 1;
+    int empties_ = 0;
+
+    std::vector<qint8> board_;
+    std::vector<int> windows_;      // K cells per window
+    std::vector<int> cellWindowsAt_; // offsets into cellWindows_, N*N + 1 entries
+    std::vector<int> cellWindows_;
+    std::vector<int> count_[2];
+    int fours_[2] = { 0, 0 };
+    int threes_[2] = { 0, 0 };
+
+    std::vector<int> stamp_;
+    int stampValue_ = 0;
+
+    std::vector<Node> pool_;
+    qint64 nodeCount_ = 0;
+    SearchProgressChannel* progress_ = nullptr;
+    std::chrono::steady_clock::time_point deadline_;
+};
@@ -0,0 +1,198 @@
+#include "move_analysis.h"
+
+#include "game/ai/search_core.h"
+#include "game/modes/classic_mode.h"
+#include "game/modes/kinarow_mode.h"
+#include "game/modes/recursive_ultimate_mode.h"
+#include "game/modes/score_mode.h"
+#include "game/modes/score_mode_fixed.h"
+#include "game/modes/ultimate_mode.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Depth limits keep the deepest level to well under a second on one core in
+// typical middle games; a free move in Ultimate can take a few seconds.
+constexpr int kClassicDepth = 5;
+constexpr int kScoreDepth = 4;
+constexpr int kUltimateDepth = 7;
+constexpr int kRecursiveUltimateDepth = 2;
+
+// Plain alpha-beta for aiPlayer. leaf(state) values a position, terminal(out,
+// ply) a finished game `ply` moves below the analysed position.
+template <class Mode, class Leaf, class Terminal>
+int minimax(const Mode& state, int aiPlayer, int depth, int ply, int alpha, int beta,
+            const Leaf& leaf, const Terminal& terminal, const std::atomic<bool>& stop) {
+    if (depth <= 0 || stop.load(std::memory_order_relaxed)) return leaf(state);
+
+    const bool maximizing = (state.currentPlayer() == aiPlayer);
+    int best = maximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    bool any = false;
+
+    const int N = state.boardSize();
+    for (int r = 0; r < N && alpha < beta; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+            any = true;
+
+            Mode child = state;
+            const MoveOutcome out = child.applyMove(r, c);
+            const int v = out.finished ? terminal(out, ply + 1)
+                                       : minimax(child, aiPlayer, depth - 1, ply + 1, alpha, beta, leaf, terminal, stop);
+
+            if (maximizing) {
+                best = std::max(best, v);
+                alpha = std::max(alpha, best);
+            } else {
+                best = std::min(best, v);
+                beta = std::min(beta, best);
+            }
+            if (alpha >= beta) break;
+        }
+    }
+
+    return any ? best : leaf(state);
+}
+
+// score(state, move, depth) for the searched modes.
+template <class Mode, class Leaf, class Terminal>
+auto searchedScore(int aiPlayer, Leaf leaf, Terminal terminal, const std::atomic<bool>& stop) {
+    return [=, &stop](const Mode& state, int move, int depth) {
+        const int N = state.boardSize();
+        Mode child = state;
+        const MoveOutcome out = child.applyMove(move / N, move % N);
+        if (out.finished) return terminal(out, 1);
+        return minimax(child, aiPlayer, depth - 1, 1, std::numeric_limits<int>::min(),
+                       std::numeric_limits<int>::max(), leaf, terminal, stop);
+    };
+}
+
+} // namespace
+
+MoveAnalyzer::~MoveAnalyzer() {
+    stop();
+}
+
+void MoveAnalyzer::start(std::unique_ptr<IGameMode> position, int threads,
+                         const UltimateHeuristicParams& ultimateParams) {
+    stop();
+    if (!position || !position->isActive()) return;
+
+    position_ = std::move(position);
+    ultimateParams_ = ultimateParams;
+    const int N = position_->boardSize();
+
+    moves_.clear();
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (position_->isMoveAllowed(r, c)) moves_.push_back(r * N + c);
+        }
+    }
+
+    if (dynamic_cast<const ClassicMode*>(position_.get())) {
+        maxDepth_ = (N <= 3) ? N * N : kClassicDepth;
+    } else if (dynamic_cast<const ScoreMode10x4*>(position_.get()) || dynamic_cast<const ScoreMode*>(position_.get())) {
+        maxDepth_ = kScoreDepth;
+    } else if (dynamic_cast<const UltimateMode*>(position_.get())) {
+        maxDepth_ = kUltimateDepth;
+    } else if (dynamic_cast<const RecursiveUltimateMode*>(position_.get())) {
+        maxDepth_ = kRecursiveUltimateDepth;
+    } else {
+        maxDepth_ = 1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evals_.assign(static_cast<size_t>(N) * N, MoveEval());
+        version_++;
+    }
+
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    threads = std::max(1, std::min(threads, static_cast<int>(moves_.size())));
+
+    next_ = 0;
+    stop_ = false;
+    running_ = threads;
+    for (int i = 0; i < threads; ++i) threads_.emplace_back(&MoveAnalyzer::run, this);
+}
+
+void MoveAnalyzer::stop() {
+    stop_ = true;
+    for (std::thread& t : threads_) t.join();
+    threads_.clear();
+    running_ = 0;
+}
+
+bool MoveAnalyzer::results(std::vector<MoveEval>& out, quint64& version) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version == version_) return false;
+    out = evals_;
+    version = version_;
+    return true;
+}
+
+void MoveAnalyzer::run() {
+    const IGameMode& state = *position_;
+    const int ai = state.currentPlayer();
+
+    if (auto* classic = dynamic_cast<const ClassicMode*>(&state)) {
+        work(*classic, searchedScore<ClassicMode>(
+            ai, [ai](const ClassicMode& s) { return classicLineHeuristic(s, ai); },
+            [ai](const MoveOutcome& out, int ply) { return classicTerminalScore(out.classicWinner, ai, ply); }, stop_));
+    } else if (auto* score = dynamic_cast<const ScoreMode10x4*>(&state)) {
+        work(*score, searchedScore<ScoreMode10x4>(
+            ai, [ai](const ScoreMode10x4& s) { return scoreDiffForPlayer(s.currentScore(), ai); },
+            [ai](const MoveOutcome& out, int) { return scoreDiffForPlayer(out.score, ai); }, stop_));
+    } else if (auto* score = dynamic_cast<const ScoreMode*>(&state)) {
+        work(*score, searchedScore<ScoreMode>(
+            ai, [ai](const ScoreMode& s) { return scoreDiffForPlayer(s.currentScore(), ai); },
+            [ai](const MoveOutcome& out, int) { return scoreDiffForPlayer(out.score, ai); }, stop_));
+    } else if (auto* ultimate = dynamic_cast<const UltimateMode*>(&state)) {
+        work(*ultimate, searchedScore<UltimateMode>(
+            ai, [ai, this](const UltimateMode& s) { return ultimateEvaluate(s, ai, ultimateParams_); },
+            [ai](const MoveOutcome& out, int ply) { return ultimateTerminalScore(out.classicWinner, ai, ply); }, stop_));
+    } else if (auto* recursive = dynamic_cast<const RecursiveUltimateMode*>(&state)) {
+        constexpr int kWin = 1 << 28;
+        work(*recursive, searchedScore<RecursiveUltimateMode>(
+            ai, [ai](const RecursiveUltimateMode& s) { return recursiveUltimateHeuristic(s, ai); },
+            [ai](const MoveOutcome& out, int ply) {
+                return out.classicWinner == 0 ? 0 : (out.classicWinner == ai ? kWin - ply : -kWin + ply);
+            }, stop_));
+    } else if (auto* kinarow = dynamic_cast<const KInARowMode*>(&state)) {
+        work(*kinarow, [ai](const KInARowMode& s, int move, int) {
+            const int N = s.boardSize();
+            const qint64 v = static_cast<qint64>(kInARowCellValue(s, move / N, move % N, ai)) * 4 +
+                             static_cast<qint64>(kInARowCellValue(s, move / N, move % N, -ai)) * 3;
+            return static_cast<int>(std::min<qint64>(v, std::numeric_limits<int>::max()));
+        });
+    }
+
+    running_.fetch_sub(1, std::memory_order_release);
+}
+
+template <class Mode, class Score>
+void MoveAnalyzer::work(const Mode& state, Score score) {
+    const int count = static_cast<int>(moves_.size());
+    const int total = count * maxDepth_;
+
+    for (;;) {
+        if (stop_.load(std::memory_order_relaxed)) return;
+        const int item = next_.fetch_add(1);
+        if (item >= total) return;
+
+        const int depth = 1 + item / count;
+        const int move = moves_[item % count];
+        const int value = score(state, move, depth);
+        if (stop_.load(std::memory_order_relaxed)) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        MoveEval& e = evals_[move];
+        if (depth > e.depth) {
+            e.score = value;
+            e.depth = depth;
+            version_++;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "game/ai/ultimate_params.h"
+#include "game/modes/igame_mode.h"
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct MoveEval {
+    int score = 0;      // for the side to move; larger is better
+    int depth = 0;      // plies behind the score, 0 = not scored yet
+};
+
+// Scores every legal move of a position for the side to move, for the
+// analysis overlay. Each move is valued by a minimax over the same
+// evaluation the computer player uses in that mode (score difference,
+// Ultimate and recursive Ultimate heuristics, Classic open lines; K-in-a-row
+// cells by the computer's own threat value), one depth at a time: all moves
+// at depth 1 first, then all at depth 2, and so on up to the mode's limit.
+// Worker threads take (move, depth) items in that order, so cheap scores
+// arrive at once and are refined as deeper ones come in.
+class MoveAnalyzer {
+public:
+    MoveAnalyzer() = default;
+    ~MoveAnalyzer();
+
+    MoveAnalyzer(const MoveAnalyzer&) = delete;
+    MoveAnalyzer& operator=(const MoveAnalyzer&) = delete;
+
+    // threads <= 0 uses every hardware thread but one. Ultimate positions
+    // are valued with ultimateParams.
+    void start(std::unique_ptr<IGameMode> position, int threads = 0,
+               const UltimateHeuristicParams& ultimateParams = kDefaultUltimateParams);
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire) > 0; }
+
+    // Per-cell results (r * N + c) when they changed since `version`
+    // (updated in place); false and `out` untouched otherwise.
+    bool results(std::vector<MoveEval>& out, quint64& version) const;
+
+private:
+    void run();
+
+    template <class Mode, class Score>
+    void work(const Mode& state, Score score);
+
+private:
+    std::unique_ptr<IGameMode> position_;
+    std::vector<int> moves_;
+    int maxDepth_ = 1;
+    UltimateHeuristicParams ultimateParams_;
+
+    std::vector<std::thread> threads_;
+    std::atomic<int> next_{0};
+    std::atomic<int> running_{0};
+    std::atomic<bool> stop_{false};
+
+    mutable std::mutex mutex_;
+    std::vector<MoveEval> evals_;
+    quint64 version_ = 0;
+};
@@ -0,0 +1,33 @@
+#include "position_code.h"
+
+namespace {
+
+template <class Code>
+quint64 hashWithMode(const Code& code, GameMode mode, int boardSize) {
+    return UltimateBoard::mix64(PositionCodeHash()(code) ^ static_cast<quint64>(mode) ^
+                                static_cast<quint64>(boardSize) << 8);
+}
+
+} // namespace
+
+quint64 positionHash(const IGameMode& state) {
+    if (auto* classic = dynamic_cast<const ClassicMode*>(&state)) {
+        return hashWithMode(encodePosition(*classic), state.mode(), state.boardSize());
+    }
+    if (auto* score = dynamic_cast<const ScoreMode10x4*>(&state)) {
+        return hashWithMode(encodePosition(*score), state.mode(), state.boardSize());
+    }
+    if (auto* score = dynamic_cast<const ScoreMode*>(&state)) {
+        return hashWithMode(encodePosition(*score), state.mode(), state.boardSize());
+    }
+    if (auto* ultimate = dynamic_cast<const UltimateMode*>(&state)) {
+        return hashWithMode(encodePosition(*ultimate), state.mode(), state.boardSize());
+    }
+    if (auto* kinarow = dynamic_cast<const KInARowMode*>(&state)) {
+        return hashWithMode(encodePosition(*kinarow), state.mode(), state.boardSize());
+    }
+    if (auto* recursive = dynamic_cast<const RecursiveUltimateMode*>(&state)) {
+        return hashWithMode(encodePosition(*recursive), state.mode(), state.boardSize());
+    }
+    return 0;
+}
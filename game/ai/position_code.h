@@ -0,0 +1,144 @@
+#pragma once
+
+#include "game/ai/ultimate_board.h"
+#include "game/modes/classic_mode.h"
+#include "game/modes/igame_mode.h"
+#include "game/modes/kinarow_mode.h"
+#include "game/modes/recursive_ultimate_mode.h"
+#include "game/modes/score_mode.h"
+#include "game/modes/score_mode_fixed.h"
+#include "game/modes/ultimate_mode.h"
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <cstring>
+
+// Fixed-width encodings of a position, one per mode. Two positions get the
+// same code exactly when they have the same stones, side to move and rule
+// state (forced board, stripe, score), so a code is a stable key for caches,
+// logs, deduplication and work queues. History that does not change the
+// game from here on is left out: the random stripe generator's state and,
+// in Score, how the totals were reached beyond line score and spend.
+//
+// Classic fits in 32 bits (2 bits per cell, N <= 4); Ultimate reuses
+// UltimateBoard::pack; Score holds two 128-bit bitplanes (N <= 11) plus the
+// score and stripe fields; K-in-a-row two 256-bit bitplanes (N <= 16);
+// recursive Ultimate two 768-bit bitplanes (up to 27x27) with the forced
+// board in the spare bits. The side to move follows from the stone counts
+// wherever X always moves first.
+template <int Words>
+struct PositionCode {
+    static constexpr int kWords = Words;
+
+    quint64 w[Words] = {};
+
+    bool operator==(const PositionCode& o) const { return std::memcmp(w, o.w, sizeof(w)) == 0; }
+    bool operator!=(const PositionCode& o) const { return !(*this == o); }
+
+    quint64 hash() const {
+        quint64 h = 0x9E3779B97F4A7C15ull * Words;
+        for (int i = 0; i < Words; ++i) h = UltimateBoard::mix64(h ^ w[i]);
+        return h;
+    }
+
+    void setBit(int plane, int bit) {
+        w[plane * (Words / 2) + (bit >> 6)] |= static_cast<quint64>(1) << (bit & 63);
+    }
+};
+
+struct PositionCodeHash {
+    template <int Words>
+    size_t operator()(const PositionCode<Words>& code) const { return static_cast<size_t>(code.hash()); }
+    size_t operator()(quint32 code) const { return static_cast<size_t>(UltimateBoard::mix64(code)); }
+};
+
+using ClassicCode = quint32;
+using UltimateCode = PositionCode<3>;
+using ScoreCode = PositionCode<6>;
+using KInARowCode = PositionCode<8>;
+using RecursiveUltimateCode = PositionCode<24>;
+
+inline ClassicCode encodePosition(const ClassicMode& state) {
+    const int N = state.boardSize();
+    ClassicCode code = 0;
+    for (int i = 0; i < N * N; ++i) {
+        const int owner = state.cellOwner(i / N, i % N);
+        if (owner != 0) code |= static_cast<ClassicCode>(owner == 1 ? 1 : 2) << (2 * i);
+    }
+    return code;
+}
+
+inline UltimateCode encodePosition(const UltimateMode& state) {
+    UltimateCode code;
+    UltimateBoard::fromMode(state).pack(code.w);
+    return code;
+}
+
+namespace detail {
+
+template <class Mode>
+ScoreCode encodeScore(const Mode& state) {
+    ScoreCode code;
+    const int N = state.boardSize();
+    for (int i = 0; i < N * N && i < 128; ++i) {
+        const int owner = state.cellOwner(i / N, i % N);
+        if (owner == 1) code.setBit(0, i);
+        else if (owner == -1) code.setBit(1, i);
+    }
+
+    const ScoreSnapshot s = state.currentScore();
+    code.w[4] = static_cast<quint64>(static_cast<quint16>(s.xLine)) |
+                static_cast<quint64>(static_cast<quint16>(s.oLine)) << 16 |
+                static_cast<quint64>(static_cast<quint16>(s.xSpent)) << 32 |
+                static_cast<quint64>(static_cast<quint16>(s.oSpent)) << 48;
+    code.w[5] = static_cast<quint64>(state.activeRow() + 1) |
+                static_cast<quint64>(state.activeCol() + 1) << 8 |
+                static_cast<quint64>(state.fillMode()) << 16 |
+                static_cast<quint64>(state.isActive() ? 1 : 0) << 24;
+    return code;
+}
+
+} // namespace detail
+
+inline ScoreCode encodePosition(const ScoreMode& state) {
+    return detail::encodeScore(state);
+}
+
+template <int N, int L>
+ScoreCode encodePosition(const ScoreModeT<N, L>& state) {
+    static_assert(N * N <= 128, "Score codes hold boards up to 11x11");
+    return detail::encodeScore(state);
+}
+
+inline KInARowCode encodePosition(const KInARowMode& state) {
+    KInARowCode code;
+    const int N = state.boardSize();
+    for (int i = 0; i < N * N; ++i) {
+        const int owner = state.cellOwner(i / N, i % N);
+        if (owner == 1) code.setBit(0, i);
+        else if (owner == -1) code.setBit(1, i);
+    }
+    return code;
+}
+
+// The forced board goes above cell 729 in the O plane: level + 1 in 3 bits,
+// then the board index.
+inline RecursiveUltimateCode encodePosition(const RecursiveUltimateMode& state) {
+    RecursiveUltimateCode code;
+    const int N = state.boardSize();
+    for (int i = 0; i < N * N; ++i) {
+        const int owner = state.cellOwner(i / N, i % N);
+        if (owner == 1) code.setBit(0, i);
+        else if (owner == -1) code.setBit(1, i);
+    }
+
+    const quint64 forced = static_cast<quint64>(state.forcedLevel() + 1) |
+                           static_cast<quint64>(state.forcedIndex() + 1) << 3;
+    code.w[RecursiveUltimateCode::kWords - 1] |= forced << (729 - 11 * 64);
+    return code;
+}
+
+// Hash of any mode's code, for callers holding an IGameMode. The mode is
+// mixed in so equal bit patterns from different modes do not collide.
+quint64 positionHash(const IGameMode& state);
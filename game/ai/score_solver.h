@@ -0,0 +1,199 @@
+#pragma once
+
+#include "game/ai/search_progress.h"
+#include "game/modes/igame_mode.h"
+#include "game/score/score_helpers.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+struct ScoreSolverLimits {
+    int maxMillis = 300;
+    const std::atomic<bool>* cancel = nullptr;  // checked with the clock
+};
+
+// Exact solver for the last few moves of a Score game. It maximises the final
+// total difference for the side to move. Values are "gain from here on": the
+// immediate change in the mover's total minus the opponent's best gain after
+// it. That gain depends only on the stones on the board and the stripe, not on
+// the score so far, so the transposition table is keyed by a Zobrist hash of
+// the board plus the active row/column.
+//
+// Only meaningful for deterministic fill modes. With random stripes the next
+// stripe comes from the mode's seeded generator, whose state every copy
+// carries: a search would read the future draws it cannot know in a real
+// game, and the value of a subtree would depend on the generator state,
+// which the table key leaves out.
+template <class Mode>
+class ScoreEndgameSolver {
+public:
+    explicit ScoreEndgameSolver(int tableBits = 16) {
+        table_.resize(static_cast<size_t>(1) << tableBits);
+        mask_ = (static_cast<quint64>(1) << tableBits) - 1;
+    }
+
+    // Returns false when the time budget ran out before the search finished.
+    bool solve(const Mode& root, const ScoreSolverLimits& limits, int& outR, int& outC, int& outGain) {
+        const int N = root.boardSize();
+        buildZobrist(N);
+
+        quint64 key = 0;
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                const int owner = root.cellOwner(r, c);
+                if (owner != 0) key ^= zobrist_[(r * N + c) * 2 + (owner == 1 ? 0 : 1)];
+            }
+        }
+
+        nodes_ = 0;
+        aborted_ = false;
+        cancel_ = limits.cancel;
+        deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.maxMillis);
+
+        int best = -1;
+        const int gain = search(root, key, -kInf, kInf, &best);
+        if (aborted_ || best < 0) return false;
+
+        outR = best / N;
+        outC = best % N;
+        outGain = gain;
+        return true;
+    }
+
+    qint64 nodes() const { return nodes_; }
+
+    // Node counts are posted here on every time check while solving.
+    void setProgress(SearchProgressChannel* progress) { progress_ = progress; }
+
+private:
+    static constexpr int kInf = 1 << 28;
+
+    enum Bound : quint8 { Empty = 0, Exact = 1, Lower = 2, Upper = 3 };
+
+    struct Entry {
+        quint64 key = 0;
+        int value = 0;
+        int move = -1;
+        Bound bound = Empty;
+    };
+
+    struct Child {
+        int move;
+        int immediate;
+    };
+
+    void buildZobrist(int N) {
+        const size_t size = static_cast<size_t>(N) * N * 2;
+        if (zobrist_.size() == size) return;
+
+        zobrist_.resize(size);
+        quint64 z = 0x243F6A8885A308D3ull;
+        for (size_t i = 0; i < size; ++i) {
+            z += 0x9E3779B97F4A7C15ull;
+            quint64 v = z;
+            v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ull;
+            v = (v ^ (v >> 27)) * 0x94D049BB133111EBull;
+            zobrist_[i] = v ^ (v >> 31);
+        }
+    }
+
+    static quint64 stripeKey(const Mode& state) {
+        return (static_cast<quint64>(state.activeRow() + 1) << 8 | static_cast<quint64>(state.activeCol() + 1))
+               * 0xD6E8FEB86659FD93ull;
+    }
+
+    bool outOfTime() {
+        if (aborted_) return true;
+        ++nodes_;
+        if ((nodes_ & 1023) == 0) {
+            if (std::chrono::steady_clock::now() > deadline_ || searchCancelled(cancel_)) aborted_ = true;
+            if (progress_) progress_->post(0, -1, -1, 0, nodes_);
+        }
+        return aborted_;
+    }
+
+    int search(const Mode& state, quint64 boardKey, int alpha, int beta, int* bestMove) {
+        if (outOfTime()) return 0;
+
+        const int N = state.boardSize();
+        const int me = state.currentPlayer();
+        const quint64 key = boardKey ^ stripeKey(state);
+
+        Entry& e = table_[key & mask_];
+        int ttMove = -1;
+        if (e.bound != Empty && e.key == key) {
+            ttMove = e.move;
+            if (!bestMove) {
+                if (e.bound == Exact) return e.value;
+                if (e.bound == Lower && e.value > alpha) alpha = e.value;
+                if (e.bound == Upper && e.value < beta) beta = e.value;
+                if (alpha >= beta) return e.value;
+            }
+        }
+
+        // The immediate gain of every move comes from one batched what-if
+        // pass; a child position is only built when the move is searched.
+        std::vector<ScoreMoveDelta> deltas;
+        state.moveDeltas(deltas);
+
+        std::vector<Child> children;
+        children.reserve(N * N);
+        for (int idx = 0; idx < N * N; ++idx) {
+            if (deltas[idx].legal) children.push_back(Child{idx, deltas[idx].net()});
+        }
+
+        if (children.empty()) return 0;
+
+        std::stable_sort(children.begin(), children.end(), [ttMove](const Child& a, const Child& b) {
+            if ((a.move == ttMove) != (b.move == ttMove)) return a.move == ttMove;
+            return a.immediate > b.immediate;
+        });
+
+        const bool last = state.movesLeft() <= 1;
+        const int alpha0 = alpha;
+        int best = -kInf;
+        int bestMv = -1;
+
+        for (const Child& ch : children) {
+            int v = ch.immediate;
+            if (!last) {
+                Mode child = state;
+                child.applyMove(ch.move / N, ch.move % N);
+                const quint64 childKey = boardKey ^ zobrist_[ch.move * 2 + (me == 1 ? 0 : 1)];
+                v -= search(child, childKey, ch.immediate - beta, ch.immediate - alpha, nullptr);
+                if (aborted_) return 0;
+            }
+
+            if (v > best) {
+                best = v;
+                bestMv = ch.move;
+            }
+            if (v > alpha) alpha = v;
+            if (alpha >= beta) break;
+        }
+
+        e.key = key;
+        e.value = best;
+        e.move = bestMv;
+        if (best <= alpha0) e.bound = Upper;
+        else if (best >= beta) e.bound = Lower;
+        else e.bound = Exact;
+
+        if (bestMove) *bestMove = bestMv;
+        return best;
+    }
+
+private:
+    std::vector<Entry> table_;
+    quint64 mask_ = 0;
+    std::vector<quint64> zobrist_;
+
+    SearchProgressChannel* progress_ = nullptr;
+    qint64 nodes_ = 0;
+    bool aborted_ = false;
+    const std::atomic<bool>* cancel_ = nullptr;
+    std::chrono::steady_clock::time_point deadline_;
+};
@@ -0,0 +1,727 @@
+#pragma once
+
+#include "game/modes/igame_mode.h"
+#include "game/modes/ultimate_mode.h"
+#include "game/ai/search_progress.h"
+#include "game/ai/symmetry.h"
+#include "game/ai/ultimate_params.h"
+#include "game/score/score_helpers.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Search routines shared by every mode. They are templates over the concrete
+// mode type so that cellOwner/isMoveAllowed/applyMove resolve statically and
+// children are plain value copies instead of clone() allocations. The move
+// pickers take an optional progress channel and post to it after each root
+// move, and an optional cancel flag; once it is set they return false.
+
+inline int scoreDiffForPlayer(const ScoreSnapshot& s, int player) {
+    return (player == 1) ? (s.xTotal - s.oTotal) : (s.oTotal - s.xTotal);
+}
+
+inline int classicTerminalScore(int winner, int aiPlayer, int depth) {
+    if (winner == 0) return 0;
+    if (winner == aiPlayer) return 1000 - depth;
+    return -1000 + depth;
+}
+
+// Used when the depth limit cuts a Classic search short (boards above 3x3
+// without a tablebase): lines still open for one side only, weighted by the
+// square of their stone count.
+template <class Mode>
+int classicLineHeuristic(const Mode& state, int aiPlayer) {
+    const int N = state.boardSize();
+    int score = 0;
+
+    auto addLine = [&](int r0, int c0, int dr, int dc) {
+        int mine = 0, theirs = 0;
+        for (int k = 0; k < N; ++k) {
+            const int owner = state.cellOwner(r0 + k * dr, c0 + k * dc);
+            if (owner == aiPlayer) mine++;
+            else if (owner == -aiPlayer) theirs++;
+        }
+        if (theirs == 0) score += mine * mine;
+        if (mine == 0) score -= theirs * theirs;
+    };
+
+    for (int i = 0; i < N; ++i) {
+        addLine(i, 0, 0, 1);
+        addLine(0, i, 1, 0);
+    }
+    addLine(0, 0, 1, 1);
+    addLine(0, N - 1, 1, -1);
+
+    return score;
+}
+
+// Values are cached per search under the symmetry-canonical board. A position
+// is always reached at the same depth within one search, so the cached value
+// is exact. Past maxDepth the line heuristic stands in for the subtree.
+using ClassicMemo = std::unordered_map<quint64, int>;
+
+template <class Mode>
+int classicMinimaxValue(const Mode& state, int aiPlayer, int depth, int maxDepth, ClassicMemo& memo,
+                        const std::atomic<bool>* cancel = nullptr) {
+    if (depth > maxDepth) return classicLineHeuristic(state, aiPlayer);
+    if (searchCancelled(cancel)) return 0;
+
+    const quint64 key = classicCanonicalKey(state);
+    auto cached = memo.find(key);
+    if (cached != memo.end()) return cached->second;
+
+    const bool maximizing = (state.currentPlayer() == aiPlayer);
+    const unsigned sym = symmetryMask(state);
+
+    int best = maximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    bool any = false;
+
+    const int N = state.boardSize();
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+            any = true;
+            if (isSymmetricDuplicate(sym, N, r, c)) continue;
+
+            Mode child = state;
+            MoveOutcome out = child.applyMove(r, c);
+
+            int val = 0;
+            if (out.finished) {
+                val = classicTerminalScore(out.classicWinner, aiPlayer, depth);
+            } else {
+                val = classicMinimaxValue(child, aiPlayer, depth + 1, maxDepth, memo, cancel);
+            }
+
+            if (maximizing) {
+                if (val > best) best = val;
+            } else {
+                if (val < best) best = val;
+            }
+        }
+    }
+
+    if (!any) best = 0;
+    // A cancelled subtree's value is meaningless; keep it out of the memo.
+    if (!searchCancelled(cancel)) memo.emplace(key, best);
+    return best;
+}
+
+template <class Mode>
+bool pickBestClassicMove(const Mode& state, int aiPlayer, int& outR, int& outC,
+                         int maxDepth = std::numeric_limits<int>::max(),
+                         SearchProgressChannel* progress = nullptr, const std::atomic<bool>* cancel = nullptr) {
+    int bestVal = std::numeric_limits<int>::min();
+    bool found = false;
+
+    ClassicMemo memo;
+    const unsigned sym = symmetryMask(state);
+
+    const int N = state.boardSize();
+    const int depth = std::min(maxDepth, N * N - state.movesMade());
+    qint64 rootMoves = 0;
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+            if (isSymmetricDuplicate(sym, N, r, c)) continue;
+
+            Mode child = state;
+            MoveOutcome out = child.applyMove(r, c);
+
+            int val = 0;
+            if (out.finished) {
+                val = classicTerminalScore(out.classicWinner, aiPlayer, 1);
+            } else {
+                val = classicMinimaxValue(child, aiPlayer, 2, maxDepth, memo, cancel);
+            }
+            if (searchCancelled(cancel)) return false;
+
+            if (!found || val > bestVal) {
+                found = true;
+                bestVal = val;
+                outR = r;
+                outC = c;
+            }
+
+            // Distinct positions valued so far stand in for nodes.
+            if (progress) progress->post(depth, outR, outC, bestVal, static_cast<qint64>(memo.size()) + ++rootMoves);
+        }
+    }
+
+    return found;
+}
+
+// The opponent's reply only changes the opponent's total, so its best reply
+// is read off the batched what-if deltas of the position after our move
+// instead of playing every reply out.
+template <class Mode>
+bool pickBestScoreMoveDepth2(const Mode& state, int aiPlayer, int& outR, int& outC,
+                             int* outValue = nullptr, SearchProgressChannel* progress = nullptr,
+                             const std::atomic<bool>* cancel = nullptr) {
+    int bestVal = std::numeric_limits<int>::min();
+    bool found = false;
+    qint64 nodes = 0;
+
+    const int N = state.boardSize();
+    std::vector<ScoreMoveDelta> replies;
+
+    // Stripes drawn after our move must not be the ones the game will draw.
+    Mode root = state;
+    root.reseedForSearch();
+
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+            if (searchCancelled(cancel)) return false;
+
+            Mode afterMe = root;
+            MoveOutcome out1 = afterMe.applyMove(r, c);
+            nodes++;
+
+            int val = scoreDiffForPlayer(out1.score, aiPlayer);
+            if (!out1.finished) {
+                afterMe.moveDeltas(replies);
+
+                int bestReply = std::numeric_limits<int>::min();
+                for (const ScoreMoveDelta& d : replies) {
+                    if (!d.legal) continue;
+                    nodes++;
+                    bestReply = std::max(bestReply, d.net());
+                }
+                if (bestReply != std::numeric_limits<int>::min()) val -= bestReply;
+            }
+
+            if (!found || val > bestVal) {
+                found = true;
+                bestVal = val;
+                outR = r;
+                outC = c;
+            }
+            if (progress) progress->post(2, outR, outC, bestVal, nodes);
+        }
+    }
+
+    if (found && outValue) *outValue = bestVal;
+    return found;
+}
+
+inline int ultimateTerminalScore(int winner, int aiPlayer, int depth) {
+    if (winner == 0) return 0;
+    if (winner == aiPlayer) return 100000 - depth;
+    return -100000 + depth;
+}
+
+template <class Mode>
+int localWinner9(const Mode& state, int br, int bc) {
+    auto at = [&](int rr, int cc) -> int {
+        return state.cellOwner(br * 3 + rr, bc * 3 + cc);
+    };
+
+    for (int r = 0; r < 3; ++r) {
+        int s = at(r, 0) + at(r, 1) + at(r, 2);
+        if (s == 3) return 1;
+        if (s == -3) return -1;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        int s = at(0, c) + at(1, c) + at(2, c);
+        if (s == 3) return 1;
+        if (s == -3) return -1;
+    }
+
+    int d1 = at(0, 0) + at(1, 1) + at(2, 2);
+    int d2 = at(0, 2) + at(1, 1) + at(2, 0);
+
+    if (d1 == 3 || d2 == 3) return 1;
+    if (d1 == -3 || d2 == -3) return -1;
+
+    return 0;
+}
+
+template <class Mode>
+bool localFull9(const Mode& state, int br, int bc) {
+    for (int rr = 0; rr < 3; ++rr) {
+        for (int cc = 0; cc < 3; ++cc) {
+            if (state.cellOwner(br * 3 + rr, bc * 3 + cc) == 0) return false;
+        }
+    }
+    return true;
+}
+
+inline int macroWinner9(const int localState[9]) {
+    auto v = [&](int r, int c) -> int {
+        const int idx = r * 3 + c;
+        const int s = localState[idx];
+        if (s == 2) return 0;
+        return s;
+    };
+
+    for (int r = 0; r < 3; ++r) {
+        int s = v(r, 0) + v(r, 1) + v(r, 2);
+        if (s == 3) return 1;
+        if (s == -3) return -1;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        int s = v(0, c) + v(1, c) + v(2, c);
+        if (s == 3) return 1;
+        if (s == -3) return -1;
+    }
+
+    int d1 = v(0, 0) + v(1, 1) + v(2, 2);
+    int d2 = v(0, 2) + v(1, 1) + v(2, 0);
+
+    if (d1 == 3 || d2 == 3) return 1;
+    if (d1 == -3 || d2 == -3) return -1;
+
+    return 0;
+}
+
+// Signed counts of the UltimateHeuristicParams terms for aiPlayer, into
+// terms[kTerms]. Returns 1 or -1 instead when the macro board is already won
+// for or against aiPlayer, 0 otherwise.
+template <class Mode>
+int ultimateHeuristicTerms(const Mode& state, int aiPlayer, int* terms) {
+    using P = UltimateHeuristicParams;
+    int localState[9];
+
+    for (int br = 0; br < 3; ++br) {
+        for (int bc = 0; bc < 3; ++bc) {
+            const int idx = br * 3 + bc;
+            const int w = localWinner9(state, br, bc);
+            if (w != 0) localState[idx] = w;
+            else if (localFull9(state, br, bc)) localState[idx] = 2;
+            else localState[idx] = 0;
+        }
+    }
+
+    const int mw = macroWinner9(localState);
+    if (mw != 0) return (mw == aiPlayer) ? 1 : -1;
+
+    for (int t = 0; t < P::kTerms; ++t) terms[t] = 0;
+
+    for (int i = 0; i < 9; ++i) {
+        if (localState[i] == aiPlayer) terms[P::LocalWon]++;
+        else if (localState[i] == -aiPlayer) terms[P::LocalLost]--;
+    }
+
+    const int macroLines[8][3] = {
+        {0,1,2},{3,4,5},{6,7,8},
+        {0,3,6},{1,4,7},{2,5,8},
+        {0,4,8},{2,4,6}
+    };
+
+    for (int k = 0; k < 8; ++k) {
+        int sum = 0;
+        int empties = 0;
+        int blocked = 0;
+        for (int j = 0; j < 3; ++j) {
+            const int idx = macroLines[k][j];
+            if (localState[idx] == 2) {
+                blocked++;
+                continue;
+            }
+            sum += localState[idx];
+            if (localState[idx] == 0) empties++;
+        }
+
+        if (blocked == 0) {
+            if (sum == 2 * aiPlayer && empties == 1) terms[P::MacroTwo]++;
+            if (sum == -2 * aiPlayer && empties == 1) terms[P::MacroTwoAgainst]--;
+            if (sum == aiPlayer && empties == 2) terms[P::MacroOne]++;
+            if (sum == -aiPlayer && empties == 2) terms[P::MacroOneAgainst]--;
+        } else {
+            if (sum == 2 * aiPlayer && empties == 1) terms[P::BlockedTwo]++;
+            if (sum == -2 * aiPlayer && empties == 1) terms[P::BlockedTwoAgainst]--;
+            if (sum == aiPlayer && empties == 2) terms[P::BlockedOne]++;
+            if (sum == -aiPlayer && empties == 2) terms[P::BlockedOneAgainst]--;
+        }
+    }
+
+    for (int br = 0; br < 3; ++br) {
+        for (int bc = 0; bc < 3; ++bc) {
+            const int idx = br * 3 + bc;
+            if (localState[idx] != 0) continue;
+
+            auto at = [&](int rr, int cc) -> int {
+                return state.cellOwner(br * 3 + rr, bc * 3 + cc);
+            };
+
+            for (int r = 0; r < 3; ++r) {
+                int a = at(r, 0), b = at(r, 1), c = at(r, 2);
+                int sum = a + b + c;
+                int empty = (a == 0) + (b == 0) + (c == 0);
+                if (sum == 2 * aiPlayer && empty == 1) terms[P::LocalTwo]++;
+                if (sum == -2 * aiPlayer && empty == 1) terms[P::LocalTwoAgainst]--;
+                if (sum == aiPlayer && empty == 2) terms[P::LocalOne]++;
+                if (sum == -aiPlayer && empty == 2) terms[P::LocalOneAgainst]--;
+            }
+
+            for (int c = 0; c < 3; ++c) {
+                int a = at(0, c), b = at(1, c), d = at(2, c);
+                int sum = a + b + d;
+                int empty = (a == 0) + (b == 0) + (d == 0);
+                if (sum == 2 * aiPlayer && empty == 1) terms[P::LocalTwo]++;
+                if (sum == -2 * aiPlayer && empty == 1) terms[P::LocalTwoAgainst]--;
+                if (sum == aiPlayer && empty == 2) terms[P::LocalOne]++;
+                if (sum == -aiPlayer && empty == 2) terms[P::LocalOneAgainst]--;
+            }
+
+            {
+                int a = at(0, 0), b = at(1, 1), c = at(2, 2);
+                int sum = a + b + c;
+                int empty = (a == 0) + (b == 0) + (c == 0);
+                if (sum == 2 * aiPlayer && empty == 1) terms[P::LocalTwo]++;
+                if (sum == -2 * aiPlayer && empty == 1) terms[P::LocalTwoAgainst]--;
+                if (sum == aiPlayer && empty == 2) terms[P::LocalOne]++;
+                if (sum == -aiPlayer && empty == 2) terms[P::LocalOneAgainst]--;
+            }
+
+            {
+                int a = at(0, 2), b = at(1, 1), c = at(2, 0);
+                int sum = a + b + c;
+                int empty = (a == 0) + (b == 0) + (c == 0);
+                if (sum == 2 * aiPlayer && empty == 1) terms[P::LocalTwo]++;
+                if (sum == -2 * aiPlayer && empty == 1) terms[P::LocalTwoAgainst]--;
+                if (sum == aiPlayer && empty == 2) terms[P::LocalOne]++;
+                if (sum == -aiPlayer && empty == 2) terms[P::LocalOneAgainst]--;
+            }
+        }
+    }
+
+    if (localState[4] == aiPlayer) terms[P::CentreWon]++;
+    else if (localState[4] == -aiPlayer) terms[P::CentreLost]--;
+
+    return 0;
+}
+
+template <class Mode>
+int ultimateHeuristic(const Mode& state, int aiPlayer,
+                      const UltimateHeuristicParams& params = kDefaultUltimateParams) {
+    int terms[UltimateHeuristicParams::kTerms];
+    const int decided = ultimateHeuristicTerms(state, aiPlayer, terms);
+    if (decided != 0) return decided * 90000;
+    return params.evaluate(terms);
+}
+
+// Leaf value of an Ultimate position: the attached network when there is
+// one, the hand-written heuristic otherwise.
+template <class Mode>
+int ultimateEvaluate(const Mode& state, int aiPlayer, const UltimateHeuristicParams& params) {
+    return ultimateHeuristic(state, aiPlayer, params);
+}
+
+inline int ultimateEvaluate(const UltimateMode& state, int aiPlayer, const UltimateHeuristicParams& params) {
+    if (state.network()) return aiPlayer * state.networkScore();
+    return ultimateHeuristic(state, aiPlayer, params);
+}
+
+// Symmetric moves may be pruned only when ultimateEvaluate gives mirrored
+// positions the same value. The heuristic does; the network reads cells by
+// position and does not, so it turns the pruning off (mask 1 = identity).
+template <class Mode>
+unsigned ultimateSymmetryMask(const Mode& state) {
+    return symmetryMask(state);
+}
+
+inline unsigned ultimateSymmetryMask(const UltimateMode& state) {
+    return state.network() ? 1u : symmetryMask(state);
+}
+
+template <class Mode>
+bool pickBestUltimateMoveDepth2(const Mode& state, int aiPlayer, int& outR, int& outC,
+                                int* outValue = nullptr, SearchProgressChannel* progress = nullptr,
+                                const UltimateHeuristicParams& params = kDefaultUltimateParams,
+                                const std::atomic<bool>* cancel = nullptr) {
+    int bestVal = std::numeric_limits<int>::min();
+    bool found = false;
+    qint64 nodes = 0;
+
+    const int N = state.boardSize();
+    const unsigned sym = ultimateSymmetryMask(state);
+
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!state.isMoveAllowed(r, c)) continue;
+            if (isSymmetricDuplicate(sym, N, r, c)) continue;
+            if (searchCancelled(cancel)) return false;
+
+            Mode afterMe = state;
+            MoveOutcome out1 = afterMe.applyMove(r, c);
+            nodes++;
+
+            int val = 0;
+            if (out1.finished) {
+                val = ultimateTerminalScore(out1.classicWinner, aiPlayer, 1);
+            } else {
+                int worstForMe = std::numeric_limits<int>::max();
+                bool oppFound = false;
+                const unsigned oppSym = ultimateSymmetryMask(afterMe);
+
+                for (int rr = 0; rr < N; ++rr) {
+                    for (int cc = 0; cc < N; ++cc) {
+                        if (!afterMe.isMoveAllowed(rr, cc)) continue;
+
+                        oppFound = true;
+                        if (isSymmetricDuplicate(oppSym, N, rr, cc)) continue;
+                        Mode afterOpp = afterMe;
+                        MoveOutcome out2 = afterOpp.applyMove(rr, cc);
+                        nodes++;
+
+                        int d = 0;
+                        if (out2.finished) {
+                            d = ultimateTerminalScore(out2.classicWinner, aiPlayer, 2);
+                        } else {
+                            d = ultimateEvaluate(afterOpp, aiPlayer, params);
+                        }
+
+                        if (d < worstForMe) worstForMe = d;
+                    }
+                }
+
+                val = oppFound ? worstForMe : ultimateEvaluate(afterMe, aiPlayer, params);
+            }
+
+            if (!found || val > bestVal) {
+                found = true;
+                bestVal = val;
+                outR = r;
+                outC = c;
+            }
+            if (progress) progress->post(2, outR, outC, bestVal, nodes);
+        }
+    }
+
+    if (found && outValue) *outValue = bestVal;
+    return found;
+}
+
+// K-in-a-row: one-ply threat scoring over the mode's neighbourhood
+// candidates. A cell is valued by the lines through it for the mover
+// (attack) and for the opponent (the threat it blocks); each line costs
+// O(K), so a move choice costs O(candidates * K).
+constexpr int kKInARowWin = 1 << 24;
+
+inline int kInARowLineValue(int missing, int openEnds) {
+    static const int values[4][2] = {
+        { 20000, 200000 },
+        { 1500, 15000 },
+        { 150, 800 },
+        { 8, 30 },
+    };
+    if (openEnds == 0) return 0;
+    const int row = (missing < 1) ? 0 : (missing > 4 ? 3 : missing - 1);
+    return values[row][openEnds - 1];
+}
+
+template <class Mode>
+int kInARowCellValue(const Mode& state, int r, int c, int player) {
+    static const int dirs[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+    const int N = state.boardSize();
+    const int K = state.winLine();
+
+    auto inside = [N](int rr, int cc) { return rr >= 0 && cc >= 0 && rr < N && cc < N; };
+
+    // Cells up to K - 1 steps away that the opponent does not hold.
+    auto room = [&](int dr, int dc) {
+        int n = 0;
+        for (int k = 1; k < K; ++k) {
+            const int rr = r + k * dr;
+            const int cc = c + k * dc;
+            if (!inside(rr, cc) || state.cellOwner(rr, cc) == -player) break;
+            n++;
+        }
+        return n;
+    };
+
+    int total = 0;
+    for (const auto& d : dirs) {
+        const int fwd = state.runFrom(r, c, d[0], d[1], player, K - 1);
+        const int back = state.runFrom(r, c, -d[0], -d[1], player, K - 1);
+        const int run = 1 + fwd + back;
+        if (run >= K) return kKInARowWin;
+
+        if (1 + room(d[0], d[1]) + room(-d[0], -d[1]) < K) continue;
+
+        const int fr = r + (fwd + 1) * d[0], fc = c + (fwd + 1) * d[1];
+        const int br = r - (back + 1) * d[0], bc = c - (back + 1) * d[1];
+        const int open = (inside(fr, fc) && state.cellOwner(fr, fc) == 0 ? 1 : 0) +
+                         (inside(br, bc) && state.cellOwner(br, bc) == 0 ? 1 : 0);
+        total += kInARowLineValue(K - run, open);
+    }
+    return total;
+}
+
+template <class Mode>
+bool pickBestKInARowMove(const Mode& state, int aiPlayer, int& outR, int& outC,
+                         SearchProgressChannel* progress = nullptr) {
+    const int N = state.boardSize();
+    const auto& candidates = state.candidates();
+
+    if (candidates.isEmpty()) {
+        const int mid = N / 2;
+        if (state.isMoveAllowed(mid, mid)) {
+            outR = mid;
+            outC = mid;
+            return true;
+        }
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                if (!state.isMoveAllowed(r, c)) continue;
+                outR = r;
+                outC = c;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int block = -1;
+    int best = -1;
+    qint64 bestVal = -1;
+
+    for (int idx : candidates) {
+        const int r = idx / N;
+        const int c = idx % N;
+
+        const int attack = kInARowCellValue(state, r, c, aiPlayer);
+        if (attack >= kKInARowWin) {
+            outR = r;
+            outC = c;
+            return true;
+        }
+
+        const int defence = kInARowCellValue(state, r, c, -aiPlayer);
+        if (defence >= kKInARowWin && block < 0) block = idx;
+
+        const qint64 val = static_cast<qint64>(attack) * 4 + static_cast<qint64>(defence) * 3;
+        if (val > bestVal || (val == bestVal && idx < best)) {
+            bestVal = val;
+            best = idx;
+        }
+    }
+
+    const int pick = (block >= 0) ? block : best;
+    outR = pick / N;
+    outC = pick % N;
+    if (progress) progress->post(1, outR, outC, static_cast<int>(std::min<qint64>(bestVal, kKInARowWin)), candidates.size());
+    return true;
+}
+
+// Recursive Ultimate: every open board at every level is scored by its 3x3
+// lines, a line counting only while the other side holds none of its squares
+// and none of them is drawn. A level-j board weighs 8^(j-1), so one square
+// taken higher up outweighs everything happening inside it.
+template <class Mode>
+int recursiveUltimateHeuristic(const Mode& state, int aiPlayer) {
+    static const quint16 lines[8] = { 0007, 0070, 0700, 0111, 0222, 0444, 0421, 0124 };
+    static const int lineValue[3] = { 0, 1, 6 };
+
+    int score = 0;
+    int weight = 1;
+    for (int level = 1; level <= state.levels(); ++level, weight *= 8) {
+        const int boards = state.sideAt(level) * state.sideAt(level);
+        for (int idx = 0; idx < boards; ++idx) {
+            if (state.boardState(level, idx) != 0) continue;
+
+            const quint16 mine = state.wonMask(level, idx, aiPlayer);
+            const quint16 theirs = state.wonMask(level, idx, -aiPlayer);
+            const quint16 drawn = state.closedMask(level, idx) & ~(mine | theirs);
+
+            int local = 0;
+            for (quint16 line : lines) {
+                if (line & drawn) continue;
+                const int m = qPopulationCount(static_cast<quint16>(mine & line));
+                const int t = qPopulationCount(static_cast<quint16>(theirs & line));
+                if (t == 0) local += lineValue[m];
+                else if (m == 0) local -= lineValue[t];
+            }
+            score += local * weight;
+        }
+    }
+    return score;
+}
+
+// Calls fn(r, c) for every legal move, walking only the target board when
+// the move is forced.
+template <class Mode, class Fn>
+void forEachRecursiveUltimateMove(const Mode& state, Fn fn) {
+    int r0 = 0, c0 = 0, span = state.boardSize();
+    if (state.forcedLevel() > 0) {
+        span = 1;
+        for (int j = 0; j < state.forcedLevel(); ++j) span *= 3;
+        r0 = state.activeRow() * span;
+        c0 = state.activeCol() * span;
+    }
+
+    for (int r = r0; r < r0 + span; ++r) {
+        for (int c = c0; c < c0 + span; ++c) {
+            if (state.isMoveAllowed(r, c)) fn(r, c);
+        }
+    }
+}
+
+// One ply plus the reply when the reply is confined to a board of level 2 or
+// below (at most 81 cells); a wider target for the opponent is scored
+// statically with a penalty instead of being searched.
+template <class Mode>
+bool pickBestRecursiveUltimateMove(const Mode& state, int aiPlayer, int& outR, int& outC,
+                                   SearchProgressChannel* progress = nullptr,
+                                   const std::atomic<bool>* cancel = nullptr) {
+    constexpr int kWin = 1 << 28;
+    constexpr int kWideReplyPenalty = 64;
+
+    const int N = state.boardSize();
+    if (state.movesMade() == 0 && state.isMoveAllowed(N / 2, N / 2)) {
+        outR = N / 2;
+        outC = N / 2;
+        return true;
+    }
+
+    int bestVal = std::numeric_limits<int>::min();
+    bool found = false;
+    qint64 nodes = 0;
+
+    forEachRecursiveUltimateMove(state, [&](int r, int c) {
+        if (searchCancelled(cancel)) return;
+        Mode afterMe = state;
+        const MoveOutcome out1 = afterMe.applyMove(r, c);
+        nodes++;
+
+        int val = 0;
+        if (out1.finished) {
+            val = (out1.classicWinner == aiPlayer) ? kWin : (out1.classicWinner == 0 ? 0 : -kWin);
+        } else if (afterMe.forcedLevel() > 0 && afterMe.forcedLevel() <= 2) {
+            int worst = std::numeric_limits<int>::max();
+            forEachRecursiveUltimateMove(afterMe, [&](int rr, int cc) {
+                Mode afterOpp = afterMe;
+                const MoveOutcome out2 = afterOpp.applyMove(rr, cc);
+                nodes++;
+                int d = 0;
+                if (out2.finished) {
+                    d = (out2.classicWinner == aiPlayer) ? kWin - 1 : (out2.classicWinner == 0 ? 0 : -kWin + 1);
+                } else {
+                    d = recursiveUltimateHeuristic(afterOpp, aiPlayer);
+                }
+                if (d < worst) worst = d;
+            });
+            val = worst;
+        } else {
+            val = recursiveUltimateHeuristic(afterMe, aiPlayer) - kWideReplyPenalty;
+        }
+
+        if (!found || val > bestVal) {
+            found = true;
+            bestVal = val;
+            outR = r;
+            outC = c;
+        }
+        if (progress) progress->post(2, outR, outC, bestVal, nodes);
+    });
+
+    return found && !searchCancelled(cancel);
+}
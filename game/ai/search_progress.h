@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <chrono>
+
+// Searches poll an optional stop flag owned by the caller; setting it makes
+// them give up early and report no move.
+inline bool searchCancelled(const std::atomic<bool>* cancel) {
+    return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+struct SearchProgress {
+    int depth = 0;          // plies searched, 0 while the stage has none (solvers)
+    int bestR = -1;         // best move so far, -1 before the first one
+    int bestC = -1;
+    int score = 0;          // for the side to move, in the stage's own units
+    qint64 nodes = 0;
+    qint64 nodesPerSecond = 0;
+    qint64 elapsedMs = 0;
+};
+
+// The latest progress of one running search, for a reader on another
+// thread. A single search thread posts; every post overwrites the previous
+// one (readers only ever want the newest), so nothing queues up and posting
+// is a few relaxed stores and one clock read. The searches post once per
+// root move or once per budget check, not per node, which keeps the cost far
+// below a percent of the search.
+//
+// Sequence lock: the writer makes the counter odd while it stores, and the
+// reader retries when the counter was odd or moved under it.
+class SearchProgressChannel {
+public:
+    // Starts a new search: clears the snapshot and the clock.
+    void begin() {
+        start_ = std::chrono::steady_clock::now();
+        store(0, -1, -1, 0, 0, 0);
+    }
+
+    void post(int depth, int bestR, int bestC, int score, qint64 nodes) {
+        const qint64 us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        store(depth, bestR, bestC, score, nodes, us);
+    }
+
+    // Copies the newest snapshot when it differs from `seq` (updated in
+    // place); returns false when nothing new was posted.
+    bool read(SearchProgress& out, quint32& seq) const {
+        for (;;) {
+            const quint32 s1 = seq_.load(std::memory_order_acquire);
+            if (s1 == seq) return false;
+            if (s1 & 1) continue;
+
+            qint64 w[kWords];
+            for (int i = 0; i < kWords; ++i) w[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) != s1) continue;
+
+            out.depth = static_cast<int>(w[0] & 0xFFFF);
+            out.bestR = static_cast<int>((w[0] >> 16) & 0xFFFF) - 1;
+            out.bestC = static_cast<int>((w[0] >> 32) & 0xFFFF) - 1;
+            out.score = static_cast<int>(w[1]);
+            out.nodes = w[2];
+            out.elapsedMs = w[3] / 1000;
+            out.nodesPerSecond = (w[3] > 0) ? w[2] * 1000000 / w[3] : 0;
+            seq = s1;
+            return true;
+        }
+    }
+
+private:
+    static constexpr int kWords = 4;
+
+    void store(int depth, int bestR, int bestC, int score, qint64 nodes, qint64 us) {
+        const qint64 packed = static_cast<qint64>(depth & 0xFFFF) |
+                              static_cast<qint64>((bestR + 1) & 0xFFFF) << 16 |
+                              static_cast<qint64>((bestC + 1) & 0xFFFF) << 32;
+
+        const quint32 s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        words_[0].store(packed, std::memory_order_relaxed);
+        words_[1].store(score, std::memory_order_relaxed);
+        words_[2].store(nodes, std::memory_order_relaxed);
+        words_[3].store(us, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+private:
+    std::atomic<quint32> seq_{0};
+    std::atomic<qint64> words_[kWords] = {};
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+};
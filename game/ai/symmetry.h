@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <utility>
+
+// The 8 symmetries of the square (identity, rotations, reflections) acting on
+// cells of an N x N board. Symmetry 0 is the identity. On the 9x9 Ultimate
+// board the same maps move whole local boards and the cells inside them
+// consistently, so they apply there unchanged.
+constexpr int kSymmetryCount = 8;
+
+inline void transformCell(int sym, int N, int r, int c, int& outR, int& outC) {
+    int rr = r;
+    int cc = c;
+    if (sym & 4) std::swap(rr, cc);
+    if (sym & 1) rr = N - 1 - rr;
+    if (sym & 2) cc = N - 1 - cc;
+    outR = rr;
+    outC = cc;
+}
+
+// Bit s is set when the position is unchanged by symmetry s: same owners and
+// same legal moves everywhere. Comparing legality covers mode-specific state
+// such as Ultimate's forced local board without knowing about it.
+template <class Mode>
+unsigned symmetryMask(const Mode& state) {
+    const int N = state.boardSize();
+    unsigned mask = 1u;
+
+    for (int s = 1; s < kSymmetryCount; ++s) {
+        bool same = true;
+        for (int r = 0; r < N && same; ++r) {
+            for (int c = 0; c < N; ++c) {
+                int tr = 0, tc = 0;
+                transformCell(s, N, r, c, tr, tc);
+                if (state.cellOwner(r, c) != state.cellOwner(tr, tc) ||
+                    state.isMoveAllowed(r, c) != state.isMoveAllowed(tr, tc)) {
+                    same = false;
+                    break;
+                }
+            }
+        }
+        if (same) mask |= (1u << s);
+    }
+
+    return mask;
+}
+
+// True when a symmetry of the position maps (r, c) onto an earlier cell in
+// row-major order. That cell leads to an equivalent subtree and is searched
+// first, so skipping (r, c) keeps the first-best tie-break unchanged.
+inline bool isSymmetricDuplicate(unsigned symMask, int N, int r, int c) {
+    if (symMask == 1u) return false;
+
+    for (int s = 1; s < kSymmetryCount; ++s) {
+        if (!(symMask & (1u << s))) continue;
+        int tr = 0, tc = 0;
+        transformCell(s, N, r, c, tr, tc);
+        if (tr * N + tc < r * N + c) return true;
+    }
+    return false;
+}
+
+// Base-3 encoding of the board minimised over all symmetries. Unique for
+// boards of up to 40 cells, which covers every Classic size we play.
+template <class Mode>
+quint64 classicCanonicalKey(const Mode& state) {
+    const int N = state.boardSize();
+    quint64 best = 0;
+
+    for (int s = 0; s < kSymmetryCount; ++s) {
+        quint64 key = 0;
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                int tr = 0, tc = 0;
+                transformCell(s, N, r, c, tr, tc);
+                key = key * 3 + static_cast<quint64>(state.cellOwner(tr, tc) + 1);
+            }
+        }
+        if (s == 0 || key < best) best = key;
+    }
+
+    return best;
+}
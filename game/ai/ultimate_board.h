@@ -0,0 +1,201 @@
+#pragma once
+
+#include "game/ai/symmetry.h"
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+#include <array>
+
+// Bit k of a 3x3 mask is cell k in row-major order.
+constexpr std::array<bool, 512> buildLocalWinTable() {
+    std::array<bool, 512> t{};
+    const int lines[8] = { 0007, 0070, 0700, 0111, 0222, 0444, 0421, 0124 };
+    for (int m = 0; m < 512; ++m) {
+        for (int line : lines) {
+            if ((m & line) == line) t[m] = true;
+        }
+    }
+    return t;
+}
+
+inline constexpr std::array<bool, 512> kLocalWins = buildLocalWinTable();
+
+// Every 3x3 mask under each of the 8 symmetries, mapped as transformCell does.
+constexpr std::array<std::array<quint16, 512>, 8> buildSymmetryMaskTable() {
+    std::array<std::array<quint16, 512>, 8> t{};
+    for (int s = 0; s < 8; ++s) {
+        for (int m = 0; m < 512; ++m) {
+            int out = 0;
+            for (int k = 0; k < 9; ++k) {
+                if (!(m & (1 << k))) continue;
+                int r = k / 3, c = k % 3;
+                if (s & 4) {
+                    const int tmp = r;
+                    r = c;
+                    c = tmp;
+                }
+                if (s & 1) r = 2 - r;
+                if (s & 2) c = 2 - c;
+                out |= 1 << (r * 3 + c);
+            }
+            t[s][m] = static_cast<quint16>(out);
+        }
+    }
+    return t;
+}
+
+inline constexpr std::array<std::array<quint16, 512>, 8> kSymmetryMasks = buildSymmetryMaskTable();
+
+// Compact Ultimate position: one 9-bit mask per local board and side, plus
+// macro masks for won and drawn locals. Local index and cell-in-local index
+// both run row-major over 3x3, so board cell (r, c) is local
+// (r / 3) * 3 + c / 3, cell (r % 3) * 3 + c % 3.
+struct UltimateBoard {
+    enum PlayResult { Continue = 0, MoverWins = 1, Draw = 2 };
+
+    quint16 x[9] = {};
+    quint16 o[9] = {};
+    quint16 macroX = 0;
+    quint16 macroO = 0;
+    quint16 macroDrawn = 0;
+    qint8 forced = -1;
+    qint8 player = 1;
+
+    static constexpr quint16 kFull = 0x1FF;
+
+    static bool hasLine(quint16 mask) { return kLocalWins[mask & kFull]; }
+
+    static int localOf(int r, int c) { return (r / 3) * 3 + (c / 3); }
+    static int cellOf(int r, int c) { return (r % 3) * 3 + (c % 3); }
+    static int rowOf(int local, int cell) { return (local / 3) * 3 + cell / 3; }
+    static int colOf(int local, int cell) { return (local % 3) * 3 + cell % 3; }
+
+    quint16 closedLocals() const { return macroX | macroO | macroDrawn; }
+    quint16 playableLocals() const { return static_cast<quint16>(~closedLocals() & kFull); }
+
+    // Locals the side to move may play in.
+    quint16 allowedLocals() const {
+        if (forced >= 0) return static_cast<quint16>(1u << forced);
+        return playableLocals();
+    }
+
+    quint16 emptyCells(int local) const { return static_cast<quint16>(~(x[local] | o[local]) & kFull); }
+
+    // 1 for X, -1 for O, 0 for empty; enough of a mode for ultimateHeuristic.
+    int cellOwner(int r, int c) const {
+        const quint16 bit = static_cast<quint16>(1u << cellOf(r, c));
+        if (x[localOf(r, c)] & bit) return 1;
+        if (o[localOf(r, c)] & bit) return -1;
+        return 0;
+    }
+
+    int emptyPlayableCount() const {
+        int n = 0;
+        const quint16 playable = playableLocals();
+        for (int l = 0; l < 9; ++l) {
+            if (playable & (1u << l)) n += qPopulationCount(emptyCells(l));
+        }
+        return n;
+    }
+
+    // Exact packing of the state into three words: 18 bits (x | o) per local,
+    // three locals per word, with forced local and side to move on top.
+    void pack(quint64 out[3]) const {
+        for (int w = 0; w < 3; ++w) {
+            quint64 v = 0;
+            for (int k = 0; k < 3; ++k) {
+                const int l = w * 3 + k;
+                v |= (static_cast<quint64>(x[l]) << 9 | o[l]) << (18 * k);
+            }
+            out[w] = v;
+        }
+        out[2] |= static_cast<quint64>(forced + 1) << 54;
+        out[2] |= static_cast<quint64>(player == 1 ? 1 : 0) << 58;
+    }
+
+    static quint64 mix64(quint64 z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    quint64 hash() const {
+        quint64 w[3];
+        pack(w);
+        return mix64(w[0] ^ mix64(w[1] ^ mix64(w[2] + 0x9E3779B97F4A7C15ull)));
+    }
+
+    // The position under symmetry `sym` (see symmetry.h). On 3x3 grids the
+    // same map moves locals and the cells inside them.
+    static quint16 transformMask(int sym, quint16 mask) { return kSymmetryMasks[sym][mask & kFull]; }
+
+    static int transformIndex(int sym, int k) {
+        int r = 0, c = 0;
+        transformCell(sym, 3, k / 3, k % 3, r, c);
+        return r * 3 + c;
+    }
+
+    UltimateBoard transformed(int sym) const {
+        UltimateBoard b;
+        for (int l = 0; l < 9; ++l) {
+            const int t = transformIndex(sym, l);
+            b.x[t] = transformMask(sym, x[l]);
+            b.o[t] = transformMask(sym, o[l]);
+        }
+        b.macroX = transformMask(sym, macroX);
+        b.macroO = transformMask(sym, macroO);
+        b.macroDrawn = transformMask(sym, macroDrawn);
+        b.forced = (forced < 0) ? forced : static_cast<qint8>(transformIndex(sym, forced));
+        b.player = player;
+        return b;
+    }
+
+    // Applies a legal move for the side to move. Mirrors UltimateMode::applyMove.
+    PlayResult play(int local, int cell) {
+        const quint16 bit = static_cast<quint16>(1u << cell);
+        const quint16 localBit = static_cast<quint16>(1u << local);
+        quint16& mine = (player == 1) ? x[local] : o[local];
+        mine |= bit;
+
+        if (hasLine(mine)) {
+            quint16& macro = (player == 1) ? macroX : macroO;
+            macro |= localBit;
+            if (hasLine(macro)) return MoverWins;
+        } else if ((x[local] | o[local]) == kFull) {
+            macroDrawn |= localBit;
+        }
+
+        const quint16 playable = playableLocals();
+        if (playable == 0) return Draw;
+
+        forced = (playable & (1u << cell)) ? static_cast<qint8>(cell) : static_cast<qint8>(-1);
+        player = static_cast<qint8>(-player);
+        return Continue;
+    }
+
+    template <class Mode>
+    static UltimateBoard fromMode(const Mode& state) {
+        UltimateBoard b;
+        for (int r = 0; r < 9; ++r) {
+            for (int c = 0; c < 9; ++c) {
+                const int owner = state.cellOwner(r, c);
+                if (owner == 1) b.x[localOf(r, c)] |= static_cast<quint16>(1u << cellOf(r, c));
+                else if (owner == -1) b.o[localOf(r, c)] |= static_cast<quint16>(1u << cellOf(r, c));
+            }
+        }
+
+        for (int l = 0; l < 9; ++l) {
+            const quint16 localBit = static_cast<quint16>(1u << l);
+            if (hasLine(b.x[l])) b.macroX |= localBit;
+            else if (hasLine(b.o[l])) b.macroO |= localBit;
+            else if ((b.x[l] | b.o[l]) == kFull) b.macroDrawn |= localBit;
+        }
+
+        const int ar = state.activeRow();
+        const int ac = state.activeCol();
+        b.forced = (ar < 0 || ac < 0) ? static_cast<qint8>(-1) : static_cast<qint8>(ar * 3 + ac);
+        b.player = static_cast<qint8>(state.currentPlayer());
+        return b;
+    }
+};
@@ -0,0 +1,340 @@
+#include "ultimate_book.h"
+
+#include "game/ai/search_core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', 'T', 'T', 'O' };
+constexpr int kWin = 100000;
+
+// Iterative-deepening negamax over UltimateBoard with a transposition table
+// kept across the positions a worker searches: neighbouring book positions
+// share most of their subtrees. Leaves are valued by ultimateHeuristic for
+// the side to move, so table entries do not depend on the root.
+class Searcher {
+public:
+    explicit Searcher(const UltimateHeuristicParams& params, int tableBits = 20)
+        : params_(params), table_(static_cast<size_t>(1) << tableBits),
+          mask_((static_cast<quint64>(1) << tableBits) - 1) {}
+
+    // Score for the side to move and the best move as r * 9 + c.
+    int search(const UltimateBoard& root, int depth, int& bestCell) {
+        int value = 0;
+        int best = -1;
+        for (int d = 1; d <= depth; ++d) {
+            value = negamax(root, d, 0, -kWin - 1, kWin + 1, &best);
+        }
+        bestCell = UltimateBoard::rowOf(best / 9, best % 9) * 9 + UltimateBoard::colOf(best / 9, best % 9);
+        return value;
+    }
+
+private:
+    enum Bound : quint8 { Empty = 0, Exact = 1, Lower = 2, Upper = 3 };
+
+    struct Entry {
+        quint64 key = 0;
+        qint32 value = 0;
+        qint8 depth = -1;
+        quint8 bound = Empty;
+        quint8 move = 0xFF;
+    };
+
+    int negamax(const UltimateBoard& b, int depth, int ply, int alpha, int beta, int* bestMove) {
+        if (depth == 0) return ultimateHeuristic(b, b.player, params_);
+
+        const quint64 key = b.hash();
+        Entry& e = table_[key & mask_];
+        int ttMove = -1;
+        if (e.bound != Empty && e.key == key) {
+            ttMove = (e.move == 0xFF) ? -1 : e.move;
+            if (!bestMove && e.depth >= depth) {
+                if (e.bound == Exact) return e.value;
+                if (e.bound == Lower && e.value >= beta) return e.value;
+                if (e.bound == Upper && e.value <= alpha) return e.value;
+            }
+        }
+
+        // Move order: transposition move, then moves completing a local
+        // line, then the rest.
+        int moves[81];
+        int count = 0;
+        int quiet = 81;
+        bool ttLegal = false;
+        const quint16 allowed = b.allowedLocals();
+        const quint16* mine = (b.player == 1) ? b.x : b.o;
+        for (int l = 0; l < 9; ++l) {
+            if (!(allowed & (1u << l))) continue;
+            const quint16 empty = b.emptyCells(l);
+            for (int k = 0; k < 9; ++k) {
+                if (!(empty & (1u << k))) continue;
+                const int m = l * 9 + k;
+                if (m == ttMove) {
+                    ttLegal = true;
+                    continue;
+                }
+                if (UltimateBoard::hasLine(static_cast<quint16>(mine[l] | (1u << k)))) moves[count++] = m;
+                else moves[--quiet] = m;
+            }
+        }
+        std::reverse(moves + quiet, moves + 81);
+        std::copy(moves + quiet, moves + 81, moves + count);
+        count += 81 - quiet;
+        if (ttLegal) {
+            std::copy_backward(moves, moves + count, moves + count + 1);
+            moves[0] = ttMove;
+            count++;
+        }
+
+        const int alphaIn = alpha;
+        int best = -kWin - 1;
+        int bestM = moves[0];
+        for (int i = 0; i < count; ++i) {
+            UltimateBoard child = b;
+            const UltimateBoard::PlayResult res = child.play(moves[i] / 9, moves[i] % 9);
+
+            int v = 0;
+            if (res == UltimateBoard::MoverWins) v = kWin - ply - 1;
+            else if (res == UltimateBoard::Continue) v = -negamax(child, depth - 1, ply + 1, -beta, -alpha, nullptr);
+
+            if (v > best) {
+                best = v;
+                bestM = moves[i];
+            }
+            if (v > alpha) alpha = v;
+            if (alpha >= beta) break;
+        }
+
+        e.key = key;
+        e.value = best;
+        e.depth = static_cast<qint8>(depth);
+        e.move = static_cast<quint8>(bestM);
+        e.bound = (best <= alphaIn) ? Upper : (best >= beta ? Lower : Exact);
+
+        if (bestMove) *bestMove = bestM;
+        return best;
+    }
+
+private:
+    const UltimateHeuristicParams& params_;
+    std::vector<Entry> table_;
+    quint64 mask_;
+};
+
+// Canonical positions reachable from the empty board before move `plies`.
+std::vector<UltimateBoard> openingPositions(int plies) {
+    std::vector<UltimateBoard> positions;
+    std::unordered_set<quint64> seen;
+
+    std::vector<UltimateBoard> level(1);
+    seen.insert(UltimateOpeningBook::canonicalKey(level[0]));
+
+    for (int ply = 0; ply < plies && !level.empty(); ++ply) {
+        positions.insert(positions.end(), level.begin(), level.end());
+        if (ply + 1 == plies) break;
+
+        std::vector<UltimateBoard> next;
+        for (const UltimateBoard& b : level) {
+            const quint16 allowed = b.allowedLocals();
+            for (int l = 0; l < 9; ++l) {
+                if (!(allowed & (1u << l))) continue;
+                const quint16 empty = b.emptyCells(l);
+                for (int k = 0; k < 9; ++k) {
+                    if (!(empty & (1u << k))) continue;
+
+                    UltimateBoard child = b;
+                    if (child.play(l, k) != UltimateBoard::Continue) continue;
+
+                    int sym = 0;
+                    if (seen.insert(UltimateOpeningBook::canonicalKey(child, &sym)).second) {
+                        next.push_back(child.transformed(sym));
+                    }
+                }
+            }
+        }
+        level = std::move(next);
+    }
+    return positions;
+}
+
+} // namespace
+
+UltimateOpeningBook::~UltimateOpeningBook() {
+    if (mapped_) file_.unmap(mapped_);
+}
+
+bool UltimateOpeningBook::open(const QString& path, QString* error) {
+    if (mapped_) file_.unmap(mapped_);
+    file_.close();
+    mapped_ = nullptr;
+    entries_ = nullptr;
+    count_ = 0;
+    depth_ = 0;
+
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        if (error) *error = file_.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize];
+    quint32 version = 0;
+    quint32 count = 0;
+    quint32 depth = 0;
+    const bool read = file_.read(header, kHeaderSize) == kHeaderSize;
+    if (read) {
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&count, header + 8, 4);
+        std::memcpy(&depth, header + 12, 4);
+    }
+    const qint64 bytes = kHeaderSize + static_cast<qint64>(count) * static_cast<qint64>(sizeof(Entry));
+    if (!read || std::memcmp(header, kMagic, 4) != 0 || version != kVersion || count == 0 ||
+        file_.size() != bytes) {
+        if (error) *error = QStringLiteral("not an Ultimate opening book of this version");
+        return false;
+    }
+
+    mapped_ = file_.map(0, bytes);
+    if (!mapped_) {
+        if (error) *error = file_.errorString();
+        return false;
+    }
+
+    entries_ = reinterpret_cast<const Entry*>(mapped_ + kHeaderSize);
+    count_ = count;
+    depth_ = static_cast<int>(depth);
+    return true;
+}
+
+quint64 UltimateOpeningBook::canonicalKey(const UltimateBoard& board, int* outSym) {
+    quint64 best[3] = {};
+    UltimateBoard bestBoard;
+    int bestSym = -1;
+
+    for (int s = 0; s < kSymmetryCount; ++s) {
+        const UltimateBoard t = board.transformed(s);
+        quint64 w[3];
+        t.pack(w);
+        if (bestSym < 0 || std::lexicographical_compare(w, w + 3, best, best + 3)) {
+            std::copy(w, w + 3, best);
+            bestBoard = t;
+            bestSym = s;
+        }
+    }
+
+    if (outSym) *outSym = bestSym;
+    return bestBoard.hash();
+}
+
+bool UltimateOpeningBook::probe(const UltimateBoard& board, int& outR, int& outC, int* outScore) const {
+    if (!entries_) return false;
+
+    int sym = 0;
+    const quint64 key = canonicalKey(board, &sym);
+    const Entry* end = entries_ + count_;
+    const Entry* e = std::lower_bound(entries_, end, key,
+                                      [](const Entry& entry, quint64 k) { return entry.key < k; });
+    if (e == end || e->key != key) return false;
+
+    // Back from the canonical orientation; the legality check guards
+    // against a key collision.
+    for (int r = 0; r < 9; ++r) {
+        for (int c = 0; c < 9; ++c) {
+            int tr = 0, tc = 0;
+            transformCell(sym, 9, r, c, tr, tc);
+            if (tr * 9 + tc != e->cell) continue;
+
+            const int local = UltimateBoard::localOf(r, c);
+            if (!(board.allowedLocals() & (1u << local)) ||
+                !(board.emptyCells(local) & (1u << UltimateBoard::cellOf(r, c)))) {
+                return false;
+            }
+            outR = r;
+            outC = c;
+            if (outScore) *outScore = e->score;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UltimateOpeningBook::generate(const BuildOptions& options, const QString& path, QString* error,
+                                   const std::function<void(qint64 done, qint64 total)>& onProgress) {
+    if (options.plies < 1 || options.depth < 1 || options.depth > 32) {
+        if (error) *error = QStringLiteral("plies and depth must be positive (depth at most 32)");
+        return false;
+    }
+
+    const std::vector<UltimateBoard> positions = openingPositions(options.plies);
+    const qint64 total = static_cast<qint64>(positions.size());
+    std::vector<Entry> entries(positions.size());
+
+    int threads = options.threads;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::atomic<qint64> next{0};
+    qint64 done = 0;
+    std::mutex mutex;
+
+    auto worker = [&]() {
+        Searcher searcher(options.params);
+        for (;;) {
+            const qint64 i = next.fetch_add(1);
+            if (i >= total) return;
+
+            int cell = 0;
+            const int score = searcher.search(positions[i], options.depth, cell);
+
+            Entry& e = entries[i];
+            e.key = positions[i].hash();
+            e.score = score;
+            e.cell = static_cast<quint8>(cell);
+            e.depth = static_cast<quint8>(options.depth);
+            e.reserved = 0;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ++done;
+            if (onProgress) onProgress(done, total);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) pool.emplace_back(worker);
+    for (std::thread& t : pool) t.join();
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const Entry& a, const Entry& b) { return a.key == b.key; }),
+                  entries.end());
+
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize] = {};
+    const quint32 count = static_cast<quint32>(entries.size());
+    const quint32 depth = static_cast<quint32>(options.depth);
+    std::memcpy(header, kMagic, 4);
+    std::memcpy(header + 4, &kVersion, 4);
+    std::memcpy(header + 8, &count, 4);
+    std::memcpy(header + 12, &depth, 4);
+
+    const qint64 bytes = static_cast<qint64>(entries.size() * sizeof(Entry));
+    if (out.write(header, kHeaderSize) != kHeaderSize ||
+        out.write(reinterpret_cast<const char*>(entries.data()), bytes) != bytes) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "game/ai/ultimate_board.h"
+#include "game/ai/ultimate_params.h"
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <functional>
+
+// Opening book for Ultimate: the best move of every position in the first
+// few plies, found offline by a deep search (the ultimate_book tool) so the
+// computer answers those positions with a binary search instead of its
+// depth-2 search. Positions are stored once per symmetry class, under the
+// 64-bit hash of the board transformed to its smallest packed form; moves
+// are in that orientation and are mapped back on lookup.
+//
+// File layout: 16-byte header ("TTTO", version, entry count, search depth),
+// then the entries sorted by key. The file is memory-mapped on open.
+class UltimateOpeningBook {
+public:
+    struct Entry {
+        quint64 key;
+        qint32 score;       // for the side to move
+        quint8 cell;        // r * 9 + c in the canonical orientation
+        quint8 depth;
+        quint16 reserved;
+    };
+    static_assert(sizeof(Entry) == 16, "book entries are 16 bytes on disk");
+
+    struct BuildOptions {
+        int plies = 5;                  // book moves for the first `plies` moves of a game
+        int depth = 8;                  // search depth per position
+        int threads = 0;                // 0 = all cores
+        UltimateHeuristicParams params;
+    };
+
+    UltimateOpeningBook() = default;
+    ~UltimateOpeningBook();
+
+    UltimateOpeningBook(const UltimateOpeningBook&) = delete;
+    UltimateOpeningBook& operator=(const UltimateOpeningBook&) = delete;
+
+    bool open(const QString& path, QString* error = nullptr);
+    bool isOpen() const { return entries_ != nullptr; }
+    qint64 size() const { return count_; }
+    int depth() const { return depth_; }
+
+    // The book move of `board` when it has one. Thread-safe.
+    bool probe(const UltimateBoard& board, int& outR, int& outC, int* outScore = nullptr) const;
+
+    // Hash of the board's smallest packed form over the 8 symmetries, and
+    // the symmetry that produces it.
+    static quint64 canonicalKey(const UltimateBoard& board, int* outSym = nullptr);
+
+    // Enumerates every position reachable before move options.plies, one
+    // per symmetry class, searches them on all threads and writes the book.
+    // onProgress, when set, gets (searched, total) from the workers.
+    static bool generate(const BuildOptions& options, const QString& path, QString* error = nullptr,
+                         const std::function<void(qint64 done, qint64 total)>& onProgress = {});
+
+private:
+    static constexpr quint32 kVersion = 1;
+    static constexpr qint64 kHeaderSize = 16;
+
+    QFile file_;
+    uchar* mapped_ = nullptr;
+    const Entry* entries_ = nullptr;
+    qint64 count_ = 0;
+    int depth_ = 0;
+};
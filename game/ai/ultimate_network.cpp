@@ -0,0 +1,240 @@
+#include "ultimate_network.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ULTIMATE_NETWORK_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ULTIMATE_NETWORK_SSE2 1
+#endif
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', 'T', 'T', 'N' };
+constexpr quint32 kVersion = 1;
+constexpr qint64 kHeaderSize = 16;
+
+template <class T>
+T quantise(float v, float scale, T lo, T hi) {
+    const float q = std::round(v * scale);
+    return static_cast<T>(std::clamp(q, static_cast<float>(lo), static_cast<float>(hi)));
+}
+
+} // namespace
+
+int UltimateNetwork::features(const UltimateBoard& b, int* out) {
+    int n = 0;
+    for (int l = 0; l < 9; ++l) {
+        for (int k = 0; k < 9; ++k) {
+            const int cell = UltimateBoard::rowOf(l, k) * 9 + UltimateBoard::colOf(l, k);
+            if (b.x[l] & (1u << k)) out[n++] = kXStone + cell;
+            else if (b.o[l] & (1u << k)) out[n++] = kOStone + cell;
+        }
+
+        if (b.macroX & (1u << l)) out[n++] = kXLocal + l;
+        else if (b.macroO & (1u << l)) out[n++] = kOLocal + l;
+        else if (b.macroDrawn & (1u << l)) out[n++] = kDrawnLocal + l;
+    }
+
+    out[n++] = (b.forced >= 0) ? kForcedLocal + b.forced : kFreeMove;
+    if (b.player == 1) out[n++] = kXToMove;
+    return n;
+}
+
+void UltimateNetwork::refresh(Accumulator& acc, const UltimateBoard& b) const {
+    std::memcpy(acc.v, b1_, sizeof(acc.v));
+
+    int active[kMaxActive];
+    const int n = features(b, active);
+    for (int i = 0; i < n; ++i) add(acc, active[i]);
+}
+
+void UltimateNetwork::add(Accumulator& acc, int feature) const {
+    const qint16* w = w1_[feature];
+#if defined(ULTIMATE_NETWORK_AVX2)
+    for (int i = 0; i < kHidden1; i += 16) {
+        __m256i* a = reinterpret_cast<__m256i*>(acc.v + i);
+        *a = _mm256_add_epi16(*a, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i)));
+    }
+#elif defined(ULTIMATE_NETWORK_SSE2)
+    for (int i = 0; i < kHidden1; i += 8) {
+        __m128i* a = reinterpret_cast<__m128i*>(acc.v + i);
+        *a = _mm_add_epi16(*a, _mm_load_si128(reinterpret_cast<const __m128i*>(w + i)));
+    }
+#else
+    for (int i = 0; i < kHidden1; ++i) acc.v[i] = static_cast<qint16>(acc.v[i] + w[i]);
+#endif
+}
+
+void UltimateNetwork::remove(Accumulator& acc, int feature) const {
+    const qint16* w = w1_[feature];
+#if defined(ULTIMATE_NETWORK_AVX2)
+    for (int i = 0; i < kHidden1; i += 16) {
+        __m256i* a = reinterpret_cast<__m256i*>(acc.v + i);
+        *a = _mm256_sub_epi16(*a, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i)));
+    }
+#elif defined(ULTIMATE_NETWORK_SSE2)
+    for (int i = 0; i < kHidden1; i += 8) {
+        __m128i* a = reinterpret_cast<__m128i*>(acc.v + i);
+        *a = _mm_sub_epi16(*a, _mm_load_si128(reinterpret_cast<const __m128i*>(w + i)));
+    }
+#else
+    for (int i = 0; i < kHidden1; ++i) acc.v[i] = static_cast<qint16>(acc.v[i] - w[i]);
+#endif
+}
+
+int UltimateNetwork::evaluate(const Accumulator& acc) const {
+    qint32 sums[kHidden2];
+
+#if defined(ULTIMATE_NETWORK_AVX2)
+    // Clipped activations as bytes; packus works per 128-bit lane, so the
+    // quadwords are put back in order afterwards.
+    const __m256i limit = _mm256_set1_epi8(127);
+    const __m256i* v = reinterpret_cast<const __m256i*>(acc.v);
+    const __m256i h0 = _mm256_min_epu8(_mm256_permute4x64_epi64(_mm256_packus_epi16(v[0], v[1]), 0xD8), limit);
+    const __m256i h1 = _mm256_min_epu8(_mm256_permute4x64_epi64(_mm256_packus_epi16(v[2], v[3]), 0xD8), limit);
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    for (int j = 0; j < kHidden2; ++j) {
+        const __m256i* w = reinterpret_cast<const __m256i*>(w2_[j]);
+        const __m256i p = _mm256_add_epi32(_mm256_madd_epi16(_mm256_maddubs_epi16(h0, _mm256_load_si256(w)), ones),
+                                           _mm256_madd_epi16(_mm256_maddubs_epi16(h1, _mm256_load_si256(w + 1)), ones));
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        sums[j] = _mm_cvtsi128_si32(s);
+    }
+#elif defined(ULTIMATE_NETWORK_SSE2)
+    // No unsigned-by-signed byte multiply in SSE2: activations stay 16-bit
+    // and weight rows are sign-extended on load.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(127);
+    __m128i h[kHidden1 / 8];
+    for (int i = 0; i < kHidden1 / 8; ++i) {
+        const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc.v) + i);
+        h[i] = _mm_min_epi16(_mm_max_epi16(a, zero), limit);
+    }
+
+    for (int j = 0; j < kHidden2; ++j) {
+        const __m128i* w = reinterpret_cast<const __m128i*>(w2_[j]);
+        __m128i s = zero;
+        for (int i = 0; i < kHidden1 / 16; ++i) {
+            const __m128i bytes = _mm_load_si128(w + i);
+            const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+            const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+            s = _mm_add_epi32(s, _mm_madd_epi16(h[2 * i], lo));
+            s = _mm_add_epi32(s, _mm_madd_epi16(h[2 * i + 1], hi));
+        }
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        sums[j] = _mm_cvtsi128_si32(s);
+    }
+#else
+    int h[kHidden1];
+    for (int i = 0; i < kHidden1; ++i) h[i] = std::clamp(static_cast<int>(acc.v[i]), 0, 127);
+
+    for (int j = 0; j < kHidden2; ++j) {
+        qint32 s = 0;
+        for (int i = 0; i < kHidden1; ++i) s += h[i] * w2_[j][i];
+        sums[j] = s;
+    }
+#endif
+
+    qint32 out = b3_;
+    for (int j = 0; j < kHidden2; ++j) {
+        const int a2 = std::clamp((sums[j] + b2_[j]) / 64, 0, 127);
+        out += a2 * w3_[j];
+    }
+
+    const qint64 eval = static_cast<qint64>(out) * kEvalScale / (127 * 64);
+    return static_cast<int>(std::clamp<qint64>(eval, -kEvalLimit, kEvalLimit));
+}
+
+void UltimateNetwork::setWeights(const Weights& weights) {
+    for (int f = 0; f < kFeatures; ++f) {
+        for (int i = 0; i < kHidden1; ++i) {
+            w1_[f][i] = quantise<qint16>(weights.w1[f * kHidden1 + i], 127.0f, -32767, 32767);
+        }
+    }
+    for (int i = 0; i < kHidden1; ++i) b1_[i] = quantise<qint16>(weights.b1[i], 127.0f, -32767, 32767);
+
+    for (int j = 0; j < kHidden2; ++j) {
+        for (int i = 0; i < kHidden1; ++i) {
+            w2_[j][i] = quantise<qint8>(weights.w2[j * kHidden1 + i], 64.0f, -127, 127);
+        }
+        b2_[j] = quantise<qint32>(weights.b2[j], 127.0f * 64.0f, -(1 << 30), 1 << 30);
+        w3_[j] = quantise<qint8>(weights.w3[j], 64.0f, -127, 127);
+    }
+    b3_ = quantise<qint32>(weights.b3, 127.0f * 64.0f, -(1 << 30), 1 << 30);
+}
+
+bool UltimateNetwork::load(const QString& path, QString* error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    const qint64 expected = kHeaderSize + static_cast<qint64>(sizeof(w1_) + sizeof(b1_) + sizeof(w2_) +
+                                                              sizeof(b2_) + sizeof(w3_) + sizeof(b3_));
+    const QByteArray data = (file.size() == expected) ? file.read(expected) : QByteArray();
+
+    quint32 version = 0;
+    quint16 dims[3] = {};
+    if (data.size() >= kHeaderSize) {
+        std::memcpy(&version, data.constData() + 4, 4);
+        std::memcpy(dims, data.constData() + 8, 6);
+    }
+    if (data.size() != expected || std::memcmp(data.constData(), kMagic, 4) != 0 || version != kVersion ||
+        dims[0] != kFeatures || dims[1] != kHidden1 || dims[2] != kHidden2) {
+        if (error) *error = QStringLiteral("not an Ultimate network file of this version and size");
+        return false;
+    }
+
+    const char* p = data.constData() + kHeaderSize;
+    auto take = [&p](void* dst, size_t bytes) {
+        std::memcpy(dst, p, bytes);
+        p += bytes;
+    };
+    take(w1_, sizeof(w1_));
+    take(b1_, sizeof(b1_));
+    take(w2_, sizeof(w2_));
+    take(b2_, sizeof(b2_));
+    take(w3_, sizeof(w3_));
+    take(&b3_, sizeof(b3_));
+    return true;
+}
+
+bool UltimateNetwork::save(const QString& path, QString* error) const {
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize] = {};
+    const quint16 dims[3] = { kFeatures, kHidden1, kHidden2 };
+    std::memcpy(header, kMagic, 4);
+    std::memcpy(header + 4, &kVersion, 4);
+    std::memcpy(header + 8, dims, 6);
+
+    QByteArray data(header, kHeaderSize);
+    data.append(reinterpret_cast<const char*>(w1_), sizeof(w1_));
+    data.append(reinterpret_cast<const char*>(b1_), sizeof(b1_));
+    data.append(reinterpret_cast<const char*>(w2_), sizeof(w2_));
+    data.append(reinterpret_cast<const char*>(b2_), sizeof(b2_));
+    data.append(reinterpret_cast<const char*>(w3_), sizeof(w3_));
+    data.append(reinterpret_cast<const char*>(&b3_), sizeof(b3_));
+
+    if (out.write(data.constData(), data.size()) != data.size()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "game/ai/ultimate_board.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <vector>
+
+// Small quantised network evaluating Ultimate positions, NNUE-style: the
+// first layer is a sum of weight columns over the active input features, so
+// a move only adds or removes a handful of columns (UltimateAccumulator);
+// the two small layers after it run on 8-bit activations.
+//
+// Inputs, all from X's point of view (the side to move is an input):
+//   0..80      X stone on cell r * 9 + c       81..161   O stone
+//   162..170   local won by X                  171..179  local won by O
+//   180..188   local drawn                     189..197  forced local
+//   198        free move                       199       X to move
+//
+// Float model the trainer fits and the quantised one reproduces:
+//   a1 = clamp(b1 + sum of w1 rows, 0, 1)          64
+//   a2 = clamp(b2 + w2 * a1, 0, 1)                 32
+//   out = b3 + w3 . a2                            logit of X winning
+// and evaluate() returns out * kEvalScale, in the units of
+// ultimateHeuristic (positive favours X).
+//
+// Quantisation: layer-1 weights and the accumulator are int16 scaled by 127,
+// so the clipped accumulator is an 8-bit activation; layer-2 and output
+// weights are int8 scaled by 64 with int32 sums. Inference uses AVX2 or SSE2
+// when the compiler targets them and plain loops otherwise; all three give
+// identical results.
+//
+// File layout: 16-byte header ("TTTN", version, inputs, hidden sizes as
+// 16-bit values), then w1, b1 (int16), w2 (int8, one row per layer-2
+// neuron), b2 (int32), w3 (int8), b3 (int32), little-endian.
+class UltimateNetwork {
+public:
+    static constexpr int kXStone = 0;
+    static constexpr int kOStone = 81;
+    static constexpr int kXLocal = 162;
+    static constexpr int kOLocal = 171;
+    static constexpr int kDrawnLocal = 180;
+    static constexpr int kForcedLocal = 189;
+    static constexpr int kFreeMove = 198;
+    static constexpr int kXToMove = 199;
+    static constexpr int kFeatures = 200;
+    static constexpr int kHidden1 = 64;
+    static constexpr int kHidden2 = 32;
+    static constexpr int kMaxActive = 81 + 27 + 2;
+    static constexpr int kEvalScale = 1000;
+    static constexpr int kEvalLimit = 30000;    // below the heuristic's win scores
+
+    // The float weights; w1 is feature-major, w2 one row per output.
+    struct Weights {
+        std::vector<float> w1 = std::vector<float>(kFeatures * kHidden1);
+        std::vector<float> b1 = std::vector<float>(kHidden1);
+        std::vector<float> w2 = std::vector<float>(kHidden2 * kHidden1);
+        std::vector<float> b2 = std::vector<float>(kHidden2);
+        std::vector<float> w3 = std::vector<float>(kHidden2);
+        float b3 = 0.0f;
+    };
+
+    // Largest layer-2 / output weight the int8 scale can hold.
+    static constexpr float kMaxWeight = 127.0f / 64.0f;
+
+    bool load(const QString& path, QString* error = nullptr);
+    bool save(const QString& path, QString* error = nullptr) const;
+
+    void setWeights(const Weights& weights);
+
+    // Active features of a position; returns how many were written.
+    static int features(const UltimateBoard& b, int* out);
+
+    struct Accumulator {
+        alignas(32) qint16 v[kHidden1];
+    };
+
+    void refresh(Accumulator& acc, const UltimateBoard& b) const;
+    void add(Accumulator& acc, int feature) const;
+    void remove(Accumulator& acc, int feature) const;
+
+    int evaluate(const Accumulator& acc) const;
+
+private:
+    alignas(32) qint16 w1_[kFeatures][kHidden1] = {};
+    alignas(32) qint16 b1_[kHidden1] = {};
+    alignas(32) qint8 w2_[kHidden2][kHidden1] = {};
+    qint32 b2_[kHidden2] = {};
+    qint8 w3_[kHidden2] = {};
+    qint32 b3_ = 0;
+};
+
+using UltimateAccumulator = UltimateNetwork::Accumulator;
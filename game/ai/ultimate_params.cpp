@@ -0,0 +1,77 @@
+#include "ultimate_params.h"
+
+#include <QFile>
+
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', 'T', 'T', 'P' };
+constexpr quint32 kVersion = 1;
+constexpr qint64 kHeaderSize = 16;
+
+const char* const kTermNames[UltimateHeuristicParams::kTerms] = {
+    "local-won", "local-lost",
+    "macro-two", "macro-two-against", "macro-one", "macro-one-against",
+    "blocked-two", "blocked-two-against", "blocked-one", "blocked-one-against",
+    "local-two", "local-two-against", "local-one", "local-one-against",
+    "centre-won", "centre-lost",
+};
+
+} // namespace
+
+const char* UltimateHeuristicParams::termName(int term) {
+    return (term >= 0 && term < kTerms) ? kTermNames[term] : "";
+}
+
+bool UltimateHeuristicParams::load(const QString& path, QString* error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize];
+    qint32 values[kTerms];
+    quint32 version = 0;
+    quint32 terms = 0;
+    const qint64 bytes = static_cast<qint64>(sizeof(values));
+    const bool read = file.size() == kHeaderSize + bytes && file.read(header, kHeaderSize) == kHeaderSize &&
+                      file.read(reinterpret_cast<char*>(values), bytes) == bytes;
+    if (read) {
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&terms, header + 8, 4);
+    }
+    if (!read || std::memcmp(header, kMagic, 4) != 0 || version != kVersion || terms != kTerms) {
+        if (error) *error = QStringLiteral("not an Ultimate parameter file of this version");
+        return false;
+    }
+
+    for (int t = 0; t < kTerms; ++t) weight[t] = values[t];
+    return true;
+}
+
+bool UltimateHeuristicParams::save(const QString& path, QString* error) const {
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize] = {};
+    const quint32 terms = kTerms;
+    std::memcpy(header, kMagic, 4);
+    std::memcpy(header + 4, &kVersion, 4);
+    std::memcpy(header + 8, &terms, 4);
+
+    qint32 values[kTerms];
+    for (int t = 0; t < kTerms; ++t) values[t] = weight[t];
+
+    const qint64 bytes = static_cast<qint64>(sizeof(values));
+    if (out.write(header, kHeaderSize) != kHeaderSize ||
+        out.write(reinterpret_cast<const char*>(values), bytes) != bytes) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+// Weights of ultimateHeuristic. The heuristic is linear in them: a position
+// is reduced to signed term counts (ultimateHeuristicTerms) and its value is
+// the dot product with `weight`, so the tune_ultimate tool can fit the
+// weights to game results without re-running the heuristic.
+//
+// "Against" terms count the opponent's features and are subtracted. Macro
+// lines are rows, columns and diagonals of locals with no drawn local
+// ("open") or with one ("blocked"); local lines are the same inside open
+// locals.
+//
+// File layout: 16-byte header ("TTTP", version, term count, reserved), then
+// one little-endian int32 per term.
+struct UltimateHeuristicParams {
+    enum Term {
+        LocalWon, LocalLost,
+        MacroTwo, MacroTwoAgainst, MacroOne, MacroOneAgainst,
+        BlockedTwo, BlockedTwoAgainst, BlockedOne, BlockedOneAgainst,
+        LocalTwo, LocalTwoAgainst, LocalOne, LocalOneAgainst,
+        CentreWon, CentreLost,
+        kTerms
+    };
+
+    int weight[kTerms] = {
+        220, 240,
+        700, 900, 90, 130,
+        180, 230, 25, 35,
+        28, 34, 4, 6,
+        60, 70
+    };
+
+    static const char* termName(int term);
+
+    int evaluate(const int terms[kTerms]) const {
+        int score = 0;
+        for (int t = 0; t < kTerms; ++t) score += weight[t] * terms[t];
+        return score;
+    }
+
+    bool load(const QString& path, QString* error = nullptr);
+    bool save(const QString& path, QString* error = nullptr) const;
+};
+
+inline const UltimateHeuristicParams kDefaultUltimateParams{};
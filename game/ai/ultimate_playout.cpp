@@ -0,0 +1,252 @@
+#include "ultimate_playout.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr int kLanes = 64;
+
+// kSelectInByte[b][k]: position of the k-th set bit of byte b.
+constexpr std::array<std::array<quint8, 8>, 256> buildSelectInByte() {
+    std::array<std::array<quint8, 8>, 256> t{};
+    for (int b = 0; b < 256; ++b) {
+        int k = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            if (b & (1 << bit)) t[b][k++] = static_cast<quint8>(bit);
+        }
+    }
+    return t;
+}
+
+constexpr std::array<std::array<quint8, 8>, 256> kSelectInByte = buildSelectInByte();
+
+constexpr quint64 kOnes8 = 0x0101010101010101ull;
+constexpr quint64 kHighs8 = 0x8080808080808080ull;
+
+// Byte i of the result is the number of set bits in bytes 0..i of w, so the
+// top byte is the population count. Plain arithmetic, no popcount
+// instruction needed.
+inline quint64 bytePrefixCounts(quint64 w) {
+    quint64 s = w - ((w >> 1) & 0x5555555555555555ull);
+    s = (s & 0x3333333333333333ull) + ((s >> 2) & 0x3333333333333333ull);
+    s = (s + (s >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return s * kOnes8;
+}
+
+// Position of the k-th set bit of w (k below its population count), given
+// its byte prefix counts: the byte is the number of prefixes <= k, found for
+// all eight bytes at once, and a table finishes inside the byte.
+inline int selectBit(quint64 w, quint64 prefix, int k) {
+    const quint64 atMost = ((static_cast<quint64>(k) * kOnes8 | kHighs8) - prefix) & kHighs8;
+    const int byte = static_cast<int>(((atMost >> 7) * kOnes8) >> 56);
+    const int before = static_cast<int>(((prefix << 8) >> (8 * byte)) & 0xFF);
+    return 8 * byte + kSelectInByte[(w >> (8 * byte)) & 0xFF][k - before];
+}
+
+// The running games, one column per lane. Locals 0-6 of the legal-move mask
+// sit in the low word (9 bits each), locals 7 and 8 in the high word.
+struct PlayoutBatch {
+    quint16 x[9][kLanes];
+    quint16 o[9][kLanes];
+    quint16 macroX[kLanes];
+    quint16 macroO[kLanes];
+    quint16 macroDrawn[kLanes];
+    qint8 forced[kLanes];
+    qint8 player[kLanes];
+
+    quint64 rng[kLanes];
+    int start[kLanes];          // index into starts, -1 for an idle lane
+    qint8 rootPlayer[kLanes];
+    quint8 result[kLanes];      // UltimateBoard::PlayResult of the last step
+
+    void load(int lane, const UltimateBoard& b, int startIndex, quint64 seed) {
+        for (int l = 0; l < 9; ++l) {
+            x[l][lane] = b.x[l];
+            o[l][lane] = b.o[l];
+        }
+        macroX[lane] = b.macroX;
+        macroO[lane] = b.macroO;
+        macroDrawn[lane] = b.macroDrawn;
+        forced[lane] = b.forced;
+        player[lane] = b.player;
+        rng[lane] = seed;
+        start[lane] = startIndex;
+        rootPlayer[lane] = b.player;
+        result[lane] = UltimateBoard::Continue;
+    }
+
+    // One random move in every lane, idle ones included.
+    void step() {
+        for (int i = 0; i < kLanes; ++i) {
+            const quint16 closed = macroX[i] | macroO[i] | macroDrawn[i];
+            const quint16 playable = static_cast<quint16>(~closed & UltimateBoard::kFull);
+            const quint16 allowed = (forced[i] >= 0) ? static_cast<quint16>(1u << forced[i]) : playable;
+
+            quint64 lo = 0;
+            quint64 hi = 0;
+            for (int l = 0; l < 7; ++l) {
+                const quint64 on = static_cast<quint64>(0) - ((allowed >> l) & 1u);
+                lo |= (static_cast<quint64>(~(x[l][i] | o[l][i]) & UltimateBoard::kFull) & on) << (9 * l);
+            }
+            for (int l = 7; l < 9; ++l) {
+                const quint64 on = static_cast<quint64>(0) - ((allowed >> l) & 1u);
+                hi |= (static_cast<quint64>(~(x[l][i] | o[l][i]) & UltimateBoard::kFull) & on) << (9 * (l - 7));
+            }
+
+            const quint64 prefixLo = bytePrefixCounts(lo);
+            const quint64 prefixHi = bytePrefixCounts(hi);
+            const int nLo = static_cast<int>(prefixLo >> 56);
+            const int n = nLo + static_cast<int>(prefixHi >> 56);
+
+            quint64 z = (rng[i] += 0x9E3779B97F4A7C15ull);
+            z = UltimateBoard::mix64(z);
+            int k = static_cast<int>(((z >> 32) * static_cast<quint64>(n)) >> 32);
+
+            const bool inHi = k >= nLo;
+            k -= inHi ? nLo : 0;
+            const int index = inHi ? 63 + selectBit(hi, prefixHi, k) : selectBit(lo, prefixLo, k);
+            const int local = index / 9;
+            const int cell = index % 9;
+
+            const bool xMoves = player[i] > 0;
+            const quint16 bit = static_cast<quint16>(1u << cell);
+            const quint16 localBit = static_cast<quint16>(1u << local);
+
+            quint16 xs = x[local][i] | (xMoves ? bit : 0);
+            quint16 os = o[local][i] | (xMoves ? 0 : bit);
+            x[local][i] = xs;
+            o[local][i] = os;
+
+            const bool won = kLocalWins[xMoves ? xs : os];
+            const bool full = (xs | os) == UltimateBoard::kFull;
+            macroX[i] |= (won && xMoves) ? localBit : 0;
+            macroO[i] |= (won && !xMoves) ? localBit : 0;
+            macroDrawn[i] |= (!won && full) ? localBit : 0;
+
+            const bool gameWon = won && kLocalWins[xMoves ? macroX[i] : macroO[i]];
+            const quint16 open = static_cast<quint16>(~(macroX[i] | macroO[i] | macroDrawn[i]) & UltimateBoard::kFull);
+            const bool drawn = !gameWon && open == 0;
+
+            forced[i] = ((open >> cell) & 1u) ? static_cast<qint8>(cell) : static_cast<qint8>(-1);
+            player[i] = static_cast<qint8>(gameWon ? player[i] : -player[i]);
+            result[i] = static_cast<quint8>(gameWon ? UltimateBoard::MoverWins
+                                                    : (drawn ? UltimateBoard::Draw : UltimateBoard::Continue));
+        }
+    }
+};
+
+// Result of a start position that is already over, for the side to move.
+int finishedResult(const UltimateBoard& b) {
+    if (UltimateBoard::hasLine(b.macroX)) return b.player == 1 ? 1 : -1;
+    if (UltimateBoard::hasLine(b.macroO)) return b.player == -1 ? 1 : -1;
+    if (b.playableLocals() == 0) return 0;
+    return 2;
+}
+
+void addResult(PlayoutTally& t, int result) {
+    if (result > 0) t.wins++;
+    else if (result < 0) t.losses++;
+    else t.draws++;
+}
+
+} // namespace
+
+std::vector<PlayoutTally> runUltimatePlayouts(const std::vector<UltimateBoard>& starts,
+                                              int playoutsPerStart, quint64 seed, int threads) {
+    std::vector<PlayoutTally> tallies(starts.size());
+    if (starts.empty() || playoutsPerStart <= 0) return tallies;
+
+    std::vector<int> over(starts.size());
+    for (size_t s = 0; s < starts.size(); ++s) {
+        over[s] = finishedResult(starts[s]);
+        if (over[s] != 2) {
+            for (int g = 0; g < playoutsPerStart; ++g) addResult(tallies[s], over[s]);
+        }
+    }
+
+    const qint64 total = static_cast<qint64>(starts.size()) * playoutsPerStart;
+    std::atomic<qint64> next{0};
+    std::mutex mutex;
+
+    // Workers take playouts in chunks of a batch; each playout is seeded
+    // from its own index.
+    auto worker = [&]() {
+        PlayoutBatch batch;
+        std::vector<PlayoutTally> local(starts.size());
+        qint64 chunkNext = 0;
+        qint64 chunkEnd = 0;
+
+        auto refill = [&](int lane) {
+            for (;;) {
+                if (chunkNext == chunkEnd) {
+                    chunkNext = next.fetch_add(kLanes);
+                    chunkEnd = std::min(chunkNext + kLanes, total);
+                    if (chunkNext >= total) {
+                        chunkNext = chunkEnd = total;
+                        batch.start[lane] = -1;
+                        return false;
+                    }
+                }
+
+                const qint64 playout = chunkNext++;
+                const int s = static_cast<int>(playout / playoutsPerStart);
+                if (over[s] != 2) continue;
+                batch.load(lane, starts[s], s, UltimateBoard::mix64(seed ^ UltimateBoard::mix64(playout)));
+                return true;
+            }
+        };
+
+        int live = 0;
+        for (int lane = 0; lane < kLanes; ++lane) {
+            if (refill(lane)) live++;
+            else batch.load(lane, UltimateBoard(), -1, 0);
+        }
+
+        while (live > 0) {
+            batch.step();
+
+            for (int lane = 0; lane < kLanes; ++lane) {
+                if (batch.result[lane] == UltimateBoard::Continue) continue;
+
+                const int s = batch.start[lane];
+                if (s >= 0) {
+                    if (batch.result[lane] == UltimateBoard::Draw) {
+                        local[s].draws++;
+                    } else if (batch.player[lane] == batch.rootPlayer[lane]) {
+                        local[s].wins++;
+                    } else {
+                        local[s].losses++;
+                    }
+
+                    if (refill(lane)) continue;
+                    live--;
+                }
+
+                // Idle lanes keep playing on an empty board so that step()
+                // needs no per-lane checks; they restart when a game ends.
+                batch.load(lane, UltimateBoard(), -1, 0);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t s = 0; s < starts.size(); ++s) {
+            tallies[s].wins += local[s].wins;
+            tallies[s].draws += local[s].draws;
+            tallies[s].losses += local[s].losses;
+        }
+    };
+
+    if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = static_cast<int>(std::min<qint64>(threads, (total + kLanes - 1) / kLanes));
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    return tallies;
+}
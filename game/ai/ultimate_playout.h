@@ -0,0 +1,30 @@
+#pragma once
+
+#include "game/ai/ultimate_board.h"
+
+#include <QtGlobal>
+
+#include <vector>
+
+struct PlayoutTally {
+    qint64 wins = 0;        // for the side to move in the start position
+    qint64 draws = 0;
+    qint64 losses = 0;
+
+    qint64 games() const { return wins + draws + losses; }
+};
+
+// Uniformly random playouts of Ultimate positions for Monte Carlo
+// evaluation. Games are not played one by one through applyMove: a batch of
+// lanes keeps every game's bitmasks in structure-of-arrays form and advances
+// all of them one move per step. Each step builds a lane's legal cells as an
+// 81-bit mask, picks the k-th set bit for a random k and applies the move
+// with table lookups and masks instead of branches. A lane whose game ends
+// is refilled with the next playout, so the batch stays full until the work
+// runs out.
+//
+// Playout i draws its moves from a generator seeded by (seed, i), so the
+// tallies depend on the seed only, not on the thread count.
+std::vector<PlayoutTally> runUltimatePlayouts(const std::vector<UltimateBoard>& starts,
+                                              int playoutsPerStart, quint64 seed = 1,
+                                              int threads = 1);
@@ -0,0 +1,117 @@
+#include "ultimate_solver.h"
+
+UltimateSolver::UltimateSolver(int tableBits) {
+    table_.resize(static_cast<size_t>(1) << tableBits);
+    mask_ = (static_cast<quint64>(1) << tableBits) - 1;
+}
+
+UltimateSolver::Result UltimateSolver::solve(const UltimateBoard& root, const Limits& limits,
+                                             int& bestLocal, int& bestCell) {
+    limits_ = limits;
+    nodes_ = 0;
+    aborted_ = false;
+    deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.maxMillis);
+
+    int best = -1;
+    const int value = negamax(root, -1, 1, &best);
+    if (aborted_ || best < 0) return Result::Unknown;
+
+    bestLocal = best / 9;
+    bestCell = best % 9;
+
+    if (value > 0) return Result::Win;
+    if (value < 0) return Result::Loss;
+    return Result::Draw;
+}
+
+bool UltimateSolver::outOfBudget() {
+    if (aborted_) return true;
+    if (++nodes_ > limits_.maxNodes) {
+        aborted_ = true;
+    } else if ((nodes_ & 4095) == 0) {
+        if (std::chrono::steady_clock::now() > deadline_ || searchCancelled(limits_.cancel)) aborted_ = true;
+        if (progress_) progress_->post(0, -1, -1, 0, nodes_);
+    }
+    return aborted_;
+}
+
+int UltimateSolver::negamax(const UltimateBoard& b, int alpha, int beta, int* bestMove) {
+    if (outOfBudget()) return 0;
+
+    const quint64 key = b.hash();
+    Entry& e = table_[key & mask_];
+    int ttMove = -1;
+
+    if (e.bound != Empty && e.key == key) {
+        ttMove = (e.move == 0xFF) ? -1 : e.move;
+        if (!bestMove) {
+            if (e.bound == Exact) return e.value;
+            if (e.bound == Lower && e.value > alpha) alpha = e.value;
+            if (e.bound == Upper && e.value < beta) beta = e.value;
+            if (alpha >= beta) return e.value;
+        }
+    }
+
+    // Move order: transposition move, then moves completing a local line,
+    // then the rest. Values are only -1/0/1, so a single win ends the node.
+    int moves[81];
+    int count = 0;
+    int quiet = 81;
+
+    const quint16 allowed = b.allowedLocals();
+    if (ttMove >= 0 && !((allowed >> (ttMove / 9)) & (b.emptyCells(ttMove / 9) >> (ttMove % 9)) & 1u)) {
+        ttMove = -1;
+    }
+
+    for (int l = 0; l < 9; ++l) {
+        if (!(allowed & (1u << l))) continue;
+        const quint16 mine = (b.player == 1) ? b.x[l] : b.o[l];
+        const quint16 empty = b.emptyCells(l);
+        for (int cell = 0; cell < 9; ++cell) {
+            if (!(empty & (1u << cell))) continue;
+            const int mv = l * 9 + cell;
+            if (mv == ttMove) continue;
+            if (UltimateBoard::hasLine(static_cast<quint16>(mine | (1u << cell)))) moves[count++] = mv;
+            else moves[--quiet] = mv;
+        }
+    }
+
+    int order[82];
+    int n = 0;
+    if (ttMove >= 0) order[n++] = ttMove;
+    for (int i = 0; i < count; ++i) order[n++] = moves[i];
+    for (int i = 80; i >= quiet; --i) order[n++] = moves[i];
+
+    const int alpha0 = alpha;
+    int best = -2;
+    int bestMv = -1;
+
+    for (int i = 0; i < n; ++i) {
+        UltimateBoard child = b;
+        const UltimateBoard::PlayResult res = child.play(order[i] / 9, order[i] % 9);
+
+        int v = 0;
+        if (res == UltimateBoard::MoverWins) v = 1;
+        else if (res == UltimateBoard::Draw) v = 0;
+        else v = -negamax(child, -beta, -alpha, nullptr);
+
+        if (aborted_) return 0;
+
+        if (v > best) {
+            best = v;
+            bestMv = order[i];
+        }
+        if (v > alpha) alpha = v;
+        if (alpha >= beta) break;
+    }
+
+    e.key = key;
+    e.value = static_cast<qint8>(best);
+    e.move = static_cast<quint8>(bestMv);
+    if (best <= alpha0) e.bound = Upper;
+    else if (best >= beta) e.bound = Lower;
+    else e.bound = Exact;
+
+    if (bestMove) *bestMove = bestMv;
+    return best;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "game/ai/search_progress.h"
+#include "game/ai/ultimate_board.h"
+
+#include <chrono>
+#include <vector>
+
+// Exact win/draw/loss solver for late Ultimate positions. Alpha-beta over
+// UltimateBoard with a transposition table; gives up (Unknown) once the node
+// or time limit is hit so worst-case latency stays bounded.
+class UltimateSolver {
+public:
+    enum class Result { Unknown, Win, Draw, Loss };
+
+    struct Limits {
+        qint64 maxNodes = 2000000;
+        int maxMillis = 400;
+        const std::atomic<bool>* cancel = nullptr;  // checked with the clock
+    };
+
+    explicit UltimateSolver(int tableBits = 18);
+
+    // Result is from the point of view of the side to move in root.
+    Result solve(const UltimateBoard& root, const Limits& limits, int& bestLocal, int& bestCell);
+
+    qint64 nodes() const { return nodes_; }
+
+    // Node counts are posted here on every time check while solving.
+    void setProgress(SearchProgressChannel* progress) { progress_ = progress; }
+
+private:
+    enum Bound : quint8 { Empty = 0, Exact = 1, Lower = 2, Upper = 3 };
+
+    struct Entry {
+        quint64 key = 0;
+        qint8 value = 0;
+        quint8 bound = Empty;
+        quint8 move = 0xFF;
+    };
+
+    int negamax(const UltimateBoard& b, int alpha, int beta, int* bestMove);
+    bool outOfBudget();
+
+private:
+    std::vector<Entry> table_;
+    quint64 mask_ = 0;
+
+    Limits limits_;
+    SearchProgressChannel* progress_ = nullptr;
+    qint64 nodes_ = 0;
+    bool aborted_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+};
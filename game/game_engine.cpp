@@ -1,456 +1,553 @@
 #include "game_engine.h"
 
 #include "game/modes/classic_mode.h"
+#include "game/modes/kinarow_mode.h"
+#include "game/modes/recursive_ultimate_mode.h"
 #include "game/modes/score_mode.h"
+#include "game/modes/score_mode_fixed.h"
 #include "game/modes/ultimate_mode.h"
-
-#include <limits>
-
-static int scoreDiffForPlayer(const ScoreSnapshot& s, int player) {
-return (player == 1) ? (s.xTotal - s.oTotal) : (s.oTotal - s.xTotal);
+#include "game/ai/position_code.h"
+#include "game/ai/search_core.h"
+
+template <class Mode>
+static bool pickScoreMove(const Mode& state, int aiPlayer, int solverThreshold,
+                          const ScoreSolverLimits& limits, int& outR, int& outC,
+                          SearchProgressChannel* progress, const std::atomic<bool>* cancel) {
+const FillMode fill = state.fillMode();
+const bool deterministic = (fill != FillMode::RandomRow && fill != FillMode::RandomCol &&
+                            fill != FillMode::RandomRowOrCol);
+
+if (deterministic && state.movesLeft() <= solverThreshold) {
+    ScoreEndgameSolver<Mode> solver;
+    solver.setProgress(progress);
+    int gain = 0;
+    if (solver.solve(state, limits, outR, outC, gain)) {
+        if (progress) progress->post(state.movesLeft(), outR, outC, gain, solver.nodes());
+        return true;
+    }
 }
 
-static int classicTerminalScore(int winner, int aiPlayer, int depth) {
-if (winner == 0) return 0;
-if (winner == aiPlayer) return 10 - depth;
-return -10 + depth;
+return pickBestScoreMoveDepth2(state, aiPlayer, outR, outC, nullptr, progress, cancel);
 }
 
-static int classicMinimaxValue(const IGameMode& state, int aiPlayer, int depth) {
-const bool maximizing = (state.currentPlayer() == aiPlayer);
+GameEngine::GameEngine() {
+setMode(GameMode::Classic3x3);
+}
 
-int best = maximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
-bool any = false;
+GameEngine::~GameEngine() {
+cancelComputerMove();
+stopPondering();
+}
 
-const int N = state.boardSize();
-for (int r = 0; r < N; ++r) {
-    for (int c = 0; c < N; ++c) {
-        if (!state.isMoveAllowed(r, c)) continue;
-        any = true;
+void GameEngine::setMode(GameMode mode) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+mode_ = mode;
 
-        std::unique_ptr<IGameMode> child = state.clone();
-        MoveOutcome out = child->applyMove(r, c);
+if (mode_ == GameMode::Classic3x3) {
+    modeImpl_ = std::make_unique<ClassicMode>(classicBoardSize_);
+} else if (mode_ == GameMode::Score10x10) {
+    modeImpl_ = makeScoreMode();
+} else if (mode_ == GameMode::KInARow) {
+    modeImpl_ = std::make_unique<KInARowMode>();
+} else if (mode_ == GameMode::UltimateRecursive) {
+    modeImpl_ = std::make_unique<RecursiveUltimateMode>();
+} else {
+    modeImpl_ = std::make_unique<UltimateMode>();
+}
+attachUltimateNetwork();
+gameLog_.beginGame(*modeImpl_);
 
-        int val = 0;
-        if (out.finished) {
-            val = classicTerminalScore(out.classicWinner, aiPlayer, depth);
-        } else {
-            val = classicMinimaxValue(*child, aiPlayer, depth + 1);
-        }
 
-        if (maximizing) {
-            if (val > best) best = val;
-        } else {
-            if (val < best) best = val;
-        }
-    }
 }
 
-if (!any) return 0;
-return best;
-
+void GameEngine::setFillMode(FillMode fill) {
+if (!modeImpl_) return;
+cancelComputerMove();
+stopPondering();
+clearPonder();
+if (fill == modeImpl_->fillMode()) return;
+modeImpl_->setFillMode(fill);
 
+// The log records the fill with the game, so a game not yet started is
+// begun again; one changed midway could no longer be replayed and is
+// closed as unfinished.
+if (modeImpl_->movesMade() == 0) gameLog_.beginGame(*modeImpl_);
+else gameLog_.endGame(0, false);
 }
 
-static bool pickBestClassicMove(const IGameMode& state, int aiPlayer, int& outR, int& outC) {
-int bestVal = std::numeric_limits<int>::min();
-bool found = false;
+void GameEngine::startNewGame() {
+if (!modeImpl_) return;
+cancelComputerMove();
+stopPondering();
+clearPonder();
+modeImpl_->startNewGame();
+gameLog_.beginGame(*modeImpl_);
+}
 
-const int N = state.boardSize();
-for (int r = 0; r < N; ++r) {
-    for (int c = 0; c < N; ++c) {
-        if (!state.isMoveAllowed(r, c)) continue;
+MoveOutcome GameEngine::applyMove(int r, int c) {
+if (!modeImpl_) return MoveOutcome{};
+cancelComputerMove();
+stopPondering();
 
-        std::unique_ptr<IGameMode> child = state.clone();
-        MoveOutcome out = child->applyMove(r, c);
+const int N = modeImpl_->boardSize();
+const bool pondered = (ponderBaseMoves_ == modeImpl_->movesMade());
 
-        int val = 0;
-        if (out.finished) {
-            val = classicTerminalScore(out.classicWinner, aiPlayer, 1);
-        } else {
-            val = classicMinimaxValue(*child, aiPlayer, 2);
-        }
+MoveOutcome out = modeImpl_->applyMove(r, c);
+logMove(r, c, out);
+int reply = -1;
+if (out.accepted && pondered) {
+    std::lock_guard<std::mutex> lock(ponderMutex_);
+    reply = ponderReplies_[r * N + c];
+}
 
-        if (!found || val > bestVal) {
-            found = true;
-            bestVal = val;
-            outR = r;
-            outC = c;
-        }
-    }
+clearPonder();
+if (reply >= 0) {
+    ponderedReply_ = reply;
+    ponderedAtMoves_ = modeImpl_->movesMade();
+}
+return out;
 }
 
-return found;
+quint64 GameEngine::positionHash() const {
+return modeImpl_ ? ::positionHash(*modeImpl_) : 0;
+}
 
+bool GameEngine::scoreMoveDeltas(std::vector<ScoreMoveDelta>& out) const {
+if (auto* score = dynamic_cast<const ScoreMode10x4*>(modeImpl_.get())) {
+    score->moveDeltas(out);
+    return true;
+}
+if (auto* score = dynamic_cast<const ScoreMode*>(modeImpl_.get())) {
+    score->moveDeltas(out);
+    return true;
+}
+return false;
+}
 
+int GameEngine::activeBoardLevel() const {
+auto* recursive = dynamic_cast<const RecursiveUltimateMode*>(modeImpl_.get());
+return recursive ? recursive->forcedLevel() : -1;
 }
 
-static bool pickBestScoreMoveDepth2(const IGameMode& state, int aiPlayer, int& outR, int& outC) {
-int bestVal = std::numeric_limits<int>::min();
-bool found = false;
+bool GameEngine::isCurrentPlayerComputer() const {
+if (!modeImpl_ || !modeImpl_->isActive()) return false;
+const int p = modeImpl_->currentPlayer();
+if (p == 1) return xType_ == PlayerType::Computer;
+return oType_ == PlayerType::Computer;
+}
 
-const int N = state.boardSize();
+bool GameEngine::pickComputerMove(int& outR, int& outC) const {
+if (!modeImpl_) return false;
+return pickMoveFor(*modeImpl_, outR, outC, nullptr, ownSearch(nullptr));
+}
+
+GameEngine::SearchRequest GameEngine::ownSearch(const std::atomic<bool>* cancel) const {
+if (!ultimateSolver_) ultimateSolver_ = std::make_unique<UltimateSolver>();
+SearchRequest request;
+request.cancel = cancel;
+request.ultimateSolver = ultimateSolver_.get();
+return request;
+}
+
+bool GameEngine::pickMove(const IGameMode& state, int& outR, int& outC, const SearchRequest& request) const {
+// Outside positions do not carry this engine's network.
+if (auto* ultimate = dynamic_cast<const UltimateMode*>(&state)) {
+    const UltimateNetwork* wanted =
+        (ultimateEvaluator_ == UltimateEvaluator::Network) ? ultimateNetwork_.get() : nullptr;
+    if (ultimate->network() != wanted) {
+        UltimateMode copy = *ultimate;
+        copy.setNetwork(wanted);
+        return pickMoveFor(copy, outR, outC, nullptr, request);
+    }
+}
+return pickMoveFor(state, outR, outC, nullptr, request);
+}
 
-for (int r = 0; r < N; ++r) {
-    for (int c = 0; c < N; ++c) {
-        if (!state.isMoveAllowed(r, c)) continue;
+bool GameEngine::pickMoveFor(const IGameMode& state, int& outR, int& outC, SearchProgressChannel* progress,
+                             const SearchRequest& request) const {
+const int aiPlayer = state.currentPlayer();
+const int budgetMs = request.budgetMs;
+const std::atomic<bool>* cancel = request.cancel;
+auto capped = [budgetMs](int millis) { return budgetMs < 0 ? millis : std::min(millis, budgetMs); };
 
-        std::unique_ptr<IGameMode> afterMe = state.clone();
-        MoveOutcome out1 = afterMe->applyMove(r, c);
+// Resolve the concrete type once; the search below is then fully static.
+if (auto* classic = dynamic_cast<const ClassicMode*>(&state)) {
+    if (classic->boardSize() <= 3) {
+        return pickBestClassicMove(*classic, aiPlayer, outR, outC, std::numeric_limits<int>::max(), progress, cancel);
+    }
+    if (classicTablebase_ && classicTablebase_->pickMove(*classic, outR, outC)) return true;
+    return pickBestClassicMove(*classic, aiPlayer, outR, outC, classicSearchDepth_, progress, cancel);
+}
 
-        int val = 0;
-        if (out1.finished) {
-            val = scoreDiffForPlayer(out1.score, aiPlayer);
-        } else {
-            int worstForMe = std::numeric_limits<int>::max();
-            bool oppFound = false;
+if (auto* kinarow = dynamic_cast<const KInARowMode*>(&state)) {
+    KInARowProver::Limits limits = kInARowProverLimits_;
+    limits.maxMillis = capped(limits.maxMillis);
+    limits.cancel = cancel;
+    KInARowProver prover;
+    prover.setProgress(progress);
+    if (budgetMs != 0 && prover.solve(*kinarow, limits, outR, outC) == KInARowProver::Result::Win) return true;
+    if (searchCancelled(cancel)) return false;
+    return pickBestKInARowMove(*kinarow, aiPlayer, outR, outC, progress);
+}
 
-            for (int rr = 0; rr < N; ++rr) {
-                for (int cc = 0; cc < N; ++cc) {
-                    if (!afterMe->isMoveAllowed(rr, cc)) continue;
+if (auto* recursive = dynamic_cast<const RecursiveUltimateMode*>(&state)) {
+    return pickBestRecursiveUltimateMove(*recursive, aiPlayer, outR, outC, progress, cancel);
+}
 
-                    oppFound = true;
-                    std::unique_ptr<IGameMode> afterOpp = afterMe->clone();
-                    MoveOutcome out2 = afterOpp->applyMove(rr, cc);
+ScoreSolverLimits scoreLimits = scoreSolverLimits_;
+scoreLimits.maxMillis = capped(scoreLimits.maxMillis);
+scoreLimits.cancel = cancel;
+const int scoreThreshold = (budgetMs == 0) ? -1 : scoreSolverThreshold_;
 
-                    int d = scoreDiffForPlayer(out2.score, aiPlayer);
-                    if (d < worstForMe) worstForMe = d;
-                }
-            }
+if (auto* score = dynamic_cast<const ScoreMode10x4*>(&state)) {
+    return pickScoreMove(*score, aiPlayer, scoreThreshold, scoreLimits, outR, outC, progress, cancel);
+}
 
-            val = oppFound ? worstForMe : scoreDiffForPlayer(out1.score, aiPlayer);
-        }
+if (auto* score = dynamic_cast<const ScoreMode*>(&state)) {
+    return pickScoreMove(*score, aiPlayer, scoreThreshold, scoreLimits, outR, outC, progress, cancel);
+}
 
-        if (!found || val > bestVal) {
-            found = true;
-            bestVal = val;
-            outR = r;
-            outC = c;
+if (auto* ultimate = dynamic_cast<const UltimateMode*>(&state)) {
+    int bookScore = 0;
+    if (ultimateBook_ && ultimateBook_->probe(UltimateBoard::fromMode(*ultimate), outR, outC, &bookScore)) {
+        if (progress) progress->post(ultimateBook_->depth(), outR, outC, bookScore, 0);
+        return true;
+    }
+    if (budgetMs != 0 && ultimate->movesLeft() <= ultimateSolverThreshold_) {
+        UltimateSolver::Limits limits = ultimateSolverLimits_;
+        limits.maxMillis = capped(limits.maxMillis);
+        limits.cancel = cancel;
+        // The caller's solver keeps its 4 MB table between moves; entries
+        // hold exact game values of whole positions and stay valid from one
+        // root to the next.
+        std::unique_ptr<UltimateSolver> fresh;
+        if (!request.ultimateSolver) fresh = std::make_unique<UltimateSolver>();
+        UltimateSolver& solver = request.ultimateSolver ? *request.ultimateSolver : *fresh;
+        solver.setProgress(progress);
+        int local = -1, cell = -1;
+        const UltimateSolver::Result res = solver.solve(UltimateBoard::fromMode(*ultimate), limits, local, cell);
+        if (res == UltimateSolver::Result::Win || res == UltimateSolver::Result::Draw) {
+            outR = UltimateBoard::rowOf(local, cell);
+            outC = UltimateBoard::colOf(local, cell);
+            return true;
         }
     }
+    return pickBestUltimateMoveDepth2(*ultimate, aiPlayer, outR, outC, nullptr, progress, ultimateParams_, cancel);
 }
 
-return found;
-
-
+return false;
 }
 
-static int ultimateTerminalScore(int winner, int aiPlayer, int depth) {
-if (winner == 0) return 0;
-if (winner == aiPlayer) return 100000 - depth;
-return -100000 + depth;
-}
+MoveOutcome GameEngine::doComputerMove() {
+MoveOutcome out;
+out.accepted = false;
 
-static int localWinner9(const IGameMode& state, int br, int bc) {
-auto at = [&](int rr, int cc) -> int {
-return state.cellOwner(br * 3 + rr, bc * 3 + cc);
-};
+if (!modeImpl_ || !modeImpl_->isActive()) return out;
+if (!isCurrentPlayerComputer()) return out;
 
-for (int r = 0; r < 3; ++r) {
-    int s = at(r, 0) + at(r, 1) + at(r, 2);
-    if (s == 3) return 1;
-    if (s == -3) return -1;
-}
+cancelComputerMove();
+stopPondering();
 
-for (int c = 0; c < 3; ++c) {
-    int s = at(0, c) + at(1, c) + at(2, c);
-    if (s == 3) return 1;
-    if (s == -3) return -1;
+const int N = modeImpl_->boardSize();
+int r = -1, c = -1;
+if (hasPonderedReply()) {
+    r = ponderedReply_ / N;
+    c = ponderedReply_ % N;
+} else if (!pickComputerMove(r, c)) {
+    return out;
 }
 
-int d1 = at(0, 0) + at(1, 1) + at(2, 2);
-int d2 = at(0, 2) + at(1, 1) + at(2, 0);
-
-if (d1 == 3 || d2 == 3) return 1;
-if (d1 == -3 || d2 == -3) return -1;
+clearPonder();
+out = modeImpl_->applyMove(r, c);
+logMove(r, c, out);
+return out;
+}
 
-return 0;
+bool GameEngine::startComputerMove() {
+cancelComputerMove();
+if (!modeImpl_ || !isCurrentPlayerComputer()) return false;
 
+stopPondering();
+thinkPending_ = true;
+thinkAtMoves_ = modeImpl_->movesMade();
 
+if (hasPonderedReply()) {
+    thinkMove_ = ponderedReply_;
+    thinkDone_ = true;
+    return true;
 }
 
-static bool localFull9(const IGameMode& state, int br, int bc) {
-for (int rr = 0; rr < 3; ++rr) {
-for (int cc = 0; cc < 3; ++cc) {
-if (state.cellOwner(br * 3 + rr, bc * 3 + cc) == 0) return false;
-}
-}
+thinkMove_ = -1;
+thinkDone_ = false;
+thinkStop_ = false;
+ownSearch(nullptr);  // creates the solver before the thread uses it
+thinkThread_ = std::thread(&GameEngine::thinkWorker, this, modeImpl_->clone());
 return true;
 }
 
-static int macroWinner9(const int localState[9]) {
-auto v = [&](int r, int c) -> int {
-const int idx = r * 3 + c;
-const int s = localState[idx];
-if (s == 2) return 0;
-return s;
-};
-
-for (int r = 0; r < 3; ++r) {
-    int s = v(r, 0) + v(r, 1) + v(r, 2);
-    if (s == 3) return 1;
-    if (s == -3) return -1;
+bool GameEngine::isThinking() const {
+return thinkPending_ && !thinkDone_.load(std::memory_order_acquire);
 }
 
-for (int c = 0; c < 3; ++c) {
-    int s = v(0, c) + v(1, c) + v(2, c);
-    if (s == 3) return 1;
-    if (s == -3) return -1;
-}
-
-int d1 = v(0, 0) + v(1, 1) + v(2, 2);
-int d2 = v(0, 2) + v(1, 1) + v(2, 0);
-
-if (d1 == 3 || d2 == 3) return 1;
-if (d1 == -3 || d2 == -3) return -1;
-
-return 0;
+MoveOutcome GameEngine::finishComputerMove() {
+MoveOutcome out;
+out.accepted = false;
+if (!thinkPending_ || !thinkDone_.load(std::memory_order_acquire)) return out;
 
+if (thinkThread_.joinable()) thinkThread_.join();
+thinkPending_ = false;
+if (thinkMove_ < 0 || !modeImpl_ || modeImpl_->movesMade() != thinkAtMoves_) return out;
 
+const int N = modeImpl_->boardSize();
+clearPonder();
+out = modeImpl_->applyMove(thinkMove_ / N, thinkMove_ % N);
+logMove(thinkMove_ / N, thinkMove_ % N, out);
+return out;
 }
 
-static int ultimateHeuristic(const IGameMode& state, int aiPlayer) {
-int localState[9];
-
-for (int br = 0; br < 3; ++br) {
-    for (int bc = 0; bc < 3; ++bc) {
-        const int idx = br * 3 + bc;
-        const int w = localWinner9(state, br, bc);
-        if (w != 0) localState[idx] = w;
-        else if (localFull9(state, br, bc)) localState[idx] = 2;
-        else localState[idx] = 0;
-    }
+void GameEngine::cancelComputerMove() {
+if (thinkThread_.joinable()) {
+    thinkStop_ = true;
+    thinkThread_.join();
 }
-
-const int mw = macroWinner9(localState);
-if (mw == aiPlayer) return 90000;
-if (mw == -aiPlayer) return -90000;
-
-int score = 0;
-
-for (int i = 0; i < 9; ++i) {
-    if (localState[i] == aiPlayer) score += 220;
-    else if (localState[i] == -aiPlayer) score -= 240;
-    else if (localState[i] == 2) score += 0;
+thinkPending_ = false;
+thinkDone_ = false;
 }
 
-const int macroLines[8][3] = {
-    {0,1,2},{3,4,5},{6,7,8},
-    {0,3,6},{1,4,7},{2,5,8},
-    {0,4,8},{2,4,6}
-};
+void GameEngine::thinkWorker(std::unique_ptr<IGameMode> state) {
+searchProgress_.begin();
 
-for (int k = 0; k < 8; ++k) {
-    int sum = 0;
-    int empties = 0;
-    int blocked = 0;
-    for (int j = 0; j < 3; ++j) {
-        const int idx = macroLines[k][j];
-        if (localState[idx] == 2) {
-            blocked++;
-            continue;
-        }
-        sum += localState[idx];
-        if (localState[idx] == 0) empties++;
-    }
-
-    if (blocked == 0) {
-        if (sum == 2 * aiPlayer && empties == 1) score += 700;
-        if (sum == -2 * aiPlayer && empties == 1) score -= 900;
-        if (sum == aiPlayer && empties == 2) score += 90;
-        if (sum == -aiPlayer && empties == 2) score -= 130;
-    } else {
-        if (sum == 2 * aiPlayer && empties == 1) score += 180;
-        if (sum == -2 * aiPlayer && empties == 1) score -= 230;
-        if (sum == aiPlayer && empties == 2) score += 25;
-        if (sum == -aiPlayer && empties == 2) score -= 35;
-    }
+const int N = state->boardSize();
+int r = -1, c = -1;
+thinkMove_ = pickMoveFor(*state, r, c, &searchProgress_, ownSearch(&thinkStop_)) ? r * N + c : -1;
+thinkDone_.store(true, std::memory_order_release);
 }
 
-for (int br = 0; br < 3; ++br) {
-    for (int bc = 0; bc < 3; ++bc) {
-        const int idx = br * 3 + bc;
-        if (localState[idx] != 0) continue;
-
-        auto at = [&](int rr, int cc) -> int {
-            return state.cellOwner(br * 3 + rr, bc * 3 + cc);
-        };
-
-        for (int r = 0; r < 3; ++r) {
-            int a = at(r, 0), b = at(r, 1), c = at(r, 2);
-            int sum = a + b + c;
-            int empty = (a == 0) + (b == 0) + (c == 0);
-            if (sum == 2 * aiPlayer && empty == 1) score += 28;
-            if (sum == -2 * aiPlayer && empty == 1) score -= 34;
-            if (sum == aiPlayer && empty == 2) score += 4;
-            if (sum == -aiPlayer && empty == 2) score -= 6;
-        }
-
-        for (int c = 0; c < 3; ++c) {
-            int a = at(0, c), b = at(1, c), d = at(2, c);
-            int sum = a + b + d;
-            int empty = (a == 0) + (b == 0) + (d == 0);
-            if (sum == 2 * aiPlayer && empty == 1) score += 28;
-            if (sum == -2 * aiPlayer && empty == 1) score -= 34;
-            if (sum == aiPlayer && empty == 2) score += 4;
-            if (sum == -aiPlayer && empty == 2) score -= 6;
-        }
+bool GameEngine::setGameLogPath(const QString& path, QString* error) {
+gameLog_.close();
+if (path.isEmpty()) return true;
+return gameLog_.open(path, error);
+}
 
-        {
-            int a = at(0, 0), b = at(1, 1), c = at(2, 2);
-            int sum = a + b + c;
-            int empty = (a == 0) + (b == 0) + (c == 0);
-            if (sum == 2 * aiPlayer && empty == 1) score += 28;
-            if (sum == -2 * aiPlayer && empty == 1) score -= 34;
-            if (sum == aiPlayer && empty == 2) score += 4;
-            if (sum == -aiPlayer && empty == 2) score -= 6;
-        }
+void GameEngine::logMove(int r, int c, const MoveOutcome& out) {
+if (!out.accepted || !gameLog_.inGame()) return;
+gameLog_.addMove(r, c);
+if (!out.finished) return;
 
-        {
-            int a = at(0, 2), b = at(1, 1), c = at(2, 0);
-            int sum = a + b + c;
-            int empty = (a == 0) + (b == 0) + (c == 0);
-            if (sum == 2 * aiPlayer && empty == 1) score += 28;
-            if (sum == -2 * aiPlayer && empty == 1) score -= 34;
-            if (sum == aiPlayer && empty == 2) score += 4;
-            if (sum == -aiPlayer && empty == 2) score -= 6;
-        }
-    }
+int result = out.classicWinner;
+if (mode_ == GameMode::Score10x10) {
+    result = (out.score.xTotal > out.score.oTotal) ? 1 : (out.score.oTotal > out.score.xTotal ? -1 : 0);
+}
+gameLog_.endGame(result);
 }
 
-if (localState[4] == aiPlayer) score += 60;
-else if (localState[4] == -aiPlayer) score -= 70;
-
-return score;
+void GameEngine::setPonderEnabled(bool on) {
+ponderEnabled_ = on;
+if (!on) {
+    stopPondering();
+    clearPonder();
+}
+}
 
+void GameEngine::setClassicTablebasePath(const QString& path) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+if (path.isEmpty()) classicTablebase_.reset();
+else classicTablebase_ = std::make_unique<ClassicTablebase>(path);
+}
 
+void GameEngine::setClassicSearchDepth(int plies) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+classicSearchDepth_ = plies;
 }
 
-static bool pickBestUltimateMoveDepth2(const IGameMode& state, int aiPlayer, int& outR, int& outC) {
-int bestVal = std::numeric_limits<int>::min();
-bool found = false;
+KInARowProver::Result GameEngine::analyseKInARow(int& bestR, int& bestC,
+                                                const KInARowProver::Limits& limits) const {
+auto* kinarow = dynamic_cast<const KInARowMode*>(modeImpl_.get());
+if (!kinarow || !kinarow->isActive()) return KInARowProver::Result::Unknown;
 
-const int N = state.boardSize();
+KInARowProver prover;
+return prover.solve(*kinarow, limits, bestR, bestC);
+}
 
-for (int r = 0; r < N; ++r) {
-    for (int c = 0; c < N; ++c) {
-        if (!state.isMoveAllowed(r, c)) continue;
+void GameEngine::setKInARowProverLimits(const KInARowProver::Limits& limits) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+kInARowProverLimits_ = limits;
+}
 
-        std::unique_ptr<IGameMode> afterMe = state.clone();
-        MoveOutcome out1 = afterMe->applyMove(r, c);
+void GameEngine::setUltimateSolverThreshold(int emptyCells) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+ultimateSolverThreshold_ = emptyCells;
+}
 
-        int val = 0;
-        if (out1.finished) {
-            val = ultimateTerminalScore(out1.classicWinner, aiPlayer, 1);
-        } else {
-            int worstForMe = std::numeric_limits<int>::max();
-            bool oppFound = false;
+void GameEngine::setUltimateSolverLimits(const UltimateSolver::Limits& limits) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+ultimateSolverLimits_ = limits;
+}
 
-            for (int rr = 0; rr < N; ++rr) {
-                for (int cc = 0; cc < N; ++cc) {
-                    if (!afterMe->isMoveAllowed(rr, cc)) continue;
+bool GameEngine::setUltimateNetworkPath(const QString& path, QString* error) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+analyzer_.stop();
 
-                    oppFound = true;
-                    std::unique_ptr<IGameMode> afterOpp = afterMe->clone();
-                    MoveOutcome out2 = afterOpp->applyMove(rr, cc);
+// Positions copied from the mode point at the network, so it is detached
+// before it is replaced.
+ultimateNetwork_.reset();
+attachUltimateNetwork();
+if (path.isEmpty()) return true;
 
-                    int d = 0;
-                    if (out2.finished) {
-                        d = ultimateTerminalScore(out2.classicWinner, aiPlayer, 2);
-                    } else {
-                        d = ultimateHeuristic(*afterOpp, aiPlayer);
-                    }
+auto network = std::make_unique<UltimateNetwork>();
+if (!network->load(path, error)) return false;
+ultimateNetwork_ = std::move(network);
+attachUltimateNetwork();
+return true;
+}
 
-                    if (d < worstForMe) worstForMe = d;
-                }
-            }
+bool GameEngine::setUltimateBookPath(const QString& path, QString* error) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+ultimateBook_.reset();
+if (path.isEmpty()) return true;
 
-            val = oppFound ? worstForMe : ultimateHeuristic(*afterMe, aiPlayer);
-        }
+auto book = std::make_unique<UltimateOpeningBook>();
+if (!book->open(path, error)) return false;
+ultimateBook_ = std::move(book);
+return true;
+}
 
-        if (!found || val > bestVal) {
-            found = true;
-            bestVal = val;
-            outR = r;
-            outC = c;
-        }
-    }
+void GameEngine::setUltimateEvaluator(UltimateEvaluator evaluator) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+analyzer_.stop();
+ultimateEvaluator_ = evaluator;
+attachUltimateNetwork();
 }
 
-return found;
+void GameEngine::setUltimateHeuristicParams(const UltimateHeuristicParams& params) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+analyzer_.stop();
+ultimateParams_ = params;
+}
 
+void GameEngine::attachUltimateNetwork() {
+auto* ultimate = dynamic_cast<UltimateMode*>(modeImpl_.get());
+if (!ultimate) return;
+const bool useNetwork = (ultimateEvaluator_ == UltimateEvaluator::Network);
+ultimate->setNetwork(useNetwork ? ultimateNetwork_.get() : nullptr);
+}
 
+void GameEngine::setScoreSolverThreshold(int movesLeft) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+scoreSolverThreshold_ = movesLeft;
 }
 
-GameEngine::GameEngine() {
-setMode(GameMode::Classic3x3);
+void GameEngine::setScoreSolverLimits(const ScoreSolverLimits& limits) {
+cancelComputerMove();
+stopPondering();
+clearPonder();
+scoreSolverLimits_ = limits;
 }
 
-void GameEngine::setMode(GameMode mode) {
-mode_ = mode;
+void GameEngine::startPondering() {
+if (!ponderEnabled_ || !modeImpl_ || !modeImpl_->isActive()) return;
+if (ponderThread_.joinable()) return;
+if (isCurrentPlayerComputer()) return;
 
-if (mode_ == GameMode::Classic3x3) {
-    modeImpl_ = std::make_unique<ClassicMode>();
-} else if (mode_ == GameMode::Score10x10) {
-    modeImpl_ = std::make_unique<ScoreMode>();
-} else {
-    modeImpl_ = std::make_unique<UltimateMode>();
-}
+const PlayerType next = (modeImpl_->currentPlayer() == 1) ? oType_ : xType_;
+if (next != PlayerType::Computer) return;
 
+// The stripe after the human's move is drawn at random, so there is no one
+// position to prepare a reply for.
+const FillMode fill = modeImpl_->fillMode();
+if (fill == FillMode::RandomRow || fill == FillMode::RandomCol || fill == FillMode::RandomRowOrCol) return;
 
+const int N = modeImpl_->boardSize();
+{
+    std::lock_guard<std::mutex> lock(ponderMutex_);
+    ponderReplies_.assign(N * N, -1);
 }
-
-void GameEngine::setFillMode(FillMode fill) {
-if (!modeImpl_) return;
-modeImpl_->setFillMode(fill);
+ponderBaseMoves_ = modeImpl_->movesMade();
+ponderStop_ = false;
+ownSearch(nullptr);  // creates the solver before the thread uses it
+std::unique_ptr<IGameMode> base = modeImpl_->clone();
+base->reseedForSearch();
+ponderThread_ = std::thread(&GameEngine::ponderWorker, this, std::move(base));
 }
 
-void GameEngine::startNewGame() {
-if (!modeImpl_) return;
-modeImpl_->startNewGame();
+void GameEngine::startAnalysis(int threads) {
+if (!modeImpl_ || !modeImpl_->isActive()) {
+    analyzer_.stop();
+    return;
 }
-
-MoveOutcome GameEngine::applyMove(int r, int c) {
-if (!modeImpl_) return MoveOutcome{};
-return modeImpl_->applyMove(r, c);
+std::unique_ptr<IGameMode> position = modeImpl_->clone();
+position->reseedForSearch();
+analyzer_.start(std::move(position), threads, ultimateParams_);
 }
 
-bool GameEngine::isCurrentPlayerComputer() const {
-if (!modeImpl_ || !modeImpl_->isActive()) return false;
-const int p = modeImpl_->currentPlayer();
-if (p == 1) return xType_ == PlayerType::Computer;
-return oType_ == PlayerType::Computer;
+void GameEngine::stopPondering() {
+if (!ponderThread_.joinable()) return;
+ponderStop_ = true;
+ponderThread_.join();
 }
 
-bool GameEngine::pickComputerMove(int& outR, int& outC) const {
-if (!modeImpl_) return false;
-
-const int aiPlayer = modeImpl_->currentPlayer();
-
-if (modeImpl_->mode() == GameMode::Classic3x3) {
-    return pickBestClassicMove(*modeImpl_, aiPlayer, outR, outC);
+bool GameEngine::hasPonderedReply() const {
+if (!modeImpl_ || ponderedReply_ < 0 || ponderedAtMoves_ != modeImpl_->movesMade()) return false;
+const int N = modeImpl_->boardSize();
+return modeImpl_->isMoveAllowed(ponderedReply_ / N, ponderedReply_ % N);
 }
 
-if (modeImpl_->mode() == GameMode::Score10x10) {
-    return pickBestScoreMoveDepth2(*modeImpl_, aiPlayer, outR, outC);
+void GameEngine::clearPonder() {
+std::lock_guard<std::mutex> lock(ponderMutex_);
+ponderReplies_.clear();
+ponderBaseMoves_ = -1;
+ponderedReply_ = -1;
+ponderedAtMoves_ = -1;
 }
 
-return pickBestUltimateMoveDepth2(*modeImpl_, aiPlayer, outR, outC);
+void GameEngine::ponderWorker(std::unique_ptr<IGameMode> base) {
+const int N = base->boardSize();
 
+std::vector<int> order;
+order.reserve(N * N);
 
+int predictedR = -1, predictedC = -1;
+if (ponderStop_) return;
+const SearchRequest request = ownSearch(&ponderStop_);
+if (pickMoveFor(*base, predictedR, predictedC, nullptr, request)) order.push_back(predictedR * N + predictedC);
+for (int idx = 0; idx < N * N; ++idx) {
+    if (order.empty() || order.front() != idx) order.push_back(idx);
 }
 
-MoveOutcome GameEngine::doComputerMove() {
-MoveOutcome out;
-out.accepted = false;
+for (int idx : order) {
+    if (ponderStop_) return;
+    if (!base->isMoveAllowed(idx / N, idx % N)) continue;
 
-if (!modeImpl_ || !modeImpl_->isActive()) return out;
-if (!isCurrentPlayerComputer()) return out;
-
-int r = -1, c = -1;
-if (!pickComputerMove(r, c)) return out;
-
-return modeImpl_->applyMove(r, c);
+    std::unique_ptr<IGameMode> child = base->clone();
+    MoveOutcome out = child->applyMove(idx / N, idx % N);
+    if (!out.accepted || out.finished) continue;
 
+    int r = -1, c = -1;
+    if (!pickMoveFor(*child, r, c, nullptr, request)) continue;
 
+    std::lock_guard<std::mutex> lock(ponderMutex_);
+    ponderReplies_[idx] = r * N + c;
+}
 }
@@ -2,13 +2,38 @@
 
 #include "game/game_types.h"
 #include "game/modes/igame_mode.h"
+#include "game/ai/classic_tablebase.h"
+#include "game/ai/kinarow_prover.h"
+#include "game/ai/move_analysis.h"
+#include "game/ai/score_solver.h"
+#include "game/ai/search_progress.h"
+#include "game/ai/ultimate_book.h"
+#include "game/ai/ultimate_network.h"
+#include "game/ai/ultimate_params.h"
+#include "game/ai/ultimate_solver.h"
+#include "game/log/game_log.h"
+#include "game/score/score_helpers.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class UltimateEvaluator { Heuristic, Network };
 
 class GameEngine {
 public:
     GameEngine();
+    ~GameEngine();
+
+    GameEngine(const GameEngine&) = delete;
+    GameEngine& operator=(const GameEngine&) = delete;
 
     void setMode(GameMode mode);
+
+    // Classic board size, applied on the next setMode(Classic3x3).
+    void setClassicBoardSize(int n) { classicBoardSize_ = n; }
+    int classicBoardSize() const { return classicBoardSize_; }
     void setFillMode(FillMode fill);
 
     void setPlayerTypeX(PlayerType t) { xType_ = t; }
@@ -38,17 +63,196 @@ public:
     int activeRow() const { return modeImpl_ ? modeImpl_->activeRow() : -1; }
     int activeCol() const { return modeImpl_ ? modeImpl_->activeCol() : -1; }
 
+    // Level of the board activeRow/activeCol refer to in recursive Ultimate
+    // (1 = a block of cells); -1 for a free move and in other modes.
+    int activeBoardLevel() const;
+
     ScoreSnapshot currentScore() const { return modeImpl_ ? modeImpl_->currentScore() : ScoreSnapshot{}; }
 
+    // Score only: what each move would add to the side to move's line score
+    // and spend (see ScoreMoveDelta), all cells in one pass. False in other
+    // modes.
+    bool scoreMoveDeltas(std::vector<ScoreMoveDelta>& out) const;
+
+    // Stable key of the current position (see position_code.h).
+    quint64 positionHash() const;
+
     bool isCurrentPlayerComputer() const;
     MoveOutcome doComputerMove();
 
+    // Per-call settings of a search.
+    struct SearchRequest {
+        // >= 0 caps the time limits of the endgame solvers and the
+        // K-in-a-row prover; 0 skips them for the heuristic search.
+        int budgetMs = -1;
+        // Once set, the search gives up and reports no move.
+        const std::atomic<bool>* cancel = nullptr;
+        // Scratch Ultimate solver, so its table is allocated once per caller
+        // instead of once per late Ultimate move. Used by one search at a
+        // time; null allocates a fresh one when needed.
+        UltimateSolver* ultimateSolver = nullptr;
+    };
+
+    // The computer's move in a position the caller owns, with this engine's
+    // settings (solvers, depths, tables, Ultimate evaluator); the engine's
+    // own game is not touched. Safe to call from several threads while the
+    // settings stay unchanged, as long as they do not share a solver.
+    bool pickMove(const IGameMode& state, int& outR, int& outC, const SearchRequest& request) const;
+    bool pickMove(const IGameMode& state, int& outR, int& outC) const {
+        return pickMove(state, outR, outC, SearchRequest());
+    }
+
+    // A copy of the current position, e.g. to search it elsewhere.
+    std::unique_ptr<IGameMode> clonePosition() const { return modeImpl_ ? modeImpl_->clone() : nullptr; }
+
+    // The computer's move searched on a background thread, for callers that
+    // must stay responsive. startComputerMove() returns false when the
+    // computer is not to move; while isThinking(), searchProgress() holds
+    // the search's latest depth, best move, score and node counts. Once the
+    // search is done, finishComputerMove() plays the move (accepted=false
+    // while still thinking). Every other call that changes the game or the
+    // search settings cancels a running search first: the search polls a
+    // stop flag, so the wait is short.
+    bool startComputerMove();
+    bool isThinking() const;
+    MoveOutcome finishComputerMove();
+    void cancelComputerMove();
+    const SearchProgressChannel& searchProgress() const { return searchProgress_; }
+
+    // Pondering: while a human is to move against the computer, a background
+    // thread searches the computer's reply to each human move (the predicted
+    // one first). If the move actually played was covered, doComputerMove
+    // answers without searching. stopPondering() stops the searches through
+    // the same kind of flag before joining.
+    void setPonderEnabled(bool on);
+    bool ponderEnabled() const { return ponderEnabled_; }
+    void startPondering();
+    void stopPondering();
+    // True when the computer's reply in the current position was pondered,
+    // so startComputerMove() finishes at once.
+    bool hasPonderedReply() const;
+
+    // Move analysis: scores every legal move of the current position on
+    // background threads (see MoveAnalyzer). The analysis keeps its own copy
+    // of the position, so moves played meanwhile do not disturb it; callers
+    // restart it when the position changes.
+    void startAnalysis(int threads = 0);
+    void stopAnalysis() { analyzer_.stop(); }
+    bool isAnalysing() const { return analyzer_.isRunning(); }
+    bool analysis(std::vector<MoveEval>& out, quint64& version) const { return analyzer_.results(out, version); }
+
+    // Ultimate positions with at most this many empty playable cells are
+    // handed to the exact solver first; the heuristic search is used when the
+    // solver hits its limits or proves a loss.
+    void setUltimateSolverThreshold(int emptyCells);
+    int ultimateSolverThreshold() const { return ultimateSolverThreshold_; }
+    void setUltimateSolverLimits(const UltimateSolver::Limits& limits);
+    UltimateSolver::Limits ultimateSolverLimits() const { return ultimateSolverLimits_; }
+
+    // Leaf evaluation of the Ultimate search: the hand-written heuristic or
+    // a quantised network (see UltimateNetwork) loaded from a file. The
+    // network is only used once one has loaded; an empty path unloads it.
+    bool setUltimateNetworkPath(const QString& path, QString* error = nullptr);
+    bool hasUltimateNetwork() const { return ultimateNetwork_ != nullptr; }
+    void setUltimateEvaluator(UltimateEvaluator evaluator);
+    UltimateEvaluator ultimateEvaluator() const { return ultimateEvaluator_; }
+
+    // Opening book for Ultimate (see UltimateOpeningBook), mapped here and
+    // probed before any search, whatever the evaluator. An empty path
+    // closes it.
+    bool setUltimateBookPath(const QString& path, QString* error = nullptr);
+    bool hasUltimateBook() const { return ultimateBook_ != nullptr; }
+
+    // Weights of the Ultimate heuristic, e.g. from the tune_ultimate tool.
+    void setUltimateHeuristicParams(const UltimateHeuristicParams& params);
+    const UltimateHeuristicParams& ultimateHeuristicParams() const { return ultimateParams_; }
+
+    // Score games with at most this many moves left are solved exactly for
+    // the final total difference, within the time budget. Deterministic fill
+    // modes only.
+    void setScoreSolverThreshold(int movesLeft);
+    int scoreSolverThreshold() const { return scoreSolverThreshold_; }
+    void setScoreSolverLimits(const ScoreSolverLimits& limits);
+    ScoreSolverLimits scoreSolverLimits() const { return scoreSolverLimits_; }
+
+    // Classic boards above 3x3 look moves up in this tablebase (mapped on
+    // first use) and fall back to a depth-limited search without it.
+    void setClassicTablebasePath(const QString& path);
+    void setClassicSearchDepth(int plies);
+    int classicSearchDepth() const { return classicSearchDepth_; }
+
+    // Threat-space proof search on the current K-in-a-row position, from the
+    // side to move's point of view. Unknown in other modes. For Win,
+    // bestR/bestC starts the forced sequence.
+    KInARowProver::Result analyseKInARow(int& bestR, int& bestC,
+                                         const KInARowProver::Limits& limits = KInARowProver::Limits()) const;
+
+    // Budget of the proof search the computer runs before falling back to
+    // its heuristic move in K-in-a-row.
+    void setKInARowProverLimits(const KInARowProver::Limits& limits);
+    KInARowProver::Limits kInARowProverLimits() const { return kInARowProverLimits_; }
+
+    // Appends every game started from now on to a binary log (see
+    // GameLogWriter); games abandoned midway are kept as unfinished. An
+    // empty path stops recording.
+    bool setGameLogPath(const QString& path, QString* error = nullptr);
+    bool isRecording() const { return gameLog_.isOpen(); }
+
 private:
     bool pickComputerMove(int& outR, int& outC) const;
+    void logMove(int r, int c, const MoveOutcome& out);
+    bool pickMoveFor(const IGameMode& state, int& outR, int& outC, SearchProgressChannel* progress,
+                     const SearchRequest& request) const;
+    SearchRequest ownSearch(const std::atomic<bool>* cancel) const;
+    void thinkWorker(std::unique_ptr<IGameMode> state);
+    void attachUltimateNetwork();
+
+    void ponderWorker(std::unique_ptr<IGameMode> base);
+    void clearPonder();
 
 private:
     GameMode mode_ = GameMode::Classic3x3;
     PlayerType xType_ = PlayerType::Human;
     PlayerType oType_ = PlayerType::Human;
     std::unique_ptr<IGameMode> modeImpl_;
+
+    int classicBoardSize_ = 3;
+    std::unique_ptr<ClassicTablebase> classicTablebase_;
+    int classicSearchDepth_ = 4;
+
+    KInARowProver::Limits kInARowProverLimits_{ 20000, 30 };
+
+    int ultimateSolverThreshold_ = 24;
+    UltimateSolver::Limits ultimateSolverLimits_;
+    // The solver of this engine's own searches (think, ponder, doComputerMove),
+    // which never run at the same time; created on first use.
+    mutable std::unique_ptr<UltimateSolver> ultimateSolver_;
+
+    std::unique_ptr<UltimateOpeningBook> ultimateBook_;
+    std::unique_ptr<UltimateNetwork> ultimateNetwork_;
+    UltimateEvaluator ultimateEvaluator_ = UltimateEvaluator::Heuristic;
+    UltimateHeuristicParams ultimateParams_;
+
+    int scoreSolverThreshold_ = 6;
+    ScoreSolverLimits scoreSolverLimits_;
+
+    GameLogWriter gameLog_;
+
+    bool ponderEnabled_ = false;
+    std::thread ponderThread_;
+    std::atomic<bool> ponderStop_{false};
+    std::mutex ponderMutex_;
+    std::vector<int> ponderReplies_;
+    int ponderBaseMoves_ = -1;
+    int ponderedReply_ = -1;
+    int ponderedAtMoves_ = -1;
+
+    std::thread thinkThread_;
+    std::atomic<bool> thinkDone_{false};
+    std::atomic<bool> thinkStop_{false};
+    bool thinkPending_ = false;
+    int thinkMove_ = -1;
+    int thinkAtMoves_ = -1;
+    SearchProgressChannel searchProgress_;
+    MoveAnalyzer analyzer_;
 };
@@ -0,0 +1,117 @@
+#include "game_series.h"
+
+#include "game/game_engine.h"
+#include "game/log/stats_store.h"
+
+#include <chrono>
+
+GameSeries::~GameSeries() {
+    stop();
+}
+
+void GameSeries::start(const SeriesOptions& options, StatsStore* stats) {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_ = SeriesProgress();
+        progress_.games = options.games;
+        progress_.running = true;
+        version_++;
+    }
+
+    stop_.store(false);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&GameSeries::run, this, options, stats);
+}
+
+void GameSeries::stop() {
+    stop_.store(true);
+    if (thread_.joinable()) thread_.join();
+}
+
+bool GameSeries::progress(SeriesProgress& out, quint64& version) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version == version_) return false;
+    out = progress_;
+    version = version_;
+    return true;
+}
+
+void GameSeries::run(SeriesOptions options, StatsStore* stats) {
+    const auto started = std::chrono::steady_clock::now();
+    auto elapsedMs = [&started]() {
+        return static_cast<qint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count());
+    };
+
+    GameEngine engine;
+    if (!options.classicTablebasePath.isEmpty()) engine.setClassicTablebasePath(options.classicTablebasePath);
+    engine.setUltimateHeuristicParams(options.ultimateParams);
+    if (!options.ultimateBookPath.isEmpty()) engine.setUltimateBookPath(options.ultimateBookPath);
+    if (!options.ultimateNetworkPath.isEmpty() && engine.setUltimateNetworkPath(options.ultimateNetworkPath)) {
+        engine.setUltimateEvaluator(UltimateEvaluator::Network);
+    }
+    engine.setClassicBoardSize(options.classicBoardSize);
+    engine.setMode(options.mode);
+    engine.setFillMode(options.fill);
+    engine.setPlayerTypeX(PlayerType::Computer);
+    engine.setPlayerTypeO(PlayerType::Computer);
+
+    std::vector<qint8> cells;
+    for (int g = 0; g < options.games && !stop_.load(std::memory_order_relaxed); ++g) {
+        engine.startNewGame();
+
+        const int N = engine.boardSize();
+        cells.assign(static_cast<size_t>(N) * N, 0);
+
+        while (engine.isActive() && !stop_.load(std::memory_order_relaxed)) {
+            const MoveOutcome out = engine.doComputerMove();
+            if (!out.accepted) break;
+
+            for (int i = 0; i < N * N; ++i) cells[i] = static_cast<qint8>(engine.cellOwner(i / N, i % N));
+
+            int winner = 0;
+            if (out.finished) {
+                if (options.mode == GameMode::Score10x10) {
+                    winner = (out.score.xTotal > out.score.oTotal) - (out.score.oTotal > out.score.xTotal);
+                } else {
+                    winner = out.classicWinner;
+                }
+
+                if (stats) {
+                    StatsResult r;
+                    r.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                    r.mode = options.mode;
+                    r.fill = engine.fillMode();
+                    r.xType = PlayerType::Computer;
+                    r.oType = PlayerType::Computer;
+                    r.winner = winner;
+                    r.boardSize = N;
+                    r.moves = engine.movesMade();
+                    stats->record(r);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            progress_.boardSize = N;
+            progress_.cells = cells;
+            progress_.moves++;
+            progress_.elapsedMs = elapsedMs();
+            if (out.finished) {
+                progress_.gamesDone++;
+                if (winner > 0) progress_.xWins++;
+                else if (winner < 0) progress_.oWins++;
+                else progress_.draws++;
+            }
+            version_++;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    progress_.running = false;
+    progress_.elapsedMs = elapsedMs();
+    version_++;
+    running_.store(false, std::memory_order_release);
+}
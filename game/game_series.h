@@ -0,0 +1,76 @@
+#pragma once
+
+#include "game/game_types.h"
+#include "game/ai/ultimate_params.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class StatsStore;
+
+struct SeriesOptions {
+    GameMode mode = GameMode::Classic3x3;
+    int classicBoardSize = 3;
+    FillMode fill = FillMode::Free;
+    int games = 100;
+    QString classicTablebasePath;      // empty = search only
+    QString ultimateNetworkPath;       // empty = heuristic evaluation
+    QString ultimateBookPath;          // empty = no opening book
+    UltimateHeuristicParams ultimateParams;
+};
+
+// What the series has done so far; the board is the current game's.
+struct SeriesProgress {
+    int boardSize = 0;
+    std::vector<qint8> cells;           // owner of r * boardSize + c
+    int gamesDone = 0;
+    int games = 0;
+    int xWins = 0;
+    int oWins = 0;
+    int draws = 0;
+    qint64 moves = 0;
+    qint64 elapsedMs = 0;
+    bool running = false;
+};
+
+// Computer-vs-computer games played back to back on a worker thread with its
+// own GameEngine, so the GUI only looks at the latest position when it
+// repaints instead of after every move. Finished games go to the stats store
+// (StatsStore::record is thread-safe); the series is not written to the game
+// log.
+class GameSeries {
+public:
+    GameSeries() = default;
+    ~GameSeries();
+
+    GameSeries(const GameSeries&) = delete;
+    GameSeries& operator=(const GameSeries&) = delete;
+
+    void start(const SeriesOptions& options, StatsStore* stats = nullptr);
+
+    // Ends the series after the current move; the finished games stay counted.
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Copies the progress into `out` when it changed since `version` (updated
+    // in place); returns false and leaves `out` alone otherwise.
+    bool progress(SeriesProgress& out, quint64& version) const;
+
+private:
+    void run(SeriesOptions options, StatsStore* stats);
+
+private:
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex mutex_;
+    SeriesProgress progress_;
+    quint64 version_ = 0;
+};
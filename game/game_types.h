@@ -3,7 +3,9 @@
 enum class GameMode {
 Classic3x3 = 0,
 Score10x10 = 1,
-Ultimate = 2
+Ultimate = 2,
+KInARow = 3,
+UltimateRecursive = 4
 };
 
 enum class FillMode {
@@ -0,0 +1,431 @@
+#include "game_log.h"
+
+#include "game/modes/classic_mode.h"
+#include "game/modes/kinarow_mode.h"
+#include "game/modes/recursive_ultimate_mode.h"
+#include "game/modes/score_mode_fixed.h"
+#include "game/modes/ultimate_mode.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr char kLogMagic[4] = { 'T', 'T', 'T', 'L' };
+constexpr char kIndexMagic[4] = { 'T', 'T', 'T', 'I' };
+constexpr quint32 kVersion = 1;
+constexpr qint64 kFileHeaderSize = 16;
+constexpr qint64 kRecordHeaderSize = 12;
+constexpr int kMaxMoves = 0xFFFF;
+
+QByteArray fileHeader(const char magic[4]) {
+    char header[kFileHeaderSize] = {};
+    std::memcpy(header, magic, 4);
+    std::memcpy(header + 4, &kVersion, 4);
+    return QByteArray(header, static_cast<int>(kFileHeaderSize));
+}
+
+bool checkFileHeader(const uchar* data, qint64 size, const char magic[4]) {
+    if (size < kFileHeaderSize || std::memcmp(data, magic, 4) != 0) return false;
+    quint32 version = 0;
+    std::memcpy(&version, data + 4, 4);
+    return version == kVersion;
+}
+
+bool checkFileHeader(QFile& file, const char magic[4]) {
+    char header[kFileHeaderSize];
+    if (!file.seek(0) || file.read(header, kFileHeaderSize) != kFileHeaderSize) return false;
+    return checkFileHeader(reinterpret_cast<const uchar*>(header), kFileHeaderSize, magic);
+}
+
+void encodeRecord(const GameRecord& rec, char out[kRecordHeaderSize]) {
+    const quint32 seed = rec.seed;
+    const quint16 moves = static_cast<quint16>(rec.moveCount);
+    out[0] = static_cast<char>(rec.mode);
+    out[1] = static_cast<char>(rec.fill);
+    out[2] = static_cast<char>(rec.boardSize);
+    out[3] = static_cast<char>(rec.winLine);
+    std::memcpy(out + 4, &seed, 4);
+    std::memcpy(out + 8, &moves, 2);
+    out[10] = static_cast<char>(rec.result);
+    out[11] = static_cast<char>(rec.finished ? 1 : 0);
+}
+
+GameRecord decodeRecord(const uchar* p) {
+    GameRecord rec;
+    quint16 moves = 0;
+    rec.mode = static_cast<GameMode>(p[0]);
+    rec.fill = static_cast<FillMode>(p[1]);
+    rec.boardSize = p[2];
+    rec.winLine = p[3];
+    std::memcpy(&rec.seed, p + 4, 4);
+    std::memcpy(&moves, p + 8, 2);
+    rec.moveCount = moves;
+    rec.result = static_cast<qint8>(p[10]);
+    rec.finished = (p[11] & 1) != 0;
+    return rec;
+}
+
+// End of the record starting at `offset`, or -1 when it runs past `size`.
+qint64 recordEnd(const uchar* data, qint64 size, qint64 offset) {
+    if (offset < kFileHeaderSize || offset + kRecordHeaderSize > size) return -1;
+
+    quint16 moves = 0;
+    std::memcpy(&moves, data + offset + 8, 2);
+
+    qint64 p = offset + kRecordHeaderSize;
+    for (int i = 0; i < moves; ++i) {
+        if (p >= size) return -1;
+        p += (data[p] & 0x80) ? 2 : 1;
+    }
+    return (p <= size) ? p : -1;
+}
+
+} // namespace
+
+GameLogWriter::~GameLogWriter() {
+    close();
+}
+
+bool GameLogWriter::open(const QString& path, QString* error) {
+    close();
+
+    log_.setFileName(path);
+    index_.setFileName(path + QStringLiteral(".idx"));
+    if (!log_.open(QIODevice::ReadWrite) || !index_.open(QIODevice::ReadWrite)) {
+        if (error) *error = log_.isOpen() ? index_.errorString() : log_.errorString();
+        log_.close();
+        index_.close();
+        return false;
+    }
+
+    logSize_ = log_.size();
+    if (logSize_ == 0) {
+        const QByteArray header = fileHeader(kLogMagic);
+        if (log_.write(header.constData(), header.size()) != header.size()) {
+            if (error) *error = log_.errorString();
+            close();
+            return false;
+        }
+        logSize_ = kFileHeaderSize;
+    } else if (!checkFileHeader(log_, kLogMagic)) {
+        if (error) *error = QStringLiteral("not a game log");
+        log_.close();
+        index_.close();
+        return false;
+    }
+
+    qint64 indexed = -1;
+    const qint64 indexSize = index_.size();
+    if (indexSize >= kFileHeaderSize && checkFileHeader(index_, kIndexMagic)) {
+        indexed = (indexSize - kFileHeaderSize) / 8;
+    }
+
+    if (!repair(indexed, error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Checks the last indexed record, indexes any complete records written after
+// it and cuts off a trailing partial one. indexedGames < 0 rebuilds the index.
+bool GameLogWriter::repair(qint64 indexedGames, QString* error) {
+    QFile scan(log_.fileName());
+    const uchar* data = nullptr;
+    if (logSize_ > kFileHeaderSize && scan.open(QIODevice::ReadOnly)) {
+        data = scan.map(0, logSize_);
+    }
+    if (logSize_ > kFileHeaderSize && !data) {
+        if (error) *error = scan.errorString();
+        return false;
+    }
+
+    qint64 pos = kFileHeaderSize;
+    if (indexedGames > 0) {
+        qint64 last = 0;
+        if (!index_.seek(kFileHeaderSize + (indexedGames - 1) * 8) ||
+            index_.read(reinterpret_cast<char*>(&last), 8) != 8) {
+            indexedGames = -1;
+        } else {
+            const qint64 end = data ? recordEnd(data, logSize_, last) : -1;
+            if (end < 0) indexedGames = -1;
+            else pos = end;
+        }
+    }
+
+    if (indexedGames < 0) {
+        pos = kFileHeaderSize;
+        indexedGames = 0;
+    }
+
+    const QByteArray header = fileHeader(kIndexMagic);
+    if (!index_.resize(kFileHeaderSize + indexedGames * 8) || !index_.seek(0) ||
+        index_.write(header.constData(), header.size()) != header.size()) {
+        if (error) *error = index_.errorString();
+        return false;
+    }
+
+    qint64 found = 0;
+    if (data) {
+        for (qint64 end = recordEnd(data, logSize_, pos); end >= 0; end = recordEnd(data, logSize_, pos)) {
+            pendingIndex_.append(reinterpret_cast<const char*>(&pos), 8);
+            pos = end;
+            found++;
+        }
+        scan.unmap(const_cast<uchar*>(data));
+    }
+
+    if (pos < logSize_ && !log_.resize(pos)) {
+        if (error) *error = log_.errorString();
+        return false;
+    }
+
+    logSize_ = pos;
+    games_ = indexedGames + found;
+    if (!log_.seek(logSize_) || !index_.seek(kFileHeaderSize + indexedGames * 8) || !flush()) {
+        if (error) *error = index_.errorString();
+        return false;
+    }
+    return true;
+}
+
+void GameLogWriter::close() {
+    if (inGame_ && current_.moveCount > 0) endGame(0, false);
+    inGame_ = false;
+
+    if (log_.isOpen()) flush();
+    log_.close();
+    index_.close();
+    pendingLog_.clear();
+    pendingIndex_.clear();
+    games_ = 0;
+    logSize_ = 0;
+}
+
+void GameLogWriter::beginGame(const IGameMode& game) {
+    if (!isOpen()) return;
+    if (inGame_ && current_.moveCount > 0) endGame(0, false);
+
+    const GameConfig cfg = game.config();
+    current_ = GameRecord{};
+    current_.mode = game.mode();
+    current_.fill = game.fillMode();
+    current_.boardSize = game.boardSize();
+    current_.winLine = cfg.winLine;
+    current_.seed = cfg.seed;
+    moves_.clear();
+    inGame_ = true;
+}
+
+void GameLogWriter::addMove(int r, int c) {
+    if (!inGame_ || current_.moveCount >= kMaxMoves) return;
+
+    const int idx = r * current_.boardSize + c;
+    if (idx < 0x80) {
+        moves_.append(static_cast<char>(idx));
+    } else {
+        moves_.append(static_cast<char>(0x80 | (idx >> 8)));
+        moves_.append(static_cast<char>(idx & 0xFF));
+    }
+    current_.moveCount++;
+}
+
+void GameLogWriter::endGame(int result, bool finished) {
+    if (!inGame_) return;
+    inGame_ = false;
+
+    current_.result = result;
+    current_.finished = finished;
+
+    char header[kRecordHeaderSize];
+    encodeRecord(current_, header);
+
+    pendingIndex_.append(reinterpret_cast<const char*>(&logSize_), 8);
+    pendingLog_.append(header, kRecordHeaderSize);
+    pendingLog_.append(moves_.constData(), moves_.size());
+    logSize_ += kRecordHeaderSize + moves_.size();
+    games_++;
+
+    if (pendingLog_.size() >= kFlushBytes) flush();
+}
+
+// The log goes first: an index entry never points past the data.
+bool GameLogWriter::flush() {
+    if (!isOpen()) return false;
+
+    bool ok = true;
+    if (!pendingLog_.isEmpty()) {
+        ok = log_.write(pendingLog_.constData(), pendingLog_.size()) == pendingLog_.size() && log_.flush();
+        pendingLog_.clear();
+    }
+    if (ok && !pendingIndex_.isEmpty()) {
+        ok = index_.write(pendingIndex_.constData(), pendingIndex_.size()) == pendingIndex_.size() &&
+             index_.flush();
+    }
+    pendingIndex_.clear();
+    return ok;
+}
+
+GameLogReader::~GameLogReader() {
+    close();
+}
+
+bool GameLogReader::open(const QString& path, QString* error) {
+    close();
+
+    log_.setFileName(path);
+    if (!log_.open(QIODevice::ReadOnly)) {
+        if (error) *error = log_.errorString();
+        return false;
+    }
+
+    size_ = log_.size();
+    data_ = (size_ >= kFileHeaderSize) ? log_.map(0, size_) : nullptr;
+    if (!data_ || !checkFileHeader(data_, size_, kLogMagic)) {
+        if (error) *error = QStringLiteral("not a game log");
+        close();
+        return false;
+    }
+
+    index_.setFileName(path + QStringLiteral(".idx"));
+    if (index_.open(QIODevice::ReadOnly)) {
+        const qint64 indexSize = index_.size();
+        const uchar* mapped = (indexSize >= kFileHeaderSize) ? index_.map(0, indexSize) : nullptr;
+        if (mapped && checkFileHeader(mapped, indexSize, kIndexMagic)) {
+            indexData_ = mapped + kFileHeaderSize;
+            indexCount_ = (indexSize - kFileHeaderSize) / 8;
+        } else if (mapped) {
+            index_.unmap(const_cast<uchar*>(mapped));
+        }
+    }
+
+    qint64 pos = kFileHeaderSize;
+    if (indexCount_ > 0) {
+        pos = recordEnd(data_, size_, offsetOf(indexCount_ - 1));
+        if (pos < 0) {
+            index_.unmap(const_cast<uchar*>(indexData_ - kFileHeaderSize));
+            indexData_ = nullptr;
+            indexCount_ = 0;
+            pos = kFileHeaderSize;
+        }
+    }
+
+    for (qint64 end = recordEnd(data_, size_, pos); end >= 0; end = recordEnd(data_, size_, pos)) {
+        tail_.push_back(pos);
+        pos = end;
+    }
+    return true;
+}
+
+void GameLogReader::close() {
+    if (indexData_) index_.unmap(const_cast<uchar*>(indexData_ - kFileHeaderSize));
+    if (data_) log_.unmap(const_cast<uchar*>(data_));
+    indexData_ = nullptr;
+    data_ = nullptr;
+    indexCount_ = 0;
+    size_ = 0;
+    tail_.clear();
+    index_.close();
+    log_.close();
+
+    cachedGame_ = -1;
+    cachedMoves_.clear();
+    checkpoints_.clear();
+}
+
+qint64 GameLogReader::offsetOf(qint64 game) const {
+    if (game < indexCount_) {
+        qint64 offset = 0;
+        std::memcpy(&offset, indexData_ + game * 8, 8);
+        return offset;
+    }
+    return tail_[static_cast<int>(game - indexCount_)];
+}
+
+bool GameLogReader::record(qint64 game, GameRecord& out) const {
+    if (game < 0 || game >= gameCount()) return false;
+    const qint64 offset = offsetOf(game);
+    if (recordEnd(data_, size_, offset) < 0) return false;
+    out = decodeRecord(data_ + offset);
+    return true;
+}
+
+bool GameLogReader::moves(qint64 game, QVector<int>& cells) const {
+    GameRecord rec;
+    if (!record(game, rec)) return false;
+
+    cells.clear();
+    cells.reserve(rec.moveCount);
+    const uchar* p = data_ + offsetOf(game) + kRecordHeaderSize;
+    for (int i = 0; i < rec.moveCount; ++i) {
+        if (p[0] & 0x80) {
+            cells.push_back(((p[0] & 0x7F) << 8) | p[1]);
+            p += 2;
+        } else {
+            cells.push_back(p[0]);
+            p += 1;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<IGameMode> GameLogReader::position(qint64 game, int ply) {
+    if (game != cachedGame_) {
+        GameRecord rec;
+        cachedGame_ = -1;
+        checkpoints_.clear();
+        if (!record(game, rec) || !moves(game, cachedMoves_)) return nullptr;
+
+        std::unique_ptr<IGameMode> start = createMode(rec);
+        if (!start) return nullptr;
+        checkpoints_.push_back(std::move(start));
+        cachedGame_ = game;
+    }
+
+    if (ply < 0 || ply > cachedMoves_.size()) return nullptr;
+
+    const int N = checkpoints_.front()->boardSize();
+    auto replay = [&](IGameMode& g, int from, int to) {
+        for (int i = from; i < to; ++i) g.applyMove(cachedMoves_[i] / N, cachedMoves_[i] % N);
+    };
+
+    const int k = ply / kCheckpointInterval;
+    while (static_cast<int>(checkpoints_.size()) <= k) {
+        std::unique_ptr<IGameMode> next = checkpoints_.back()->clone();
+        const int from = static_cast<int>(checkpoints_.size() - 1) * kCheckpointInterval;
+        replay(*next, from, from + kCheckpointInterval);
+        checkpoints_.push_back(std::move(next));
+    }
+
+    std::unique_ptr<IGameMode> pos = checkpoints_[k]->clone();
+    replay(*pos, k * kCheckpointInterval, ply);
+    return pos;
+}
+
+std::unique_ptr<IGameMode> GameLogReader::createMode(const GameRecord& rec) {
+    std::unique_ptr<IGameMode> game;
+
+    if (rec.mode == GameMode::Classic3x3) {
+        game = std::make_unique<ClassicMode>(rec.boardSize);
+    } else if (rec.mode == GameMode::Score10x10) {
+        GameConfig cfg = ScoreMode::defaultConfig();
+        cfg.boardSize = rec.boardSize;
+        cfg.winLine = rec.winLine;
+        cfg.seed = rec.seed;
+        game = makeScoreMode(cfg);
+    } else if (rec.mode == GameMode::KInARow) {
+        game = std::make_unique<KInARowMode>(rec.boardSize, rec.winLine);
+    } else if (rec.mode == GameMode::UltimateRecursive) {
+        int levels = 0;
+        for (int n = rec.boardSize; n > 1; n /= 3) levels++;
+        game = std::make_unique<RecursiveUltimateMode>(levels);
+    } else if (rec.mode == GameMode::Ultimate) {
+        game = std::make_unique<UltimateMode>();
+    } else {
+        return nullptr;
+    }
+
+    game->setFillMode(rec.fill);
+    game->startNewGame();
+    return game;
+}
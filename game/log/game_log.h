@@ -0,0 +1,132 @@
+#pragma once
+
+#include "game/game_types.h"
+#include "game/modes/igame_mode.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <memory>
+#include <vector>
+
+// Append-only binary record of played games, written by GameLogWriter and
+// replayed by GameLogReader.
+//
+// "<name>" holds a 16-byte header ("TTTL", version) followed by one record
+// per game: a 12-byte header (mode, fill mode, board size, line length,
+// stripe seed, move count, result, flags) and the moves. A move is its cell
+// index r * N + c: one byte below 128, otherwise two bytes, high part first
+// with the top bit set. "<name>.idx" holds a 16-byte header and the offset of
+// every record as a quint64, so game n is found with one lookup.
+//
+// Modes are deterministic given the header (GameConfig::seed drives the
+// random stripes), so replaying the moves reproduces every position.
+struct GameRecord {
+    GameMode mode = GameMode::Classic3x3;
+    FillMode fill = FillMode::Free;
+    int boardSize = 3;
+    int winLine = 3;
+    quint32 seed = 0;
+    int moveCount = 0;
+
+    // 1 / -1 for the winner, 0 for a draw. Meaningless when !finished.
+    int result = 0;
+    bool finished = false;
+};
+
+class GameLogWriter {
+public:
+    GameLogWriter() = default;
+    ~GameLogWriter();
+
+    GameLogWriter(const GameLogWriter&) = delete;
+    GameLogWriter& operator=(const GameLogWriter&) = delete;
+
+    // Opens the log for appending, creating it if needed. A record cut short
+    // by a crash is dropped and a stale index is brought up to date.
+    bool open(const QString& path, QString* error = nullptr);
+    bool isOpen() const { return log_.isOpen(); }
+
+    // Writes buffered records; a game in progress is recorded as unfinished
+    // if it has moves.
+    void close();
+
+    // Takes mode, fill mode, size and seed from the freshly started game.
+    void beginGame(const IGameMode& game);
+    void addMove(int r, int c);
+    void endGame(int result, bool finished = true);
+    bool inGame() const { return inGame_; }
+
+    // Records are buffered and reach the disk in chunks; flush() forces it.
+    bool flush();
+
+    qint64 gameCount() const { return games_; }
+
+private:
+    bool repair(qint64 indexedGames, QString* error);
+
+private:
+    static constexpr int kFlushBytes = 1 << 16;
+
+    QFile log_;
+    QFile index_;
+    QByteArray pendingLog_;
+    QByteArray pendingIndex_;
+
+    GameRecord current_;
+    QByteArray moves_;
+    bool inGame_ = false;
+
+    qint64 logSize_ = 0;
+    qint64 games_ = 0;
+};
+
+class GameLogReader {
+public:
+    GameLogReader() = default;
+    ~GameLogReader();
+
+    GameLogReader(const GameLogReader&) = delete;
+    GameLogReader& operator=(const GameLogReader&) = delete;
+
+    // Maps the log and its index. Records past the end of the index (the
+    // writer flushes the log first) are found by scanning and still readable.
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+
+    qint64 gameCount() const { return indexCount_ + tail_.size(); }
+
+    bool record(qint64 game, GameRecord& out) const;
+
+    // Moves of the game as cell indices r * N + c.
+    bool moves(qint64 game, QVector<int>& cells) const;
+
+    // The position after `ply` moves. The reader keeps a clone of the game
+    // every kCheckpointInterval plies for the game last asked about, so
+    // seeking around one game replays at most that many moves per call.
+    std::unique_ptr<IGameMode> position(qint64 game, int ply);
+
+    // A started game with the record's mode, fill mode, size and seed.
+    static std::unique_ptr<IGameMode> createMode(const GameRecord& rec);
+
+    static constexpr int kCheckpointInterval = 16;
+
+private:
+    qint64 offsetOf(qint64 game) const;
+
+private:
+    QFile log_;
+    QFile index_;
+    const uchar* data_ = nullptr;
+    qint64 size_ = 0;
+    const uchar* indexData_ = nullptr;
+    qint64 indexCount_ = 0;
+    QVector<qint64> tail_;
+
+    qint64 cachedGame_ = -1;
+    QVector<int> cachedMoves_;
+    std::vector<std::unique_ptr<IGameMode>> checkpoints_;
+};
@@ -0,0 +1,414 @@
+#include "stats_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr char kLogMagic[4] = { 'T', 'T', 'T', 'R' };
+constexpr char kTotalsMagic[4] = { 'T', 'T', 'T', 'A' };
+constexpr quint32 kLogVersion = 1;
+constexpr quint32 kTotalsVersion = 2;   // 1 had no board size in the buckets
+constexpr qint64 kHeaderSize = 16;
+constexpr qint64 kRecordSize = 16;
+constexpr qint64 kScanChunk = 4096;   // records read per call while scanning
+
+struct StoredResult {
+    qint64 timestamp = 0;
+    int mode = 0;
+    int fill = 0;
+    int xType = 0;
+    int oType = 0;
+    int winner = 0;
+    int boardSize = 0;
+};
+
+void encodeResult(const StatsResult& r, char out[kRecordSize]) {
+    const quint16 moves = static_cast<quint16>(std::min(std::max(r.moves, 0), 0xFFFF));
+    std::memcpy(out, &r.timestamp, 8);
+    out[8] = static_cast<char>(r.mode);
+    out[9] = static_cast<char>(r.fill);
+    out[10] = static_cast<char>(r.xType);
+    out[11] = static_cast<char>(r.oType);
+    out[12] = static_cast<char>(r.winner);
+    out[13] = static_cast<char>(r.boardSize);
+    std::memcpy(out + 14, &moves, 2);
+}
+
+StoredResult decodeResult(const char* p) {
+    StoredResult r;
+    std::memcpy(&r.timestamp, p, 8);
+    r.mode = static_cast<quint8>(p[8]);
+    r.fill = static_cast<quint8>(p[9]);
+    r.xType = static_cast<quint8>(p[10]) & 1;
+    r.oType = static_cast<quint8>(p[11]) & 1;
+    r.winner = static_cast<qint8>(p[12]);
+    r.boardSize = static_cast<quint8>(p[13]);
+    return r;
+}
+
+QByteArray fileHeader(const char magic[4], quint32 version, qint64 extra) {
+    char header[kHeaderSize] = {};
+    std::memcpy(header, magic, 4);
+    std::memcpy(header + 4, &version, 4);
+    std::memcpy(header + 8, &extra, 8);
+    return QByteArray(header, static_cast<int>(kHeaderSize));
+}
+
+bool checkFileHeader(const char* header, const char magic[4], quint32 expected) {
+    quint32 version = 0;
+    std::memcpy(&version, header + 4, 4);
+    return std::memcmp(header, magic, 4) == 0 && version == expected;
+}
+
+quint64 mix(quint64 h, quint64 v) {
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 29);
+}
+
+// Calls fn(StoredResult) for records [from, to) of an open log.
+template <class Fn>
+bool scanRecords(QFile& file, qint64 from, qint64 to, Fn fn) {
+    QByteArray chunk;
+    for (qint64 i = from; i < to; i += kScanChunk) {
+        const qint64 n = std::min(kScanChunk, to - i);
+        if (!file.seek(kHeaderSize + i * kRecordSize)) return false;
+        chunk = file.read(n * kRecordSize);
+        if (chunk.size() != n * kRecordSize) return false;
+        for (qint64 k = 0; k < n; ++k) fn(decodeResult(chunk.constData() + k * kRecordSize));
+    }
+    return true;
+}
+
+bool readTimestamp(QFile& file, qint64 index, qint64& out) {
+    return file.seek(kHeaderSize + index * kRecordSize) &&
+           file.read(reinterpret_cast<char*>(&out), 8) == 8;
+}
+
+} // namespace
+
+StatsStore::~StatsStore() {
+    close();
+}
+
+int StatsStore::sizeSlot(int boardSize) {
+    return std::min(std::max(boardSize - 2, 0), kSizes - 1);
+}
+
+int StatsStore::bucketOf(int mode, int fill, int boardSize, int xType, int oType) {
+    const int group = ((mode & (kModes - 1)) * kFills + (fill & (kFills - 1))) * kSizes + sizeSlot(boardSize);
+    return (group * 2 + (xType & 1)) * 2 + (oType & 1);
+}
+
+bool StatsStore::matches(const StatsFilter& f, int bucket) {
+    const int oType = bucket & 1;
+    const int xType = (bucket >> 1) & 1;
+    const int size = (bucket >> 2) % kSizes;
+    const int fill = (bucket >> 2) / kSizes % kFills;
+    const int mode = (bucket >> 2) / kSizes / kFills;
+    return (f.mode < 0 || f.mode == mode) && (f.fill < 0 || f.fill == fill) &&
+           (f.boardSize < 0 || sizeSlot(f.boardSize) == size) &&
+           (f.xType < 0 || f.xType == xType) && (f.oType < 0 || f.oType == oType);
+}
+
+void StatsStore::add(StatsTotals& t, int winner) {
+    t.games++;
+    if (winner > 0) t.xWins++;
+    else if (winner < 0) t.oWins++;
+    else t.draws++;
+}
+
+bool StatsStore::open(const QString& path, QString* error) {
+    close();
+
+    path_ = path;
+    log_.setFileName(path);
+    totalsFile_.setFileName(path + QStringLiteral(".agg"));
+    if (!log_.open(QIODevice::ReadWrite) || !totalsFile_.open(QIODevice::ReadWrite)) {
+        if (error) *error = log_.isOpen() ? totalsFile_.errorString() : log_.errorString();
+        log_.close();
+        totalsFile_.close();
+        return false;
+    }
+
+    qint64 size = log_.size();
+    if (size == 0) {
+        const QByteArray header = fileHeader(kLogMagic, kLogVersion, 0);
+        if (log_.write(header.constData(), header.size()) != header.size()) {
+            if (error) *error = log_.errorString();
+            close();
+            return false;
+        }
+        size = kHeaderSize;
+    } else {
+        char header[kHeaderSize];
+        if (!log_.seek(0) || log_.read(header, kHeaderSize) != kHeaderSize || !checkFileHeader(header, kLogMagic, kLogVersion)) {
+            if (error) *error = QStringLiteral("not a stats file");
+            log_.close();
+            totalsFile_.close();
+            return false;
+        }
+    }
+
+    // A crash mid-append leaves a partial last record.
+    const qint64 records = (size - kHeaderSize) / kRecordSize;
+    if (kHeaderSize + records * kRecordSize != size && !log_.resize(kHeaderSize + records * kRecordSize)) {
+        if (error) *error = log_.errorString();
+        close();
+        return false;
+    }
+
+    if (!loadTotals(records, error)) {
+        close();
+        return false;
+    }
+
+    if (records > 0) {
+        qint64 last = 0;
+        if (readTimestamp(log_, records - 1, last)) lastTimestamp_ = last;
+    }
+    if (!log_.seek(kHeaderSize + records * kRecordSize)) {
+        if (error) *error = log_.errorString();
+        close();
+        return false;
+    }
+
+    std::copy(saved_, saved_ + kBuckets, totals_);
+    written_ = records;
+    closing_ = false;
+    thread_ = std::thread(&StatsStore::run, this);
+    return true;
+}
+
+// Reads the totals file and folds in the records it does not cover yet. A
+// missing or damaged totals file, or one ahead of the log, is rebuilt from
+// the whole log.
+bool StatsStore::loadTotals(qint64 records, QString* error) {
+    std::fill(saved_, saved_ + kBuckets, StatsTotals());
+
+    qint64 covered = -1;
+    const qint64 bodySize = 8 + kBuckets * static_cast<qint64>(sizeof(StatsTotals));
+    if (totalsFile_.size() == kHeaderSize + bodySize && totalsFile_.seek(0)) {
+        const QByteArray data = totalsFile_.read(kHeaderSize + bodySize);
+        if (data.size() == kHeaderSize + bodySize && checkFileHeader(data.constData(), kTotalsMagic, kTotalsVersion)) {
+            qint64 count = 0;
+            quint64 stored = 0;
+            std::memcpy(&count, data.constData() + 8, 8);
+            std::memcpy(&stored, data.constData() + kHeaderSize, 8);
+            std::memcpy(saved_, data.constData() + kHeaderSize + 8, kBuckets * sizeof(StatsTotals));
+
+            quint64 sum = mix(0, static_cast<quint64>(count));
+            for (const StatsTotals& t : saved_) {
+                sum = mix(mix(mix(mix(sum, t.games), t.xWins), t.oWins), t.draws);
+            }
+            if (sum == stored && count >= 0 && count <= records) covered = count;
+        }
+    }
+
+    if (covered == records) return true;
+    if (covered < 0) {
+        std::fill(saved_, saved_ + kBuckets, StatsTotals());
+        covered = 0;
+    }
+
+    const bool ok = scanRecords(log_, covered, records, [this](const StoredResult& r) {
+        add(saved_[bucketOf(r.mode, r.fill, r.boardSize, r.xType, r.oType)], r.winner);
+    });
+    if (!ok) {
+        if (error) *error = log_.errorString();
+        return false;
+    }
+
+    written_ = records;
+    if (!saveTotals()) {
+        if (error) *error = totalsFile_.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Writes saved_ for the first written_ records.
+bool StatsStore::saveTotals() {
+    quint64 sum = mix(0, static_cast<quint64>(written_));
+    for (const StatsTotals& t : saved_) {
+        sum = mix(mix(mix(mix(sum, t.games), t.xWins), t.oWins), t.draws);
+    }
+
+    QByteArray data = fileHeader(kTotalsMagic, kTotalsVersion, written_);
+    data.append(reinterpret_cast<const char*>(&sum), 8);
+    data.append(reinterpret_cast<const char*>(saved_), static_cast<int>(kBuckets * sizeof(StatsTotals)));
+
+    return totalsFile_.seek(0) && totalsFile_.write(data.constData(), data.size()) == data.size() &&
+           totalsFile_.flush();
+}
+
+void StatsStore::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+    log_.close();
+    totalsFile_.close();
+    pending_.clear();
+    inFlight_.clear();
+    writeError_.clear();
+    writing_ = false;
+    flushRequested_ = false;
+    written_ = 0;
+    lastTimestamp_ = 0;
+    std::fill(totals_, totals_ + kBuckets, StatsTotals());
+}
+
+bool StatsStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !closing_;
+}
+
+void StatsStore::record(const StatsResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) return;
+
+    // The log stays in time order even if the clock steps back.
+    StatsResult r = result;
+    r.timestamp = std::max(r.timestamp, lastTimestamp_);
+    r.winner = (r.winner > 0) - (r.winner < 0);
+    lastTimestamp_ = r.timestamp;
+
+    char rec[kRecordSize];
+    encodeResult(r, rec);
+    pending_.append(rec, static_cast<int>(kRecordSize));
+
+    add(totals_[bucketOf(static_cast<int>(r.mode), static_cast<int>(r.fill), r.boardSize,
+                         static_cast<int>(r.xType), static_cast<int>(r.oType))],
+        r.winner);
+
+    if (pending_.size() >= kFlushRecords * kRecordSize) wake_.notify_one();
+}
+
+StatsTotals StatsStore::totals(const StatsFilter& filter) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StatsTotals sum;
+    for (int b = 0; b < kBuckets; ++b) {
+        if (matches(filter, b)) sum += totals_[b];
+    }
+    return sum;
+}
+
+StatsTotals StatsStore::totalsSince(qint64 since, const StatsFilter& filter) const {
+    qint64 records = 0;
+    QByteArray pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) return StatsTotals();
+        records = written_;
+        pending = inFlight_ + pending_;
+    }
+
+    StatsTotals sum;
+    auto count = [&](const StoredResult& r) {
+        if (r.timestamp >= since && matches(filter, bucketOf(r.mode, r.fill, r.boardSize, r.xType, r.oType))) {
+            add(sum, r.winner);
+        }
+    };
+
+    // A separate handle, so the writer thread's file position is left alone.
+    QFile file(path_);
+    if (records > 0 && file.open(QIODevice::ReadOnly)) {
+        qint64 lo = 0, hi = records;
+        while (lo < hi) {
+            const qint64 mid = lo + (hi - lo) / 2;
+            qint64 ts = 0;
+            if (!readTimestamp(file, mid, ts)) break;
+            if (ts < since) lo = mid + 1;
+            else hi = mid;
+        }
+        scanRecords(file, lo, records, count);
+    }
+
+    // Records queued after the snapshot above may already be in the log, so
+    // only the copied batch and queue are counted here.
+    for (int i = 0; i + kRecordSize <= pending.size(); i += kRecordSize) {
+        count(decodeResult(pending.constData() + i));
+    }
+    return sum;
+}
+
+bool StatsStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) return true;
+    const qint64 failures = writeFailures_;
+    flushRequested_ = true;
+    wake_.notify_one();
+    drained_.wait(lock, [this, failures]() {
+        return (pending_.isEmpty() && !writing_) || closing_ || writeFailures_ != failures;
+    });
+    return writeFailures_ == failures && pending_.isEmpty();
+}
+
+QString StatsStore::lastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeError_;
+}
+
+// Waits for kFlushRecords results or kFlushMillis after the first queued one,
+// appends them and rewrites the totals file. A failed append is cut back off
+// the log and its records go back to the front of the queue, to be retried
+// after kFlushMillis. Everything left is written before close() returns,
+// unless writing fails then.
+void StatsStore::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this]() { return !pending_.isEmpty() || closing_ || flushRequested_; });
+        wake_.wait_for(lock, std::chrono::milliseconds(kFlushMillis), [this]() {
+            return pending_.size() >= kFlushRecords * kRecordSize || closing_ || flushRequested_;
+        });
+
+        QByteArray batch;
+        batch.swap(pending_);
+        inFlight_ = batch;
+        flushRequested_ = false;
+        writing_ = true;
+        lock.unlock();
+
+        // Only this thread changes written_, so it is read here unlocked.
+        const qint64 n = batch.size() / kRecordSize;
+        const bool ok = (n == 0) || (log_.write(batch.constData(), batch.size()) == batch.size() && log_.flush());
+        QString error;
+        if (ok) {
+            for (qint64 i = 0; i < n; ++i) {
+                const StoredResult r = decodeResult(batch.constData() + i * kRecordSize);
+                add(saved_[bucketOf(r.mode, r.fill, r.boardSize, r.xType, r.oType)], r.winner);
+            }
+        } else {
+            error = log_.errorString();
+            const qint64 end = kHeaderSize + written_ * kRecordSize;
+            log_.resize(end);
+            log_.seek(end);
+        }
+
+        lock.lock();
+        inFlight_.clear();
+        if (ok) {
+            written_ += n;
+            if (n > 0) writeError_.clear();
+        } else {
+            pending_.prepend(batch);
+            writeError_ = error;
+            writeFailures_++;
+        }
+        lock.unlock();
+        if (ok && n > 0) saveTotals();
+
+        lock.lock();
+        writing_ = false;
+        drained_.notify_all();
+        if (closing_ && (pending_.isEmpty() || !ok)) return;
+        if (!ok) wake_.wait_for(lock, std::chrono::milliseconds(kFlushMillis), [this]() { return closing_; });
+    }
+}
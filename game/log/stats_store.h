@@ -0,0 +1,130 @@
+#pragma once
+
+#include "game/game_types.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct StatsResult {
+    qint64 timestamp = 0;      // ms since the epoch
+    GameMode mode = GameMode::Classic3x3;
+    FillMode fill = FillMode::Free;
+    PlayerType xType = PlayerType::Human;
+    PlayerType oType = PlayerType::Human;
+    int winner = 0;            // 1 / -1, 0 for a draw
+    int boardSize = 0;
+    int moves = 0;
+};
+
+struct StatsTotals {
+    qint64 games = 0;
+    qint64 xWins = 0;
+    qint64 oWins = 0;
+    qint64 draws = 0;
+
+    StatsTotals& operator+=(const StatsTotals& o) {
+        games += o.games;
+        xWins += o.xWins;
+        oWins += o.oWins;
+        draws += o.draws;
+        return *this;
+    }
+};
+
+// -1 matches anything.
+struct StatsFilter {
+    int mode = -1;
+    int fill = -1;
+    int xType = -1;
+    int oType = -1;
+    int boardSize = -1;
+};
+
+// Results of every finished game, kept across runs.
+//
+// "<name>" is an append-only list of 16-byte records (timestamp, mode, fill
+// mode, player types, winner, board size, move count) in time order.
+// "<name>.agg" holds running totals per (mode, fill mode, board size, X type,
+// O type) bucket and the number of records they cover, so opening the store
+// folds in only records the totals have not seen yet. Aggregate queries sum at
+// most 1024 buckets, however many games were recorded.
+//
+// Board sizes 3 and 4 have buckets of their own; larger ones share one, which
+// keeps per-mode totals exact since only Classic comes in more than one size.
+//
+// record() only updates the in-memory totals and queues the record; a writer
+// thread appends queued records in batches and then rewrites the totals file.
+class StatsStore {
+public:
+    StatsStore() = default;
+    ~StatsStore();
+
+    StatsStore(const StatsStore&) = delete;
+    StatsStore& operator=(const StatsStore&) = delete;
+
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+    bool isOpen() const;
+
+    // Thread-safe; never waits for the disk.
+    void record(const StatsResult& result);
+
+    StatsTotals totals(const StatsFilter& filter = StatsFilter()) const;
+
+    // Games recorded at or after `since`. Binary-searches the time-ordered
+    // log, so the cost grows with the number of games in the window only.
+    StatsTotals totalsSince(qint64 since, const StatsFilter& filter = StatsFilter()) const;
+
+    // Blocks until every recorded result is on disk; false when a write
+    // failed meanwhile (see lastError()). Results that failed to be written
+    // stay queued and are retried.
+    bool flush();
+
+    // Why the writer thread's last append failed; empty after a good one.
+    QString lastError() const;
+
+private:
+    static constexpr int kModes = 8;
+    static constexpr int kFills = 8;
+    static constexpr int kSizes = 4;     // unknown, 3, 4, larger
+    static constexpr int kBuckets = kModes * kFills * kSizes * 2 * 2;
+    static constexpr int kFlushRecords = 256;
+    static constexpr int kFlushMillis = 500;
+
+    static int sizeSlot(int boardSize);
+    static int bucketOf(int mode, int fill, int boardSize, int xType, int oType);
+    static bool matches(const StatsFilter& f, int bucket);
+    static void add(StatsTotals& t, int winner);
+
+    bool loadTotals(qint64 records, QString* error);
+    bool saveTotals();
+    void run();
+
+private:
+    QString path_;
+    QFile log_;
+    QFile totalsFile_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    QByteArray pending_;            // encoded records not yet handed to the writer
+    QByteArray inFlight_;           // handed to the writer, not yet in written_
+    QString writeError_;
+    qint64 writeFailures_ = 0;
+    bool writing_ = false;
+    bool flushRequested_ = false;
+    bool closing_ = true;           // also "not open"
+    std::thread thread_;
+
+    StatsTotals totals_[kBuckets];       // everything recorded, including pending_
+    StatsTotals saved_[kBuckets];        // what the log holds; writer thread only
+    qint64 written_ = 0;            // records in the log
+    qint64 lastTimestamp_ = 0;
+};
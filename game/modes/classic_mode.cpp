@@ -1,11 +1,11 @@
 #include "classic_mode.h"
 
-ClassicMode::ClassicMode() {
+ClassicMode::ClassicMode(int boardSize) {
     cfg_.mode = GameMode::Classic3x3;
-    cfg_.boardSize = 3;
-    cfg_.winLine = 3;
+    cfg_.boardSize = boardSize;
+    cfg_.winLine = boardSize;
     cfg_.stripeThickness = 1;
-    cfg_.maxMoves = 9;
+    cfg_.maxMoves = boardSize * boardSize;
 
     board_.resize(cfg_.boardSize * cfg_.boardSize);
     startNewGame();
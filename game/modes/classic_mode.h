@@ -4,9 +4,9 @@
 
 #include <QVector>
 
-class ClassicMode : public IGameMode {
+class ClassicMode final : public IGameMode {
 public:
-    ClassicMode();
+    explicit ClassicMode(int boardSize = 3);
 
     GameMode mode() const override { return GameMode::Classic3x3; }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "game/game_types.h"
+#include <QtGlobal>
 #include <memory>
 
 struct GameConfig {
@@ -10,6 +11,10 @@ struct GameConfig {
 
     int stripeThickness = 1;
     int maxMoves = 0;
+
+    // Seed of the random stripes in Score mode. 0 draws a new seed for every
+    // game; config() reports the seed of the game in progress.
+    quint32 seed = 0;
 };
 
 struct ScoreSnapshot {
@@ -58,4 +63,8 @@ public:
     virtual GameConfig config() const = 0;
 
     virtual std::unique_ptr<IGameMode> clone() const = 0;
+
+    // Gives a copy made for searching its own random stream, so what it
+    // draws says nothing about the stripes the live game will get.
+    virtual void reseedForSearch() {}
 };
@@ -0,0 +1,126 @@
+#include "kinarow_mode.h"
+
+#include <algorithm>
+
+namespace {
+
+const int kDirections[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+
+}
+
+KInARowMode::KInARowMode(int boardSize, int winLine) {
+    cfg_.mode = GameMode::KInARow;
+    cfg_.boardSize = boardSize;
+    cfg_.winLine = winLine;
+    cfg_.stripeThickness = 1;
+    cfg_.maxMoves = boardSize * boardSize;
+
+    board_.resize(cfg_.boardSize * cfg_.boardSize);
+    candidatePos_.resize(cfg_.boardSize * cfg_.boardSize);
+    startNewGame();
+}
+
+std::unique_ptr<IGameMode> KInARowMode::clone() const {
+    return std::make_unique<KInARowMode>(*this);
+}
+
+void KInARowMode::startNewGame() {
+    active_ = true;
+    currentPlayer_ = 1;
+    movesMade_ = 0;
+    lastMove_ = -1;
+    for (int i = 0; i < board_.size(); ++i) {
+        board_[i] = 0;
+        candidatePos_[i] = -1;
+    }
+    candidates_.clear();
+}
+
+int KInARowMode::cellOwner(int r, int c) const {
+    const int N = cfg_.boardSize;
+    return board_[r * N + c];
+}
+
+bool KInARowMode::isMoveAllowed(int r, int c) const {
+    if (!active_) return false;
+    const int N = cfg_.boardSize;
+    if (r < 0 || c < 0 || r >= N || c >= N) return false;
+    return cellOwner(r, c) == 0;
+}
+
+MoveOutcome KInARowMode::applyMove(int r, int c) {
+    MoveOutcome out;
+    if (!isMoveAllowed(r, c)) return out;
+
+    const int N = cfg_.boardSize;
+    const int idx = r * N + c;
+    board_[idx] = currentPlayer_;
+    movesMade_++;
+    lastMove_ = idx;
+
+    removeCandidate(idx);
+    const int rad = kNeighbourRadius;
+    for (int rr = std::max(0, r - rad); rr <= std::min(N - 1, r + rad); ++rr) {
+        for (int cc = std::max(0, c - rad); cc <= std::min(N - 1, c + rad); ++cc) {
+            if (board_[rr * N + cc] == 0) addCandidate(rr * N + cc);
+        }
+    }
+
+    out.accepted = true;
+
+    if (winsThrough(r, c, currentPlayer_)) {
+        active_ = false;
+        out.finished = true;
+        out.classicWinner = currentPlayer_;
+        return out;
+    }
+
+    if (movesMade_ >= N * N) {
+        active_ = false;
+        out.finished = true;
+        out.classicWinner = 0;
+        return out;
+    }
+
+    currentPlayer_ = -currentPlayer_;
+    return out;
+}
+
+int KInARowMode::runFrom(int r, int c, int dr, int dc, int player, int limit) const {
+    const int N = cfg_.boardSize;
+    int n = 0;
+    for (int k = 1; k <= limit; ++k) {
+        const int rr = r + k * dr;
+        const int cc = c + k * dc;
+        if (rr < 0 || cc < 0 || rr >= N || cc >= N) break;
+        if (board_[rr * N + cc] != player) break;
+        n++;
+    }
+    return n;
+}
+
+bool KInARowMode::winsThrough(int r, int c, int player) const {
+    const int K = cfg_.winLine;
+    for (const auto& d : kDirections) {
+        const int run = 1 + runFrom(r, c, d[0], d[1], player, K - 1) + runFrom(r, c, -d[0], -d[1], player, K - 1);
+        if (run >= K) return true;
+    }
+    return false;
+}
+
+void KInARowMode::addCandidate(int idx) {
+    if (candidatePos_[idx] >= 0) return;
+    candidatePos_[idx] = candidates_.size();
+    candidates_.push_back(idx);
+}
+
+void KInARowMode::removeCandidate(int idx) {
+    const int pos = candidatePos_[idx];
+    if (pos < 0) return;
+
+    const int last = candidates_.back();
+    candidates_[pos] = last;
+    candidatePos_[last] = pos;
+    candidates_.pop_back();
+    candidatePos_[idx] = -1;
+}
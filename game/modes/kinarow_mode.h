@@ -0,0 +1,74 @@
+#pragma once
+
+#include "igame_mode.h"
+
+#include <QVector>
+
+// Classic rules on a large board: K stones in a row along a row, column or
+// diagonal win; a full board is a draw. Both the win check and the upkeep of
+// the candidate list touch only the neighbourhood of the last move, so a move
+// costs O(K) regardless of the board size.
+class KInARowMode final : public IGameMode {
+public:
+    // Empty cells within this Chebyshev distance of a stone are candidates.
+    static constexpr int kNeighbourRadius = 2;
+
+    explicit KInARowMode(int boardSize = 15, int winLine = 5);
+
+    GameMode mode() const override { return GameMode::KInARow; }
+
+    void startNewGame() override;
+    bool isActive() const override { return active_; }
+
+    int boardSize() const override { return cfg_.boardSize; }
+    int movesMade() const override { return movesMade_; }
+    int movesLeft() const override { return cfg_.boardSize * cfg_.boardSize - movesMade_; }
+
+    int currentPlayer() const override { return currentPlayer_; }
+
+    int cellOwner(int r, int c) const override;
+    int cellWeight(int, int) const override { return 0; }
+
+    bool isMoveAllowed(int r, int c) const override;
+    MoveOutcome applyMove(int r, int c) override;
+
+    int activeRow() const override { return -1; }
+    int activeCol() const override { return -1; }
+
+    FillMode fillMode() const override { return FillMode::Free; }
+    void setFillMode(FillMode) override {}
+
+    ScoreSnapshot currentScore() const override { return ScoreSnapshot{}; }
+
+    GameConfig config() const override { return cfg_; }
+    std::unique_ptr<IGameMode> clone() const override;
+
+    int winLine() const { return cfg_.winLine; }
+
+    // Cell index (r * N + c) of the last move, -1 before the first one.
+    int lastMove() const { return lastMove_; }
+
+    // Empty cells next to a stone, as cell indices in no particular order.
+    // Empty until the first move.
+    const QVector<int>& candidates() const { return candidates_; }
+
+    // Stones of `player` adjacent to (r, c) along (dr, dc), not counting
+    // (r, c) itself; stops after `limit` cells.
+    int runFrom(int r, int c, int dr, int dc, int player, int limit) const;
+
+private:
+    bool winsThrough(int r, int c, int player) const;
+    void addCandidate(int idx);
+    void removeCandidate(int idx);
+
+private:
+    GameConfig cfg_;
+    bool active_ = false;
+    int currentPlayer_ = 1;
+    int movesMade_ = 0;
+    int lastMove_ = -1;
+
+    QVector<int> board_;
+    QVector<int> candidates_;
+    QVector<int> candidatePos_;
+};
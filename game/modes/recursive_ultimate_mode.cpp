@@ -0,0 +1,151 @@
+#include "recursive_ultimate_mode.h"
+
+#include "game/ai/ultimate_board.h"
+
+RecursiveUltimateMode::RecursiveUltimateMode(int levels) {
+    side_.resize(levels + 1);
+    side_[0] = 1;
+    for (int j = 1; j <= levels; ++j) side_[j] = side_[j - 1] * 3;
+
+    cfg_.mode = GameMode::UltimateRecursive;
+    cfg_.boardSize = side_[levels];
+    cfg_.winLine = 3;
+    cfg_.stripeThickness = 3;
+    cfg_.maxMoves = cfg_.boardSize * cfg_.boardSize;
+
+    board_.resize(cfg_.boardSize * cfg_.boardSize);
+    levels_.resize(levels);
+
+    startNewGame();
+}
+
+std::unique_ptr<IGameMode> RecursiveUltimateMode::clone() const {
+    return std::make_unique<RecursiveUltimateMode>(*this);
+}
+
+void RecursiveUltimateMode::startNewGame() {
+    active_ = true;
+    currentPlayer_ = 1;
+    movesMade_ = 0;
+    forcedLevel_ = -1;
+    forcedIndex_ = -1;
+
+    board_.fill(0);
+
+    for (int j = 1; j <= levels_.size(); ++j) {
+        Level& L = levels_[j - 1];
+        const int boards = sideAt(j) * sideAt(j);
+        const int cellsPerBoard = side_[j] * side_[j];
+
+        L.x.fill(0, boards);
+        L.o.fill(0, boards);
+        L.closed.fill(0, boards);
+        L.state.fill(0, boards);
+        L.openCells.fill(cellsPerBoard, boards);
+    }
+}
+
+int RecursiveUltimateMode::cellOwner(int r, int c) const {
+    const int N = cfg_.boardSize;
+    if (r < 0 || c < 0 || r >= N || c >= N) return 0;
+    return board_[r * N + c];
+}
+
+bool RecursiveUltimateMode::isMoveAllowed(int r, int c) const {
+    if (!active_) return false;
+
+    const int N = cfg_.boardSize;
+    if (r < 0 || c < 0 || r >= N || c >= N) return false;
+    if (board_[r * N + c] != 0) return false;
+
+    for (int j = 1; j < levels_.size(); ++j) {
+        if (levels_[j - 1].state[boardIndexOf(j, r, c)] != 0) return false;
+    }
+
+    if (forcedLevel_ < 0) return true;
+    return boardIndexOf(forcedLevel_, r, c) == forcedIndex_;
+}
+
+MoveOutcome RecursiveUltimateMode::applyMove(int r, int c) {
+    MoveOutcome out{};
+    if (!isMoveAllowed(r, c)) return out;
+
+    const int N = cfg_.boardSize;
+    board_[r * N + c] = currentPlayer_;
+    movesMade_++;
+
+    out.accepted = true;
+
+    // Walk up once. `removed` is how many playable cells vanish under each
+    // ancestor: the cell itself plus everything left in boards that closed.
+    int removed = 1;
+    int result = 0;
+    bool changed = true;
+    quint16 closedBit = static_cast<quint16>(1u << childBit(1, r, c));
+    bool wonByMover = true;
+
+    for (int j = 1; j <= levels_.size(); ++j) {
+        Level& L = levels_[j - 1];
+        const int idx = boardIndexOf(j, r, c);
+        L.openCells[idx] -= removed;
+
+        if (!changed) continue;
+
+        quint16& mine = (currentPlayer_ == 1) ? L.x[idx] : L.o[idx];
+        if (wonByMover) mine |= closedBit;
+        L.closed[idx] |= closedBit;
+
+        if (wonByMover && UltimateBoard::hasLine(mine)) {
+            L.state[idx] = static_cast<qint8>(currentPlayer_);
+        } else if (L.closed[idx] == UltimateBoard::kFull) {
+            L.state[idx] = 2;
+        } else {
+            changed = false;
+            continue;
+        }
+
+        removed += L.openCells[idx];
+        L.openCells[idx] = 0;
+        wonByMover = (L.state[idx] == currentPlayer_);
+        result = L.state[idx];
+
+        if (j < levels_.size()) closedBit = static_cast<quint16>(1u << childBit(j + 1, r, c));
+    }
+
+    if (levels_.last().state[0] != 0) {
+        active_ = false;
+        out.finished = true;
+        out.classicWinner = (result == 2) ? 0 : result;
+        return out;
+    }
+
+    // Shift the move's address by one level to get the target board. A board
+    // inside a closed one is closed too, so the target widens to just above
+    // the highest closed board on its chain.
+    const int top = levels_.size();
+    int row = r % side_[top - 1];
+    int col = c % side_[top - 1];
+    int targetLevel = 1;
+    int targetRow = row;
+    int targetCol = col;
+    for (int level = 1; level < top; ++level) {
+        if (levels_[level - 1].state[row * sideAt(level) + col] != 0) {
+            targetLevel = level + 1;
+            targetRow = row / 3;
+            targetCol = col / 3;
+        }
+        row /= 3;
+        col /= 3;
+    }
+
+    if (targetLevel < top) {
+        forcedLevel_ = targetLevel;
+        forcedIndex_ = targetRow * sideAt(targetLevel) + targetCol;
+    } else {
+        forcedLevel_ = -1;
+        forcedIndex_ = -1;
+    }
+
+    currentPlayer_ = -currentPlayer_;
+    return out;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "igame_mode.h"
+
+#include <QVector>
+
+// Ultimate rules nested `levels` deep: the board is 3^levels cells wide, a
+// level-1 board is a 3x3 block of cells, and a level-j board is a 3x3 block
+// of level-(j-1) boards. Winning a board claims its square in the parent;
+// the game is won on the single top-level board.
+//
+// A move sends the opponent to the level-1 board whose address is the move's
+// address shifted by one level: with two levels, cell (r % 3, c % 3) picks
+// the next local, as in UltimateMode. If that board is closed (won or full)
+// the target widens to its parent, and so on up to a free move.
+//
+// Each board keeps bitmasks of its children won by X, won by O and closed,
+// plus the number of playable empty cells below it. A move touches one board
+// per level, so applying it and checking legality cost O(levels).
+class RecursiveUltimateMode final : public IGameMode {
+public:
+    explicit RecursiveUltimateMode(int levels = 3);
+
+    GameMode mode() const override { return GameMode::UltimateRecursive; }
+
+    void startNewGame() override;
+    bool isActive() const override { return active_; }
+
+    int boardSize() const override { return cfg_.boardSize; }
+    int movesMade() const override { return movesMade_; }
+    int movesLeft() const override { return active_ ? levels_.last().openCells[0] : 0; }
+    int currentPlayer() const override { return currentPlayer_; }
+
+    int cellOwner(int r, int c) const override;
+    int cellWeight(int, int) const override { return 0; }
+
+    bool isMoveAllowed(int r, int c) const override;
+    MoveOutcome applyMove(int r, int c) override;
+
+    // Grid position of the target board within its level, -1 for a free move.
+    int activeRow() const override { return forcedLevel_ < 0 ? -1 : forcedIndex_ / sideAt(forcedLevel_); }
+    int activeCol() const override { return forcedLevel_ < 0 ? -1 : forcedIndex_ % sideAt(forcedLevel_); }
+
+    FillMode fillMode() const override { return FillMode::Free; }
+    void setFillMode(FillMode) override {}
+
+    ScoreSnapshot currentScore() const override { return ScoreSnapshot{}; }
+
+    GameConfig config() const override { return cfg_; }
+    std::unique_ptr<IGameMode> clone() const override;
+
+    int levels() const { return levels_.size(); }
+
+    // Boards per side at `level` (1 = blocks of cells, levels() = the root).
+    int sideAt(int level) const { return side_[levels_.size() - level]; }
+
+    // Target board of the next move; level -1 when any open board is allowed.
+    int forcedLevel() const { return forcedLevel_; }
+    int forcedIndex() const { return forcedIndex_; }
+
+    // 0 while open, 1 / -1 once won, 2 once drawn.
+    int boardState(int level, int idx) const { return levels_[level - 1].state[idx]; }
+
+    // Children of a board (cells at level 1) won by `player`, and closed ones.
+    quint16 wonMask(int level, int idx, int player) const {
+        return player == 1 ? levels_[level - 1].x[idx] : levels_[level - 1].o[idx];
+    }
+    quint16 closedMask(int level, int idx) const { return levels_[level - 1].closed[idx]; }
+
+    int boardIndexOf(int level, int r, int c) const {
+        return (r / side_[level]) * sideAt(level) + (c / side_[level]);
+    }
+
+private:
+    struct Level {
+        QVector<quint16> x;
+        QVector<quint16> o;
+        QVector<quint16> closed;
+        QVector<qint8> state;
+        QVector<int> openCells;
+    };
+
+    int childBit(int level, int r, int c) const {
+        const int span = side_[level - 1];
+        return ((r / span) % 3) * 3 + (c / span) % 3;
+    }
+
+private:
+    GameConfig cfg_;
+    bool active_ = false;
+    int currentPlayer_ = 1;
+    int movesMade_ = 0;
+
+    QVector<int> board_;
+    QVector<Level> levels_;
+
+    // side_[j] = 3^j: cells per side of a level-j board.
+    QVector<int> side_;
+
+    int forcedLevel_ = -1;
+    int forcedIndex_ = -1;
+};
@@ -1,6 +1,8 @@
 #include "score_mode.h"
 
-ScoreMode::ScoreMode() {
+ScoreMode::ScoreMode() : ScoreMode(defaultConfig()) {}
+
+ScoreMode::ScoreMode(const GameConfig& cfg) : cfg_(cfg) {
     board_.resize(cfg_.boardSize * cfg_.boardSize);
     weights_.resize(cfg_.boardSize * cfg_.boardSize);
     startNewGame();
@@ -25,6 +27,8 @@ void ScoreMode::startNewGame() {
     activeRow_ = -1;
     activeCol_ = -1;
 
+    seed_ = cfg_.seed ? cfg_.seed : ScoreHelpers::randomSeed();
+    helpers_.seed(seed_);
     updateStripe();
 }
 
@@ -62,6 +66,26 @@ void ScoreMode::updateStripe() {
     helpers_.updateStripe(fill_, board_, cfg_.boardSize, activeRow_, activeCol_);
 }
 
+void ScoreMode::moveDeltas(std::vector<ScoreMoveDelta>& out) const {
+    const int N = cfg_.boardSize;
+    out.assign(N * N, ScoreMoveDelta{});
+    if (!active_) return;
+
+    std::vector<int> lines(N * N);
+    helpers_.lineDeltas(board_.constData(), weights_.constData(), N, cfg_.winLine, player_, lines.data());
+
+    const int cost = helpers_.pieceCost(player_, (player_ == 1 ? xMoves_ : oMoves_) + 1);
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (!isMoveAllowed(r, c)) continue;
+            const int idx = r * N + c;
+            out[idx].legal = true;
+            out[idx].line = lines[idx];
+            out[idx].spend = weights_[idx] + cost;
+        }
+    }
+}
+
 MoveOutcome ScoreMode::applyMove(int r, int c) {
     MoveOutcome out{};
     if (!isMoveAllowed(r, c)) return out;
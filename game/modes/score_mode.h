@@ -4,16 +4,34 @@
 #include "game/score/score_helpers.h"
 #include <QVector>
 
-class ScoreMode : public IGameMode {
+#include <vector>
+
+class ScoreMode final : public IGameMode {
 public:
     ScoreMode();
+    explicit ScoreMode(const GameConfig& cfg);
+
+    static GameConfig defaultConfig() {
+        GameConfig cfg;
+        cfg.mode = GameMode::Score10x10;
+        cfg.boardSize = 10;
+        cfg.winLine = 4;
+        cfg.stripeThickness = 60;
+        cfg.maxMoves = 0;           // play until the board is full
+        return cfg;
+    }
 
     GameMode mode() const override { return GameMode::Score10x10; }
-    GameConfig config() const override { return cfg_; }
+    GameConfig config() const override {
+        GameConfig cfg = cfg_;
+        cfg.seed = seed_;
+        return cfg;
+    }
 
     void setFillMode(FillMode fill) override { fill_ = fill; }
     FillMode fillMode() const override { return fill_; }
     std::unique_ptr<IGameMode> clone() const override;
+    void reseedForSearch() override { helpers_.reseedForSearch(); }
 
     void startNewGame() override;
     bool isActive() const override { return active_; }
@@ -38,17 +56,16 @@ public:
 
     ScoreSnapshot currentScore() const override { return score_; }
 
+    // What every move would do for the side to move, in one pass over the
+    // board: out[r * N + c] for each cell (see ScoreMoveDelta).
+    void moveDeltas(std::vector<ScoreMoveDelta>& out) const;
+
 private:
     void updateStripe();
     void rebuildWeights();
 
 private:
-    GameConfig cfg_{
-    GameMode::Score10x10,
-    10,
-    4,
-    60
-    };
+    GameConfig cfg_ = defaultConfig();
     bool active_ = false;
 
     int player_ = 1;
@@ -61,6 +78,7 @@ private:
     QVector<int> weights_;
 
     FillMode fill_ = FillMode::Free;
+    quint32 seed_ = 0;
     int activeRow_ = -1;
     int activeCol_ = -1;
 
@@ -0,0 +1,10 @@
+#include "score_mode_fixed.h"
+
+template class ScoreModeT<10, 4>;
+
+std::unique_ptr<IGameMode> makeScoreMode(const GameConfig& cfg) {
+    if (cfg.boardSize == 10 && cfg.winLine == 4) {
+        return std::make_unique<ScoreMode10x4>(cfg);
+    }
+    return std::make_unique<ScoreMode>(cfg);
+}
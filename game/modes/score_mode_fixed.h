@@ -0,0 +1,254 @@
+#pragma once
+
+#include "game/modes/igame_mode.h"
+#include "game/modes/score_mode.h"
+#include "game/score/score_helpers.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// Score mode with the board size and line length fixed at compile time.
+// Every window of L cells through every cell is generated once as a constexpr
+// table (cell indices plus the precomputed weight sum), so scoring a move is a
+// fixed, unrolled scan with no bounds checks. Semantics match ScoreMode.
+template <int N, int L>
+class ScoreModeT final : public IGameMode {
+    static_assert(N > 0 && L > 0 && L <= N, "ScoreModeT needs 0 < L <= N");
+    static_assert(N * N <= 65535, "cell indices are stored as 16 bits");
+
+public:
+    static constexpr int kCells = N * N;
+    static constexpr int kMaxWindowsPerCell = 4 * L;
+
+    explicit ScoreModeT(const GameConfig& cfg = ScoreMode::defaultConfig()) : cfg_(cfg) {
+        cfg_.boardSize = N;
+        cfg_.winLine = L;
+        startNewGame();
+    }
+
+    GameMode mode() const override { return GameMode::Score10x10; }
+    GameConfig config() const override {
+        GameConfig cfg = cfg_;
+        cfg.seed = seed_;
+        return cfg;
+    }
+
+    void setFillMode(FillMode fill) override { fill_ = fill; }
+    FillMode fillMode() const override { return fill_; }
+    std::unique_ptr<IGameMode> clone() const override { return std::make_unique<ScoreModeT>(*this); }
+    void reseedForSearch() override { helpers_.reseedForSearch(); }
+
+    void startNewGame() override {
+        board_.fill(0);
+
+        active_ = true;
+        player_ = 1;
+        movesMade_ = 0;
+        xMoves_ = 0;
+        oMoves_ = 0;
+
+        score_ = ScoreSnapshot{};
+        activeRow_ = -1;
+        activeCol_ = -1;
+
+        seed_ = cfg_.seed ? cfg_.seed : ScoreHelpers::randomSeed();
+        helpers_.seed(seed_);
+        updateStripe();
+    }
+
+    bool isActive() const override { return active_; }
+
+    int boardSize() const override { return N; }
+    int movesMade() const override { return movesMade_; }
+    int movesLeft() const override {
+        const int maxMoves = (cfg_.maxMoves > 0) ? cfg_.maxMoves : kCells;
+        const int left = maxMoves - movesMade_;
+        return (left < 0) ? 0 : left;
+    }
+
+    int currentPlayer() const override { return player_; }
+
+    int cellOwner(int r, int c) const override {
+        if (r < 0 || c < 0 || r >= N || c >= N) return 0;
+        return board_[r * N + c];
+    }
+
+    int cellWeight(int r, int c) const override {
+        if (r < 0 || c < 0 || r >= N || c >= N) return 0;
+        return kTables.weights[r * N + c];
+    }
+
+    bool isMoveAllowed(int r, int c) const override {
+        if (!active_) return false;
+        if (r < 0 || c < 0 || r >= N || c >= N) return false;
+        if (board_[r * N + c] != 0) return false;
+
+        if (fill_ == FillMode::Gravity) {
+            if (r < N - 1 && board_[(r + 1) * N + c] == 0) return false;
+        }
+
+        return helpers_.isAllowed(fill_, N, activeRow_, activeCol_, r, c);
+    }
+
+    MoveOutcome applyMove(int r, int c) override {
+        MoveOutcome out{};
+        if (!isMoveAllowed(r, c)) return out;
+
+        const int idx = r * N + c;
+
+        board_[idx] = player_;
+        movesMade_++;
+        out.accepted = true;
+
+        if (player_ == 1) {
+            xMoves_++;
+            score_.xSpent += (kTables.weights[idx] + helpers_.pieceCost(1, xMoves_));
+            score_.xLine += lineDelta(idx, 1);
+        } else {
+            oMoves_++;
+            score_.oSpent += (kTables.weights[idx] + helpers_.pieceCost(-1, oMoves_));
+            score_.oLine += lineDelta(idx, -1);
+        }
+
+        score_.xTotal = score_.xLine - score_.xSpent;
+        score_.oTotal = score_.oLine - score_.oSpent;
+
+        out.score = score_;
+
+        if (movesLeft() <= 0) {
+            active_ = false;
+            out.finished = true;
+            return out;
+        }
+
+        player_ = -player_;
+        updateStripe();
+        return out;
+    }
+
+    int activeRow() const override { return activeRow_; }
+    int activeCol() const override { return activeCol_; }
+
+    ScoreSnapshot currentScore() const override { return score_; }
+
+    void moveDeltas(std::vector<ScoreMoveDelta>& out) const {
+        out.assign(kCells, ScoreMoveDelta{});
+        if (!active_) return;
+
+        std::array<int, kCells> lines;
+        helpers_.lineDeltas(board_.data(), kTables.weights.data(), N, L, player_, lines.data());
+
+        const int cost = helpers_.pieceCost(player_, (player_ == 1 ? xMoves_ : oMoves_) + 1);
+        for (int idx = 0; idx < kCells; ++idx) {
+            if (!isMoveAllowed(idx / N, idx % N)) continue;
+            out[idx].legal = true;
+            out[idx].line = lines[idx];
+            out[idx].spend = kTables.weights[idx] + cost;
+        }
+    }
+
+private:
+    struct Window {
+        std::array<unsigned short, L> cells{};
+        int weight = 0;
+    };
+
+    struct Tables {
+        std::array<int, kCells> weights{};
+        std::array<int, kCells> windowCount{};
+        std::array<std::array<Window, kMaxWindowsPerCell>, kCells> windows{};
+    };
+
+    static constexpr Tables buildTables() {
+        Tables t{};
+        const int dirs[4][2] = { {0,1}, {1,0}, {1,1}, {1,-1} };
+
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                t.weights[r * N + c] = ScoreHelpers::tiledWeight4(r, c);
+            }
+        }
+
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                const int idx = r * N + c;
+                int count = 0;
+
+                for (int di = 0; di < 4; ++di) {
+                    const int dr = dirs[di][0];
+                    const int dc = dirs[di][1];
+
+                    for (int off = -(L - 1); off <= 0; ++off) {
+                        const int sr = r + off * dr;
+                        const int sc = c + off * dc;
+                        const int er = sr + (L - 1) * dr;
+                        const int ec = sc + (L - 1) * dc;
+                        if (sr < 0 || sc < 0 || sr >= N || sc >= N) continue;
+                        if (er < 0 || ec < 0 || er >= N || ec >= N) continue;
+
+                        Window& w = t.windows[idx][count];
+                        for (int k = 0; k < L; ++k) {
+                            const int cell = (sr + k * dr) * N + (sc + k * dc);
+                            w.cells[k] = static_cast<unsigned short>(cell);
+                            w.weight += t.weights[cell];
+                        }
+                        count++;
+                    }
+                }
+
+                t.windowCount[idx] = count;
+            }
+        }
+
+        return t;
+    }
+
+    static constexpr Tables kTables = buildTables();
+
+    int lineDelta(int idx, int player) const {
+        int delta = 0;
+        const auto& windows = kTables.windows[idx];
+        const int count = kTables.windowCount[idx];
+
+        for (int w = 0; w < count; ++w) {
+            bool ok = true;
+            for (int k = 0; k < L; ++k) ok &= (board_[windows[w].cells[k]] == player);
+            if (ok) delta += windows[w].weight;
+        }
+
+        return delta;
+    }
+
+    void updateStripe() {
+        helpers_.updateStripe(fill_, board_.data(), N, activeRow_, activeCol_);
+    }
+
+private:
+    GameConfig cfg_;
+    bool active_ = false;
+
+    int player_ = 1;
+    int movesMade_ = 0;
+
+    int xMoves_ = 0;
+    int oMoves_ = 0;
+
+    std::array<int, kCells> board_{};
+
+    FillMode fill_ = FillMode::Free;
+    quint32 seed_ = 0;
+    int activeRow_ = -1;
+    int activeCol_ = -1;
+
+    ScoreSnapshot score_{};
+    ScoreHelpers helpers_{};
+};
+
+using ScoreMode10x4 = ScoreModeT<10, 4>;
+
+extern template class ScoreModeT<10, 4>;
+
+// Picks the compile-time variant for the configurations we ship and falls back
+// to the runtime-sized ScoreMode for anything else.
+std::unique_ptr<IGameMode> makeScoreMode(const GameConfig& cfg = ScoreMode::defaultConfig());
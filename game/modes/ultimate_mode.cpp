@@ -19,6 +19,11 @@ std::unique_ptr<IGameMode> UltimateMode::clone() const {
 return std::make_unique<UltimateMode>(*this);
 }
 
+void UltimateMode::setNetwork(const UltimateNetwork* network) {
+network_ = network;
+if (network_) network_->refresh(acc_, UltimateBoard::fromMode(*this));
+}
+
 void UltimateMode::startNewGame() {
 active_ = true;
 currentPlayer_ = 1;
@@ -27,6 +32,12 @@ forcedLocal_ = -1;
 
 for (int i = 0; i < board_.size(); ++i) board_[i] = 0;
 for (int i = 0; i < localState_.size(); ++i) localState_[i] = 0;
+for (int i = 0; i < 9; ++i) localEmpty_[i] = 9;
+
+playableMask_ = 0x1FF;
+emptyPlayable_ = 81;
+
+if (network_) network_->refresh(acc_, UltimateBoard::fromMode(*this));
 
 
 }
@@ -37,10 +48,6 @@ if (r < 0 || c < 0 || r >= N || c >= N) return 0;
 return board_[r * N + c];
 }
 
-int UltimateMode::localIndexForCell(int r, int c) const {
-return (r / 3) * 3 + (c / 3);
-}
-
 int UltimateMode::localWinner(int localIdx) const {
 if (localIdx < 0 || localIdx >= 9) return 0;
 
@@ -76,25 +83,7 @@ return 0;
 
 bool UltimateMode::localFull(int localIdx) const {
 if (localIdx < 0 || localIdx >= 9) return true;
-
-const int baseR = (localIdx / 3) * 3;
-const int baseC = (localIdx % 3) * 3;
-
-for (int rr = 0; rr < 3; ++rr) {
-    for (int cc = 0; cc < 3; ++cc) {
-        if (board_[(baseR + rr) * 9 + (baseC + cc)] == 0) return false;
-    }
-}
-
-return true;
-
-
-}
-
-bool UltimateMode::localPlayable(int localIdx) const {
-if (localIdx < 0 || localIdx >= 9) return false;
-if (localState_[localIdx] != 0) return false;
-return !localFull(localIdx);
+return localEmpty_[localIdx] == 0;
 }
 
 int UltimateMode::macroWinner() const {
@@ -139,12 +128,8 @@ if (board_[r * N + c] != 0) return false;
 const int localIdx = localIndexForCell(r, c);
 if (!localPlayable(localIdx)) return false;
 
-int effectiveForced = forcedLocal_;
-if (effectiveForced != -1 && !localPlayable(effectiveForced)) effectiveForced = -1;
-
-
-if (effectiveForced == -1) return true;
-return localIdx == effectiveForced;
+if (forcedLocal_ == -1) return true;
+return localIdx == forcedLocal_;
 
 
 }
@@ -160,6 +145,9 @@ movesMade_++;
 out.accepted = true;
 
 const int localIdx = localIndexForCell(r, c);
+localEmpty_[localIdx]--;
+emptyPlayable_--;
+
 int lw = localWinner(localIdx);
 if (lw != 0) {
     localState_[localIdx] = lw;
@@ -167,31 +155,43 @@ if (lw != 0) {
     localState_[localIdx] = 2;
 }
 
+if (localState_[localIdx] != 0) {
+    playableMask_ &= ~(1u << localIdx);
+    emptyPlayable_ -= localEmpty_[localIdx];
+}
+
+if (network_) {
+    network_->add(acc_, (currentPlayer_ == 1 ? UltimateNetwork::kXStone : UltimateNetwork::kOStone) + r * N + c);
+
+    const int ls = localState_[localIdx];
+    if (ls == 1) network_->add(acc_, UltimateNetwork::kXLocal + localIdx);
+    else if (ls == -1) network_->add(acc_, UltimateNetwork::kOLocal + localIdx);
+    else if (ls == 2) network_->add(acc_, UltimateNetwork::kDrawnLocal + localIdx);
+}
+
 const int mw = macroWinner();
 if (mw != 0) {
     active_ = false;
     out.finished = true;
     out.classicWinner = mw;
+    setForcedLocal(-1);
     return out;
 }
 
-bool anyPlayable = false;
-for (int i = 0; i < 9; ++i) {
-    if (localPlayable(i)) {
-        anyPlayable = true;
-        break;
-    }
-}
-
-if (!anyPlayable) {
+if (playableMask_ == 0) {
     active_ = false;
     out.finished = true;
     out.classicWinner = 0;
+    setForcedLocal(-1);
     return out;
 }
 
 const int nextLocal = (r % 3) * 3 + (c % 3);
-forcedLocal_ = localPlayable(nextLocal) ? nextLocal : -1;
+setForcedLocal(localPlayable(nextLocal) ? nextLocal : -1);
+if (network_) {
+    if (currentPlayer_ == 1) network_->remove(acc_, UltimateNetwork::kXToMove);
+    else network_->add(acc_, UltimateNetwork::kXToMove);
+}
 
 currentPlayer_ = -currentPlayer_;
 return out;
@@ -199,14 +199,11 @@ return out;
 
 }
 
-int UltimateMode::activeRow() const {
-if (forcedLocal_ == -1) return -1;
-if (!localPlayable(forcedLocal_)) return -1;
-return forcedLocal_ / 3;
+void UltimateMode::setForcedLocal(int local) {
+if (local == forcedLocal_) return;
+if (network_) {
+    network_->remove(acc_, forcedLocal_ >= 0 ? UltimateNetwork::kForcedLocal + forcedLocal_ : UltimateNetwork::kFreeMove);
+    network_->add(acc_, local >= 0 ? UltimateNetwork::kForcedLocal + local : UltimateNetwork::kFreeMove);
 }
-
-int UltimateMode::activeCol() const {
-if (forcedLocal_ == -1) return -1;
-if (!localPlayable(forcedLocal_)) return -1;
-return forcedLocal_ % 3;
+forcedLocal_ = local;
 }
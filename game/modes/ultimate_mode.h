@@ -1,9 +1,10 @@
 #pragma once
 
 #include "igame_mode.h"
+#include "game/ai/ultimate_network.h"
 #include <QVector>
 
-class UltimateMode : public IGameMode {
+class UltimateMode final : public IGameMode {
 public:
 UltimateMode();
 
@@ -14,19 +15,7 @@ bool isActive() const override { return active_; }
 
 int boardSize() const override { return cfg_.boardSize; }
 int movesMade() const override { return movesMade_; }
-int movesLeft() const override {
-    if (!active_) return 0;
-    int left = 0;
-    for (int r = 0; r < 9; ++r) {
-        for (int c = 0; c < 9; ++c) {
-            if (board_[r * 9 + c] != 0) continue;
-            const int localIdx = localIndexForCell(r, c);
-            if (!localPlayable(localIdx)) continue;
-            left++;
-        }
-    }
-    return left;
-}
+int movesLeft() const override { return active_ ? emptyPlayable_ : 0; }
 int currentPlayer() const override { return currentPlayer_; }
 
 int cellOwner(int r, int c) const override;
@@ -35,8 +24,8 @@ int cellWeight(int, int) const override { return 0; }
 bool isMoveAllowed(int r, int c) const override;
 MoveOutcome applyMove(int r, int c) override;
 
-int activeRow() const override;
-int activeCol() const override;
+int activeRow() const override { return (forcedLocal_ == -1) ? -1 : forcedLocal_ / 3; }
+int activeCol() const override { return (forcedLocal_ == -1) ? -1 : forcedLocal_ % 3; }
 
 FillMode fillMode() const override { return FillMode::Free; }
 void setFillMode(FillMode) override {}
@@ -47,13 +36,24 @@ GameConfig config() const override { return cfg_; }
 
 std::unique_ptr<IGameMode> clone() const override;
 
+// Optional evaluation network. While one is attached, applyMove keeps its
+// accumulator up to date, so networkScore() is a single forward pass; the
+// network must outlive the mode and its copies. Not meaningful once the game
+// is over.
+void setNetwork(const UltimateNetwork* network);
+const UltimateNetwork* network() const { return network_; }
+int networkScore() const { return network_->evaluate(acc_); }
 
 private:
-int localIndexForCell(int r, int c) const;
+int localIndexForCell(int r, int c) const { return (r / 3) * 3 + (c / 3); }
 int localWinner(int localIdx) const;
 bool localFull(int localIdx) const;
-bool localPlayable(int localIdx) const;
+bool localPlayable(int localIdx) const {
+    return localIdx >= 0 && localIdx < 9 && ((playableMask_ >> localIdx) & 1u);
+}
 int macroWinner() const;
+// Also moves the network's forced-local feature.
+void setForcedLocal(int local);
 
 private:
 GameConfig cfg_;
@@ -64,6 +64,16 @@ int movesMade_ = 0;
 QVector<int> board_;
 QVector<int> localState_;
 
+// Always -1 or a playable local: it is recomputed after every move and
+// cleared when the game ends.
 int forcedLocal_ = -1;
 
+// Maintained by applyMove so legality queries never rescan the board.
+unsigned playableMask_ = 0;
+int localEmpty_[9] = {};
+int emptyPlayable_ = 0;
+
+const UltimateNetwork* network_ = nullptr;
+UltimateAccumulator acc_;
+
 };
\ No newline at end of file
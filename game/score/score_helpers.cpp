@@ -1,6 +1,10 @@
 #include "score_helpers.h"
 #include <QRandomGenerator>
 
+#include <QtAlgorithms>
+
+#include <algorithm>
+
 bool ScoreHelpers::isAllowed(FillMode fill, int, int activeRow, int activeCol, int r, int c) const {
     switch (fill) {
         case FillMode::Free:
@@ -68,39 +72,150 @@ int ScoreHelpers::lineDelta(const QVector<int>& board,
     return delta;
 }
 
-bool ScoreHelpers::rowHasEmpty(const QVector<int>& board, int N, int r) const {
+// Bit-parallel over rows: bit c of a row word is column c. For a direction
+// (dr, dc) and the candidate's position k inside the window, one row of
+// candidates is the row's empty cells ANDed with the L - 1 neighbour rows
+// (r + d * dr for d = j - k, j != k) shifted by d * dc, so a single word
+// operation tests that window position for every cell of the row. Hits are
+// rare (a window needs L - 1 of the mover's stones), and only they read the
+// weights. Boards wider than 64 take the per-cell scan.
+void ScoreHelpers::lineDeltas(const int* board, const int* weights,
+                              int N, int L, int player, int* out) const {
+    std::fill(out, out + N * N, 0);
+
+    const int dirs[4][2] = { {0,1}, {1,0}, {1,1}, {1,-1} };
+
+    auto windowSum = [&](int sr, int sc, int dr, int dc) {
+        int sum = 0;
+        for (int j = 0; j < L; ++j) sum += weights[(sr + j * dr) * N + (sc + j * dc)];
+        return sum;
+    };
+
+    if (N > 64) {
+        for (int r = 0; r < N; ++r) {
+            for (int c = 0; c < N; ++c) {
+                if (board[r * N + c] != 0) continue;
+                for (const auto& d : dirs) {
+                    for (int k = 0; k < L; ++k) {
+                        const int sr = r - k * d[0];
+                        const int sc = c - k * d[1];
+                        const int er = sr + (L - 1) * d[0];
+                        const int ec = sc + (L - 1) * d[1];
+                        if (!inBounds(N, sr, sc) || !inBounds(N, er, ec)) continue;
+
+                        bool ok = true;
+                        for (int j = 0; j < L && ok; ++j) {
+                            if (j != k) ok = board[(sr + j * d[0]) * N + (sc + j * d[1])] == player;
+                        }
+                        if (ok) out[r * N + c] += windowSum(sr, sc, d[0], d[1]);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    quint64 own[64];
+    quint64 empty[64];
+    for (int r = 0; r < N; ++r) {
+        own[r] = 0;
+        empty[r] = 0;
+        for (int c = 0; c < N; ++c) {
+            const int v = board[r * N + c];
+            if (v == player) own[r] |= static_cast<quint64>(1) << c;
+            else if (v == 0) empty[r] |= static_cast<quint64>(1) << c;
+        }
+    }
+
+    const quint64 full = (N == 64) ? ~static_cast<quint64>(0) : ((static_cast<quint64>(1) << N) - 1);
+
+    for (const auto& d : dirs) {
+        const int dr = d[0];
+        const int dc = d[1];
+
+        for (int k = 0; k < L; ++k) {
+            for (int r = 0; r < N; ++r) {
+                quint64 hits = empty[r];
+                for (int j = 0; j < L && hits; ++j) {
+                    if (j == k) continue;
+                    const int rr = r + (j - k) * dr;
+                    if (rr < 0 || rr >= N) {
+                        hits = 0;
+                        break;
+                    }
+                    const int shift = (j - k) * dc;
+                    hits &= (shift >= 0) ? (own[rr] >> shift) : ((own[rr] << -shift) & full);
+                }
+
+                while (hits) {
+                    const int c = static_cast<int>(qCountTrailingZeroBits(hits));
+                    hits &= hits - 1;
+
+                    const int sr = r - k * dr;
+                    const int sc = c - k * dc;
+                    const int ec = sc + (L - 1) * dc;
+                    if (sc < 0 || sc >= N || ec < 0 || ec >= N) continue;
+                    out[r * N + c] += windowSum(sr, sc, dr, dc);
+                }
+            }
+        }
+    }
+}
+
+bool ScoreHelpers::rowHasEmpty(const int* board, int N, int r) const {
     for (int c = 0; c < N; ++c) {
         if (board[r * N + c] == 0) return true;
     }
     return false;
 }
 
-bool ScoreHelpers::colHasEmpty(const QVector<int>& board, int N, int c) const {
+bool ScoreHelpers::colHasEmpty(const int* board, int N, int c) const {
     for (int r = 0; r < N; ++r) {
         if (board[r * N + c] == 0) return true;
     }
     return false;
 }
 
-int ScoreHelpers::pickRandomRowWithEmpty(const QVector<int>& board, int N) const {
+quint32 ScoreHelpers::randomSeed() {
+    quint32 s = 0;
+    while (s == 0) s = QRandomGenerator::global()->generate();
+    return s;
+}
+
+// A fresh generator seeded from the game's own one. Only the live game keeps
+// drawing from rngState_, so a search cannot read its coming stripes.
+void ScoreHelpers::reseedForSearch() {
+    rngState_ ^= (static_cast<quint64>(randomSeed()) << 32) | randomSeed();
+}
+
+// splitmix64; the high half is scaled into [0, bound).
+int ScoreHelpers::nextRandom(int bound) {
+    quint64 z = (rngState_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<int>(((z >> 32) * static_cast<quint64>(bound)) >> 32);
+}
+
+int ScoreHelpers::pickRandomRowWithEmpty(const int* board, int N) {
     QVector<int> rows;
     rows.reserve(N);
     for (int r = 0; r < N; ++r) {
         if (rowHasEmpty(board, N, r)) rows.push_back(r);
     }
     if (rows.isEmpty()) return -1;
-    const int idx = QRandomGenerator::global()->bounded(rows.size());
+    const int idx = nextRandom(rows.size());
     return rows[idx];
 }
 
-int ScoreHelpers::pickRandomColWithEmpty(const QVector<int>& board, int N) const {
+int ScoreHelpers::pickRandomColWithEmpty(const int* board, int N) {
     QVector<int> cols;
     cols.reserve(N);
     for (int c = 0; c < N; ++c) {
         if (colHasEmpty(board, N, c)) cols.push_back(c);
     }
     if (cols.isEmpty()) return -1;
-    const int idx = QRandomGenerator::global()->bounded(cols.size());
+    const int idx = nextRandom(cols.size());
     return cols[idx];
 }
 
@@ -108,7 +223,15 @@ void ScoreHelpers::updateStripe(FillMode fill,
                                 const QVector<int>& board,
                                 int N,
                                 int& activeRow,
-                                int& activeCol) const {
+                                int& activeCol) {
+    updateStripe(fill, board.constData(), N, activeRow, activeCol);
+}
+
+void ScoreHelpers::updateStripe(FillMode fill,
+                                const int* board,
+                                int N,
+                                int& activeRow,
+                                int& activeCol) {
     switch (fill) {
         case FillMode::Free:
         case FillMode::Gravity:
@@ -163,16 +286,9 @@ QVector<int> ScoreHelpers::generateWeightsTiled4(int N) {
     QVector<int> w;
     w.resize(N * N);
 
-    const int tile[4][4] = {
-        {  2, -2,  1, -1 },
-        { -1,  1, -2,  2 },
-        { -2,  2, -1,  1 },
-        {  1, -1,  2, -2 }
-    };
-
     for (int r = 0; r < N; ++r) {
         for (int c = 0; c < N; ++c) {
-            w[r * N + c] = tile[r % 4][c % 4];
+            w[r * N + c] = tiledWeight4(r, c);
         }
     }
     return w;
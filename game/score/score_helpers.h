@@ -3,6 +3,17 @@
 #include "game/game_types.h"
 #include <QVector>
 
+// The effect of one candidate move on the mover's score: `line` is what the
+// move would add to the line score (lineDelta after it), `spend` the cell
+// weight plus the piece cost. The mover's total changes by net().
+struct ScoreMoveDelta {
+    bool legal = false;
+    int line = 0;
+    int spend = 0;
+
+    int net() const { return line - spend; }
+};
+
 class ScoreHelpers {
 public:
     bool isAllowed(FillMode fill, int N, int activeRow, int activeCol, int r, int c) const;
@@ -14,17 +25,50 @@ public:
                   int N, int r, int c,
                   int L, int player) const;
 
+    // lineDelta for every empty cell at once: out[r * N + c] is what `player`
+    // would add by taking that cell (0 for occupied cells). Scans whole rows
+    // of windows per word operation instead of reading every window through
+    // every cell.
+    void lineDeltas(const int* board, const int* weights,
+                    int N, int L, int player, int* out) const;
+
     void updateStripe(FillMode fill,
                       const QVector<int>& board,
                       int N,
                       int& activeRow,
-                      int& activeCol) const;
+                      int& activeCol);
+
+    void updateStripe(FillMode fill,
+                      const int* board,
+                      int N,
+                      int& activeRow,
+                      int& activeCol);
+
+    // Random stripes come from a small per-game generator, so a game replays
+    // identically from its seed. A plain copy draws the same stripes as the
+    // original; reseedForSearch() moves a copy onto a stream of its own.
+    void seed(quint32 s) { rngState_ = s; }
+    void reseedForSearch();
+    static quint32 randomSeed();
 
     static QVector<int> generateWeightsTiled4(int N);
 
+    static constexpr int tiledWeight4(int r, int c) {
+        constexpr int tile[4][4] = {
+            {  2, -2,  1, -1 },
+            { -1,  1, -2,  2 },
+            { -2,  2, -1,  1 },
+            {  1, -1,  2, -2 }
+        };
+        return tile[r % 4][c % 4];
+    }
+
 private:
-    bool rowHasEmpty(const QVector<int>& board, int N, int r) const;
-    bool colHasEmpty(const QVector<int>& board, int N, int c) const;
-    int pickRandomRowWithEmpty(const QVector<int>& board, int N) const;
-    int pickRandomColWithEmpty(const QVector<int>& board, int N) const;
+    bool rowHasEmpty(const int* board, int N, int r) const;
+    bool colHasEmpty(const int* board, int N, int c) const;
+    int pickRandomRowWithEmpty(const int* board, int N);
+    int pickRandomColWithEmpty(const int* board, int N);
+    int nextRandom(int bound);
+
+    quint64 rngState_ = 0;
 };
@@ -0,0 +1,421 @@
+#include "game_server.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+struct GameServer::Session {
+    int id = 0;
+    int client = 0;
+    int budgetMs = 0;
+    Sink sink;
+
+    std::mutex mutex;
+    GameEngine engine;
+    bool thinking = false;
+    bool closed = false;
+};
+
+// Sets a pool worker's cancel flag once the deadline of the job it runs has
+// passed, so the search stops there. One thread watches every worker.
+class GameServer::Watchdog {
+public:
+    using Clock = WorkStealingPool::Clock;
+
+    explicit Watchdog(int workers) : slots_(workers) {
+        thread_ = std::thread(&Watchdog::run, this);
+    }
+
+    ~Watchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    // The flag for the worker's next search, cleared unless stopAll() ran.
+    const std::atomic<bool>* arm(int worker, Clock::time_point deadline) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[worker];
+        slot.cancel = stopped_;
+        slot.deadline = deadline;
+        wake_.notify_one();
+        return &slot.cancel;
+    }
+
+    void disarm(int worker) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_[worker].deadline = Clock::time_point::max();
+    }
+
+    // Cancels the running searches and every later one.
+    void stopAll() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        for (Slot& slot : slots_) slot.cancel = true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<bool> cancel{false};
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!quit_) {
+            const Clock::time_point now = Clock::now();
+            Clock::time_point next = Clock::time_point::max();
+            for (Slot& slot : slots_) {
+                if (slot.deadline <= now) {
+                    slot.cancel = true;
+                    slot.deadline = Clock::time_point::max();
+                } else {
+                    next = std::min(next, slot.deadline);
+                }
+            }
+            if (next == Clock::time_point::max()) wake_.wait(lock);
+            else wake_.wait_until(lock, next);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopped_ = false;
+    bool quit_ = false;
+    std::thread thread_;
+};
+
+namespace {
+
+bool parseMode(const QString& name, GameMode& out) {
+    if (name == "classic") out = GameMode::Classic3x3;
+    else if (name == "score") out = GameMode::Score10x10;
+    else if (name == "ultimate") out = GameMode::Ultimate;
+    else if (name == "kinarow") out = GameMode::KInARow;
+    else if (name == "recursive") out = GameMode::UltimateRecursive;
+    else return false;
+    return true;
+}
+
+bool parsePlayer(const QString& name, PlayerType& out) {
+    if (name == "human") out = PlayerType::Human;
+    else if (name == "computer") out = PlayerType::Computer;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+GameServer::GameServer(const ServerOptions& options)
+    : options_(options), pool_(options.threads) {
+    solvers_.resize(pool_.threadCount());
+    watchdog_ = std::make_unique<Watchdog>(pool_.threadCount());
+}
+
+// Running searches are cancelled and no computer move is queued after this
+// point; pool_ then drops what is already queued.
+GameServer::~GameServer() {
+    stopping_ = true;
+    watchdog_->stopAll();
+}
+
+bool GameServer::start(QString* error) {
+    return options_.engine.applyTo(searcher_, error);
+}
+
+int GameServer::sessionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(sessions_.size());
+}
+
+GameServer::SessionPtr GameServer::find(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = sessions_.find(id);
+    return it == sessions_.end() ? nullptr : it->second;
+}
+
+bool GameServer::handle(int client, const QString& line, const Sink& sink) {
+    const QStringList args = line.simplified().split(' ');
+    if (args.isEmpty() || args.first().isEmpty()) return true;
+
+    const QString& cmd = args.first();
+    auto fail = [&sink](const QString& message) { sink("error " + message); };
+
+    if (cmd == "quit") {
+        stopping_ = true;
+        watchdog_->stopAll();
+        return false;
+    }
+
+    if (cmd == "stats") {
+        sink(statsLine());
+        return true;
+    }
+
+    if (cmd == "new") {
+        GameMode mode = GameMode::Classic3x3;
+        if (args.count() < 2 || !parseMode(args[1], mode)) {
+            fail("unknown mode");
+            return true;
+        }
+
+        PlayerType x = PlayerType::Human, o = PlayerType::Computer;
+        int size = 3, fill = 0, budget = options_.moveBudgetMs;
+        for (int i = 2; i < args.count(); ++i) {
+            const int eq = args[i].indexOf('=');
+            const QString key = args[i].left(eq < 0 ? 0 : eq);
+            const QString value = args[i].mid(eq < 0 ? 0 : eq + 1);
+            bool ok = eq > 0;
+            if (key == "x") ok = parsePlayer(value, x);
+            else if (key == "o") ok = parsePlayer(value, o);
+            else if (key == "size") ok = ok && (size = value.toInt(&ok), ok) && size >= 3 && size <= 4;
+            else if (key == "fill") ok = ok && (fill = value.toInt(&ok), ok) && fill >= 0 && fill <= 6;
+            else if (key == "budget") ok = ok && (budget = value.toInt(&ok), ok) && budget >= 0;
+            else ok = false;
+            if (!ok) {
+                fail("bad option " + args[i]);
+                return true;
+            }
+        }
+
+        auto session = std::make_shared<Session>();
+        session->client = client;
+        session->budgetMs = budget;
+        session->sink = sink;
+        session->engine.setClassicBoardSize(size);
+        session->engine.setMode(mode);
+        session->engine.setFillMode(static_cast<FillMode>(fill));
+        session->engine.setPlayerTypeX(x);
+        session->engine.setPlayerTypeO(o);
+        session->engine.startNewGame();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (static_cast<int>(sessions_.size()) >= options_.maxSessions) {
+                fail("too many sessions");
+                return true;
+            }
+            session->id = nextId_++;
+            sessions_.emplace(session->id, session);
+        }
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        sink("ok " + QString::number(session->id));
+        scheduleMove(session, false);
+        return true;
+    }
+
+    if (args.count() < 2) {
+        fail("missing session id");
+        return true;
+    }
+    bool ok = false;
+    const int id = args[1].toInt(&ok);
+    const SessionPtr session = ok ? find(id) : nullptr;
+    if (!session) {
+        fail("no session " + args[1]);
+        return true;
+    }
+    Session& s = *session;
+
+    if (cmd == "close") {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sessions_.erase(id);
+        }
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.closed = true;
+        sink("closed " + QString::number(id));
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (cmd == "show") {
+        const int N = s.engine.boardSize();
+        QString cells;
+        for (int i = 0; i < N * N; ++i) {
+            const int owner = s.engine.cellOwner(i / N, i % N);
+            cells += (owner == 1) ? "x" : (owner == -1 ? "o" : ".");
+        }
+        sink(QString::asprintf("board %d %d %s ", id, N, s.engine.currentPlayer() == 1 ? "x" : "o") + cells);
+        return true;
+    }
+
+    if (cmd != "play" && cmd != "go") {
+        fail("unknown command " + cmd);
+        return true;
+    }
+    if (s.thinking) {
+        fail("session " + args[1] + " is thinking");
+        return true;
+    }
+    if (!s.engine.isActive()) {
+        fail("session " + args[1] + " is over");
+        return true;
+    }
+
+    if (cmd == "go") {
+        scheduleMove(session, true);
+        return true;
+    }
+
+    bool okR = false, okC = false;
+    const int r = args.count() == 4 ? args[2].toInt(&okR) : -1;
+    const int c = args.count() == 4 ? args[3].toInt(&okC) : -1;
+    if (!okR || !okC || !s.engine.isMoveAllowed(r, c)) {
+        fail("illegal move");
+        return true;
+    }
+
+    const MoveOutcome out = s.engine.applyMove(r, c);
+    reportMove(s, r, c, out, "ok");
+    scheduleMove(session, false);
+    return true;
+}
+
+void GameServer::dropClient(int client) {
+    std::vector<SessionPtr> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (it->second->client == client) {
+                dropped.push_back(it->second);
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const SessionPtr& session : dropped) {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->closed = true;
+    }
+}
+
+// With the session locked. `force` makes the computer move even for a
+// human side (the go command).
+void GameServer::scheduleMove(const SessionPtr& session, bool force) {
+    Session& s = *session;
+    if (stopping_ || s.closed || s.thinking || !s.engine.isActive()) return;
+    if (!force && !s.engine.isCurrentPlayerComputer()) return;
+
+    s.thinking = true;
+    thinking_.fetch_add(1, std::memory_order_relaxed);
+
+    const auto requested = WorkStealingPool::Clock::now();
+    const auto deadline = requested + std::chrono::milliseconds(s.budgetMs);
+    std::shared_ptr<IGameMode> position(s.engine.clonePosition());
+    pool_.submit(deadline, [this, session, position, requested, deadline]() {
+        think(session, *position, requested, deadline);
+    });
+}
+
+void GameServer::think(const SessionPtr& session, const IGameMode& position,
+                       WorkStealingPool::Clock::time_point requested, WorkStealingPool::Clock::time_point deadline) {
+    using namespace std::chrono;
+
+    const qint64 left = duration_cast<milliseconds>(deadline - WorkStealingPool::Clock::now()).count();
+    if (left <= 0) late_.fetch_add(1, std::memory_order_relaxed);
+
+    const int worker = pool_.currentWorker();
+    GameEngine::SearchRequest request;
+    std::unique_ptr<UltimateSolver>& solver = solvers_[worker];
+    if (!solver && position.mode() == GameMode::Ultimate) solver = std::make_unique<UltimateSolver>();
+    request.ultimateSolver = solver.get();
+
+    int r = -1, c = -1;
+    bool found = false;
+    if (left > 0) {
+        request.budgetMs = static_cast<int>(left);
+        request.cancel = watchdog_->arm(worker, deadline);
+        found = searcher_.pickMove(position, r, c, request);
+        watchdog_->disarm(worker);
+    }
+
+    // Late, or cancelled at the deadline: the heuristic search alone, which
+    // takes well under a millisecond.
+    if (!found && !stopping_) {
+        request.budgetMs = 0;
+        request.cancel = nullptr;
+        found = searcher_.pickMove(position, r, c, request);
+    }
+    if (!found) {
+        const int N = position.boardSize();
+        for (int i = 0; i < N * N && r < 0; ++i) {
+            if (position.isMoveAllowed(i / N, i % N)) {
+                r = i / N;
+                c = i % N;
+            }
+        }
+    }
+
+    recordLatency(duration_cast<microseconds>(WorkStealingPool::Clock::now() - requested).count());
+    moves_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->thinking = false;
+    thinking_.fetch_sub(1, std::memory_order_relaxed);
+    if (session->closed) return;
+    if (r < 0) {
+        session->sink(QString::asprintf("error session %d: no move found", session->id));
+        return;
+    }
+
+    const MoveOutcome out = session->engine.applyMove(r, c);
+    reportMove(*session, r, c, out, "move");
+
+    // Computer against computer goes on by itself.
+    scheduleMove(session, false);
+}
+
+void GameServer::reportMove(Session& session, int r, int c, const MoveOutcome& out, const char* verb) {
+    session.sink(QString::asprintf("%s %d %d %d", verb, session.id, r, c));
+    if (!out.finished) return;
+
+    int winner = out.classicWinner;
+    if (session.engine.mode() == GameMode::Score10x10) {
+        winner = (out.score.xTotal > out.score.oTotal) - (out.score.oTotal > out.score.xTotal);
+    }
+    session.sink(QString::asprintf("over %d %s", session.id, winner > 0 ? "x" : (winner < 0 ? "o" : "draw")));
+}
+
+void GameServer::recordLatency(qint64 micros) {
+    int bucket = 0;
+    while (bucket + 1 < static_cast<int>(latency_.size()) && (micros >> (bucket + 1)) > 0) ++bucket;
+    latency_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+QString GameServer::statsLine() const {
+    std::array<qint64, 32> counts;
+    qint64 total = 0;
+    for (size_t k = 0; k < counts.size(); ++k) {
+        counts[k] = latency_[k].load(std::memory_order_relaxed);
+        total += counts[k];
+    }
+
+    // Upper edge of the bucket holding the given fraction of replies, in ms.
+    auto percentile = [&](double p) {
+        qint64 seen = 0;
+        for (size_t k = 0; k < counts.size(); ++k) {
+            seen += counts[k];
+            if (total > 0 && seen >= p * total) return static_cast<double>(1ll << (k + 1)) / 1000.0;
+        }
+        return 0.0;
+    };
+
+    return QString::asprintf("stats sessions=%d thinking=%d moves=%lld late=%lld p50=%.1fms p99=%.1fms "
+                             "max=%.1fms threads=%d queued=%lld steals=%lld",
+                             sessionCount(), thinking_.load(), static_cast<long long>(moves_.load()),
+                             static_cast<long long>(late_.load()), percentile(0.5), percentile(0.99),
+                             percentile(1.0), pool_.threadCount(), static_cast<long long>(pool_.pending()),
+                             static_cast<long long>(pool_.steals()));
+}
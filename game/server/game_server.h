@@ -0,0 +1,111 @@
+#pragma once
+
+#include "game/game_engine.h"
+#include "game/tournament.h"
+#include "game/server/work_pool.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct ServerOptions {
+    int threads = 0;                   // search threads, 0 = all cores
+    int moveBudgetMs = 200;            // default time from request to computer reply
+    int maxSessions = 100000;
+    EngineConfig engine;               // the computer player of every session
+};
+
+// Many independent games in one process, driven by a line protocol. Every
+// session has its own GameEngine holding its game; the computer's moves of
+// all sessions are searched by one shared, read-only GameEngine on a
+// WorkStealingPool, each with the session's deadline (request time plus
+// its budget). A job shortens the solver limits to the time left and is
+// cancelled if its search is still running at the deadline; it then plays
+// the heuristic move without the solvers, as a job that starts late does,
+// so late replies catch up.
+//
+// Commands, one per line (r, c from 0; replies in brackets):
+//   new <mode> [x=human|computer] [o=human|computer] [size=N] [fill=F]
+//       [budget=ms]                                  [ok <id>]
+//       mode: classic, score, ultimate, kinarow, recursive
+//   play <id> <r> <c>                                [ok <id> <r> <c>]
+//   go <id>      the computer moves for the side to move once
+//   show <id>                         [board <id> <N> <x|o to move> <cells>]
+//   close <id>                                       [closed <id>]
+//   stats        [stats sessions=... thinking=... moves=... p50=... ...]
+//   quit         no computer move is started after it
+// Computer moves arrive as [move <id> <r> <c>], a finished game as
+// [over <id> x|o|draw], failures as [error <message>]. A session whose
+// computer is thinking refuses play and go until the move is in.
+class GameServer {
+public:
+    // Receives reply lines; called from the caller's thread and from pool
+    // threads, so it must be thread-safe.
+    using Sink = std::function<void(const QString& line)>;
+
+    explicit GameServer(const ServerOptions& options);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Loads the shared computer player's files; false when one fails.
+    bool start(QString* error = nullptr);
+
+    // Handles one command from `client`; replies go to `sink`, the
+    // computer's later moves in sessions it opened too. Returns false on
+    // quit, after which computer against computer games stop moving.
+    bool handle(int client, const QString& line, const Sink& sink);
+
+    // Closes every session of a client that went away.
+    void dropClient(int client);
+
+    int sessionCount() const;
+    // Computer moves queued or being searched.
+    int thinkingCount() const { return thinking_.load(); }
+
+private:
+    struct Session;
+    class Watchdog;
+    using SessionPtr = std::shared_ptr<Session>;
+
+    SessionPtr find(int id) const;
+    void scheduleMove(const SessionPtr& session, bool force);
+    void think(const SessionPtr& session, const IGameMode& position, WorkStealingPool::Clock::time_point requested,
+               WorkStealingPool::Clock::time_point deadline);
+    void recordLatency(qint64 micros);
+    QString statsLine() const;
+
+    static void reportMove(Session& session, int r, int c, const MoveOutcome& out, const char* verb);
+
+private:
+    ServerOptions options_;
+    GameEngine searcher_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, SessionPtr> sessions_;
+    int nextId_ = 1;
+
+    std::atomic<bool> stopping_{false};   // quit or destruction; no more moves
+    std::atomic<int> thinking_{0};
+    std::atomic<qint64> moves_{0};
+    std::atomic<qint64> late_{0};
+    std::array<std::atomic<qint64>, 32> latency_{};    // by floor(log2(microseconds))
+
+    // The Ultimate endgame solver of each pool worker, created on its first
+    // late Ultimate position and touched by that worker only.
+    std::vector<std::unique_ptr<UltimateSolver>> solvers_;
+    // Cancels a worker's search at its job's deadline; outlives pool_.
+    std::unique_ptr<Watchdog> watchdog_;
+
+    // Last, so it is destroyed first: its destructor waits for the running
+    // jobs, which use everything above.
+    WorkStealingPool pool_;
+};
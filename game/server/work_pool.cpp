@@ -0,0 +1,110 @@
+#include "work_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+// The pool and worker this thread runs for; none outside a pool.
+thread_local const WorkStealingPool* tlsPool = nullptr;
+thread_local int tlsWorker = -1;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    for (int i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threads; ++i) threads_.emplace_back(&WorkStealingPool::loop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) t.join();
+}
+
+int WorkStealingPool::currentWorker() const {
+    return (tlsPool == this) ? tlsWorker : -1;
+}
+
+bool WorkStealingPool::later(const Item& a, const Item& b) {
+    if (a.deadline != b.deadline) return a.deadline > b.deadline;
+    return a.seq > b.seq;
+}
+
+void WorkStealingPool::submit(Clock::time_point deadline, Job job) {
+    const quint64 seq = seq_.fetch_add(1, std::memory_order_relaxed);
+    const int index = (tlsPool == this) ? tlsWorker : static_cast<int>(seq % queues_.size());
+
+    {
+        Queue& q = *queues_[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.heap.push_back(Item{ deadline, seq, std::move(job) });
+        std::push_heap(q.heap.begin(), q.heap.end(), later);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Taking the lock orders this wake-up after a sleeper's check.
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wake_.notify_one();
+}
+
+bool WorkStealingPool::take(int queue, Item& out) {
+    Queue& q = *queues_[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.heap.empty()) return false;
+
+    std::pop_heap(q.heap.begin(), q.heap.end(), later);
+    out = std::move(q.heap.back());
+    q.heap.pop_back();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::steal(int self, Item& out) {
+    const int n = static_cast<int>(queues_.size());
+    for (;;) {
+        // Earliest front among the other queues; another thief may empty it
+        // first, in which case we look again.
+        int victim = -1;
+        Clock::time_point earliest = Clock::time_point::max();
+        for (int k = 1; k < n; ++k) {
+            const int i = (self + k) % n;
+            Queue& q = *queues_[i];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.heap.empty() && q.heap.front().deadline < earliest) {
+                earliest = q.heap.front().deadline;
+                victim = i;
+            }
+        }
+        if (victim < 0) return false;
+        if (take(victim, out)) {
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+void WorkStealingPool::loop(int index) {
+    tlsPool = this;
+    tlsWorker = index;
+
+    Item item;
+    for (;;) {
+        // Checked before taking work, so queued jobs are dropped on quit.
+        if (quit_.load(std::memory_order_acquire)) return;
+        if (take(index, item) || steal(index, item)) {
+            item.job();
+            item.job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() { return quit_ || pending_.load(std::memory_order_relaxed) > 0; });
+        if (quit_) return;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for short, independent jobs with deadlines.
+// Every worker owns a queue ordered by deadline (earliest first, then
+// submission order). Jobs submitted from outside the pool are spread over
+// the queues round-robin; jobs submitted by a job go to its worker's own
+// queue. A worker runs the earliest job of its own queue and, when that is
+// empty, steals the earliest job among the other queues, so one slow queue
+// does not hold up jobs while other workers idle. Idle workers sleep.
+//
+// Deadlines only order the work: a job past its deadline still runs, and
+// the job itself decides how to use the time left.
+class WorkStealingPool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Job = std::function<void()>;
+
+    // threads <= 0 uses every hardware thread.
+    explicit WorkStealingPool(int threads = 0);
+
+    // Waits for the running jobs; jobs still queued are dropped.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Clock::time_point deadline, Job job);
+
+    int threadCount() const { return static_cast<int>(threads_.size()); }
+    // The worker running the calling job, 0 .. threadCount() - 1; -1 outside
+    // the pool.
+    int currentWorker() const;
+    qint64 pending() const { return pending_.load(std::memory_order_relaxed); }
+    qint64 steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Item {
+        Clock::time_point deadline;
+        quint64 seq = 0;
+        Job job;
+    };
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::vector<Item> heap;         // min-heap on (deadline, seq)
+    };
+
+    static bool later(const Item& a, const Item& b);
+
+    bool take(int queue, Item& out);
+    bool steal(int self, Item& out);
+    void loop(int index);
+
+private:
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<quint64> seq_{0};
+    std::atomic<qint64> pending_{0};
+    std::atomic<qint64> steals_{0};
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> quit_{false};    // set under sleepMutex_, read anywhere
+};
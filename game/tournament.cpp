@@ -0,0 +1,245 @@
+#include "tournament.h"
+
+#include "game/game_engine.h"
+#include "game/modes/classic_mode.h"
+#include "game/modes/kinarow_mode.h"
+#include "game/modes/recursive_ultimate_mode.h"
+#include "game/modes/score_mode.h"
+#include "game/modes/score_mode_fixed.h"
+#include "game/modes/ultimate_mode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kOpeningAttempts = 16;
+
+// The variance estimate behind the LLR is too noisy to stop on before this.
+constexpr int kMinSprtPairs = 16;
+
+std::unique_ptr<IGameMode> createGame(const TournamentOptions& options, quint32 seed) {
+    std::unique_ptr<IGameMode> game;
+    if (options.mode == GameMode::Classic3x3) {
+        game = std::make_unique<ClassicMode>(options.classicBoardSize);
+    } else if (options.mode == GameMode::Score10x10) {
+        GameConfig cfg = ScoreMode::defaultConfig();
+        cfg.seed = seed;
+        game = makeScoreMode(cfg);
+    } else if (options.mode == GameMode::KInARow) {
+        game = std::make_unique<KInARowMode>();
+    } else if (options.mode == GameMode::UltimateRecursive) {
+        game = std::make_unique<RecursiveUltimateMode>();
+    } else {
+        game = std::make_unique<UltimateMode>();
+    }
+
+    game->setFillMode(options.fill);
+    game->startNewGame();
+    return game;
+}
+
+bool randomMove(const IGameMode& game, std::mt19937& rng, int& outR, int& outC) {
+    const int N = game.boardSize();
+    std::vector<int> legal;
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (game.isMoveAllowed(r, c)) legal.push_back(r * N + c);
+        }
+    }
+    if (legal.empty()) return false;
+
+    const int pick = legal[std::uniform_int_distribution<int>(0, static_cast<int>(legal.size()) - 1)(rng)];
+    outR = pick / N;
+    outC = pick % N;
+    return true;
+}
+
+// The pair's starting position: openingPlies random moves that leave the
+// game open. Falls back to the empty board when no attempt does.
+std::unique_ptr<IGameMode> createOpening(const TournamentOptions& options, int pair) {
+    const quint32 seed = options.seed + static_cast<quint32>(pair);
+    std::mt19937 rng(seed);
+
+    for (int attempt = 0; attempt < kOpeningAttempts; ++attempt) {
+        std::unique_ptr<IGameMode> game = createGame(options, seed);
+        int r = -1, c = -1;
+        for (int ply = 0; ply < options.openingPlies && game->isActive() && randomMove(*game, rng, r, c); ++ply) {
+            game->applyMove(r, c);
+        }
+        if (game->isActive()) return game;
+    }
+    return createGame(options, seed);
+}
+
+// Plays the game out from `game` and returns the winner (1 = X, -1 = O).
+// An engine that finds no move plays the first legal one.
+int playGame(IGameMode& game, const GameEngine& x, const GameEngine& o, const std::atomic<bool>* stop,
+             UltimateSolver* xSolver, UltimateSolver* oSolver) {
+    const bool score = game.mode() == GameMode::Score10x10;
+    const int N = game.boardSize();
+
+    while (game.isActive()) {
+        if (stop && stop->load(std::memory_order_relaxed)) return 0;
+
+        const bool xToMove = (game.currentPlayer() == 1);
+        GameEngine::SearchRequest request;
+        request.ultimateSolver = xToMove ? xSolver : oSolver;
+        int r = -1, c = -1;
+        if (!(xToMove ? x : o).pickMove(game, r, c, request) || !game.isMoveAllowed(r, c)) {
+            int i = 0;
+            while (i < N * N && !game.isMoveAllowed(i / N, i % N)) ++i;
+            if (i == N * N) break;
+            r = i / N;
+            c = i % N;
+        }
+
+        const MoveOutcome out = game.applyMove(r, c);
+        if (out.finished) {
+            if (!score) return out.classicWinner;
+            return (out.score.xTotal > out.score.oTotal) - (out.score.oTotal > out.score.xTotal);
+        }
+    }
+
+    const ScoreSnapshot s = game.currentScore();
+    return score ? (s.xTotal > s.oTotal) - (s.oTotal > s.xTotal) : 0;
+}
+
+double eloFromScore(double s) {
+    if (s <= 0.0) return -std::numeric_limits<double>::infinity();
+    if (s >= 1.0) return std::numeric_limits<double>::infinity();
+    return 400.0 * std::log10(s / (1.0 - s));
+}
+
+double scoreFromElo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Score, Elo with its error bars and the SPRT log-likelihood ratio from the
+// pentanomial counts. The LLR uses the normal approximation of the pair
+// scores (GSPRT): N * (s1 - s0) * (2s - s0 - s1) / (2 var).
+void updateStatistics(const TournamentOptions& options, TournamentResult& r) {
+    r.lowerBound = std::log(options.beta / (1.0 - options.alpha));
+    r.upperBound = std::log((1.0 - options.beta) / options.alpha);
+
+    const int n = r.pairs;
+    if (n == 0) return;
+
+    double mean = 0.0;
+    for (int k = 0; k < 5; ++k) mean += r.pentanomial[k] * (k / 4.0);
+    mean /= n;
+
+    double var = 0.0;
+    for (int k = 0; k < 5; ++k) var += r.pentanomial[k] * (k / 4.0 - mean) * (k / 4.0 - mean);
+    var /= n;
+
+    r.score = mean;
+    r.elo = eloFromScore(mean);
+    const double sd = std::sqrt(var / n);
+    r.eloMargin = (eloFromScore(mean + 1.96 * sd) - eloFromScore(mean - 1.96 * sd)) / 2.0;
+
+    if (var <= 0.0) return;
+
+    const double s0 = scoreFromElo(options.elo0);
+    const double s1 = scoreFromElo(options.elo1);
+    r.llr = n * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * var);
+    if (options.sprt && n >= kMinSprtPairs) {
+        if (r.llr >= r.upperBound) r.decision = TournamentResult::Decision::AcceptH1;
+        else if (r.llr <= r.lowerBound) r.decision = TournamentResult::Decision::AcceptH0;
+    }
+}
+
+} // namespace
+
+bool EngineConfig::applyTo(GameEngine& engine, QString* error) const {
+    engine.setClassicSearchDepth(classicSearchDepth);
+    engine.setClassicTablebasePath(classicTablebasePath);
+    engine.setKInARowProverLimits(kInARowProverLimits);
+    engine.setUltimateSolverThreshold(ultimateSolverThreshold);
+    engine.setUltimateSolverLimits(ultimateSolverLimits);
+    engine.setUltimateHeuristicParams(ultimateParams);
+    engine.setScoreSolverThreshold(scoreSolverThreshold);
+    engine.setScoreSolverLimits(scoreSolverLimits);
+
+    if (!engine.setUltimateBookPath(ultimateBookPath, error)) return false;
+    if (!engine.setUltimateNetworkPath(ultimateNetworkPath, error)) return false;
+    engine.setUltimateEvaluator(ultimateNetworkPath.isEmpty() ? UltimateEvaluator::Heuristic
+                                                              : UltimateEvaluator::Network);
+    return true;
+}
+
+bool runTournament(const TournamentOptions& options, const EngineConfig& a, const EngineConfig& b,
+                   TournamentResult& result, QString* error, const std::atomic<bool>* stop,
+                   const std::function<void(const TournamentResult&)>& onPair) {
+    result = TournamentResult();
+    updateStatistics(options, result);
+
+    {
+        GameEngine probe;
+        if (!a.applyTo(probe, error) || !b.applyTo(probe, error)) return false;
+    }
+
+    int threads = options.threads;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::atomic<int> nextPair{0};
+    std::atomic<bool> decided{false};
+    std::mutex mutex;
+
+    auto stopped = [&]() {
+        return decided.load(std::memory_order_relaxed) || (stop && stop->load(std::memory_order_relaxed));
+    };
+
+    auto worker = [&]() {
+        GameEngine engineA, engineB;
+        a.applyTo(engineA);
+        b.applyTo(engineB);
+
+        // One endgame solver per engine, kept for all of this thread's games.
+        std::unique_ptr<UltimateSolver> solverA, solverB;
+        if (options.mode == GameMode::Ultimate) {
+            solverA = std::make_unique<UltimateSolver>();
+            solverB = std::make_unique<UltimateSolver>();
+        }
+
+        for (;;) {
+            if (stopped()) return;
+            const int p = nextPair.fetch_add(1);
+            if (p >= options.pairs) return;
+
+            const std::unique_ptr<IGameMode> opening = createOpening(options, p);
+
+            // A plays X first, then O.
+            std::unique_ptr<IGameMode> game = opening->clone();
+            const int first = playGame(*game, engineA, engineB, stop, solverA.get(), solverB.get());
+            game = opening->clone();
+            const int second = -playGame(*game, engineB, engineA, stop, solverB.get(), solverA.get());
+            if (stop && stop->load()) return;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (result.decision != TournamentResult::Decision::None) return;
+            for (int w : { first, second }) {
+                if (w > 0) result.wins++;
+                else if (w < 0) result.losses++;
+                else result.draws++;
+            }
+            result.pentanomial[first + second + 2]++;
+            result.pairs++;
+            updateStatistics(options, result);
+            if (result.decision != TournamentResult::Decision::None) decided.store(true);
+            if (onPair) onPair(result);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) pool.emplace_back(worker);
+    for (std::thread& t : pool) t.join();
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "game/game_types.h"
+#include "game/ai/kinarow_prover.h"
+#include "game/ai/score_solver.h"
+#include "game/ai/ultimate_params.h"
+#include "game/ai/ultimate_solver.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+
+class GameEngine;
+
+// One side of a tournament: the GameEngine settings that change how the
+// computer plays. Defaults match a fresh GameEngine.
+struct EngineConfig {
+    int classicSearchDepth = 4;
+    QString classicTablebasePath;      // empty = search only
+
+    KInARowProver::Limits kInARowProverLimits{ 20000, 30 };
+
+    int ultimateSolverThreshold = 24;
+    UltimateSolver::Limits ultimateSolverLimits;
+    QString ultimateNetworkPath;       // empty = heuristic evaluation
+    QString ultimateBookPath;          // empty = no opening book
+    UltimateHeuristicParams ultimateParams;
+
+    int scoreSolverThreshold = 6;
+    ScoreSolverLimits scoreSolverLimits;
+
+    // Fails only when the network or the book cannot be loaded.
+    bool applyTo(GameEngine& engine, QString* error = nullptr) const;
+};
+
+struct TournamentOptions {
+    GameMode mode = GameMode::Ultimate;
+    int classicBoardSize = 3;
+    FillMode fill = FillMode::Free;
+    int pairs = 100;                   // upper bound when the SPRT is on
+    int threads = 0;                   // 0 = all cores
+    int openingPlies = 4;              // random moves before the engines take over
+    quint32 seed = 1;
+
+    // Sequential probability ratio test of H0: elo = elo0 against
+    // H1: elo = elo1 (A's Elo over B), stopping as soon as either holds
+    // (not before 16 pairs).
+    bool sprt = true;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+struct TournamentResult {
+    enum class Decision { None, AcceptH0, AcceptH1 };
+
+    int pairs = 0;
+    int wins = 0;                      // A's games
+    int draws = 0;
+    int losses = 0;
+    int pentanomial[5] = {};           // pairs by A's points: 0, 0.5, 1, 1.5, 2
+
+    double score = 0.5;                // A's mean points per game
+    double elo = 0.0;                  // A over B
+    double eloMargin = 0.0;            // 95%, half-width
+
+    double llr = 0.0;
+    double lowerBound = 0.0;
+    double upperBound = 0.0;
+    Decision decision = Decision::None;
+};
+
+// Plays engine A against engine B on a pool of threads. Games come in pairs
+// that share a random opening (and, in Score, the stripes) with the colours
+// swapped, so an unbalanced opening costs both sides alike; results are
+// counted per pair (pentanomial), which is what the Elo error bars and the
+// SPRT are computed from. Every worker has its own two engines. The same
+// seed gives the same openings; with more than one thread the order the
+// pairs finish in, and so where the SPRT stops, can vary.
+//
+// onPair, when set, is called under a lock after every pair with the
+// running totals. `stop` ends the run after the games in progress. Returns
+// false when a configuration cannot be applied.
+bool runTournament(const TournamentOptions& options, const EngineConfig& a, const EngineConfig& b,
+                   TournamentResult& result, QString* error = nullptr,
+                   const std::atomic<bool>* stop = nullptr,
+                   const std::function<void(const TournamentResult&)>& onPair = {});
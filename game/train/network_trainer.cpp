@@ -0,0 +1,145 @@
+#include "network_trainer.h"
+
+#include "game/train/training_shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kH1 = UltimateNetwork::kHidden1;
+constexpr int kH2 = UltimateNetwork::kHidden2;
+
+// Positions as lists of active features, all in one array.
+struct Samples {
+    std::vector<quint8> features;
+    std::vector<qint64> begin;      // start of each sample, then the end
+    std::vector<float> target;      // X's result as 1, 0.5 or 0
+
+    qint64 count() const { return static_cast<qint64>(target.size()); }
+};
+
+bool loadSamples(const QStringList& shards, Samples& out, QString* error) {
+    int active[UltimateNetwork::kMaxActive];
+    for (const QString& path : shards) {
+        TrainingShardReader reader;
+        if (!reader.open(path, error)) return false;
+
+        for (const TrainingRecord& rec : reader) {
+            if (rec.mode != static_cast<quint8>(GameMode::Ultimate)) continue;
+
+            const int n = UltimateNetwork::features(rec.toUltimateBoard(), active);
+            out.begin.push_back(static_cast<qint64>(out.features.size()));
+            out.features.insert(out.features.end(), active, active + n);
+            out.target.push_back(0.5f + 0.5f * rec.result);
+        }
+    }
+    out.begin.push_back(static_cast<qint64>(out.features.size()));
+
+    if (out.count() == 0) {
+        if (error) *error = QStringLiteral("no Ultimate positions in the shards");
+        return false;
+    }
+    return true;
+}
+
+void initialise(UltimateNetwork::Weights& w, quint32 seed) {
+    std::mt19937 rng(seed);
+    auto fill = [&rng](std::vector<float>& v, float scale) {
+        std::uniform_real_distribution<float> dist(-scale, scale);
+        for (float& x : v) x = dist(rng);
+    };
+
+    // Roughly unit-variance sums: about 40 active inputs, then 64 and 32.
+    fill(w.w1, 0.25f);
+    std::fill(w.b1.begin(), w.b1.end(), 0.25f);
+    fill(w.w2, 0.2f);
+    std::fill(w.b2.begin(), w.b2.end(), 0.25f);
+    fill(w.w3, 0.3f);
+    w.b3 = 0.0f;
+}
+
+} // namespace
+
+bool trainUltimateNetwork(const QStringList& shards, const NetworkTrainerOptions& options,
+                          UltimateNetwork::Weights& out, QString* error,
+                          const std::function<void(int epoch, double loss)>& onEpoch) {
+    Samples samples;
+    if (!loadSamples(shards, samples, error)) return false;
+
+    UltimateNetwork::Weights& w = out;
+    initialise(w, options.seed);
+
+    std::vector<qint64> order(static_cast<size_t>(samples.count()));
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(options.seed ^ 0x9E3779B9u);
+
+    float z1[kH1], a1[kH1], z2[kH2], a2[kH2], d1[kH1], d2[kH2];
+    const qint64 steps = static_cast<qint64>(options.epochs) * samples.count();
+    qint64 step = 0;
+
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        double loss = 0.0;
+
+        for (qint64 s : order) {
+            const quint8* f = samples.features.data() + samples.begin[s];
+            const int n = static_cast<int>(samples.begin[s + 1] - samples.begin[s]);
+            const float lr = options.learningRate * (1.0f - 0.5f * static_cast<float>(step++) / steps);
+
+            for (int i = 0; i < kH1; ++i) z1[i] = w.b1[i];
+            for (int k = 0; k < n; ++k) {
+                const float* row = &w.w1[f[k] * kH1];
+                for (int i = 0; i < kH1; ++i) z1[i] += row[i];
+            }
+            for (int i = 0; i < kH1; ++i) a1[i] = std::clamp(z1[i], 0.0f, 1.0f);
+
+            float logit = w.b3;
+            for (int j = 0; j < kH2; ++j) {
+                const float* row = &w.w2[j * kH1];
+                float z = w.b2[j];
+                for (int i = 0; i < kH1; ++i) z += row[i] * a1[i];
+                z2[j] = z;
+                a2[j] = std::clamp(z, 0.0f, 1.0f);
+                logit += w.w3[j] * a2[j];
+            }
+
+            const float p = 1.0f / (1.0f + std::exp(-logit));
+            const float t = samples.target[s];
+            loss -= t * std::log(std::max(p, 1e-7f)) + (1.0f - t) * std::log(std::max(1.0f - p, 1e-7f));
+
+            // Backward pass; the clipped ranges pass no gradient.
+            const float g = p - t;
+            std::fill(d1, d1 + kH1, 0.0f);
+            for (int j = 0; j < kH2; ++j) {
+                d2[j] = (z2[j] > 0.0f && z2[j] < 1.0f) ? g * w.w3[j] : 0.0f;
+                w.w3[j] = std::clamp(w.w3[j] - lr * g * a2[j], -UltimateNetwork::kMaxWeight, UltimateNetwork::kMaxWeight);
+                if (d2[j] == 0.0f) continue;
+
+                float* row = &w.w2[j * kH1];
+                for (int i = 0; i < kH1; ++i) {
+                    d1[i] += d2[j] * row[i];
+                    row[i] = std::clamp(row[i] - lr * d2[j] * a1[i], -UltimateNetwork::kMaxWeight,
+                                        UltimateNetwork::kMaxWeight);
+                }
+                w.b2[j] -= lr * d2[j];
+            }
+            w.b3 -= lr * g;
+
+            for (int i = 0; i < kH1; ++i) {
+                if (z1[i] <= 0.0f || z1[i] >= 1.0f) d1[i] = 0.0f;
+                w.b1[i] -= lr * d1[i];
+            }
+            for (int k = 0; k < n; ++k) {
+                float* row = &w.w1[f[k] * kH1];
+                for (int i = 0; i < kH1; ++i) row[i] -= lr * d1[i];
+            }
+        }
+
+        if (onEpoch) onEpoch(epoch + 1, loss / samples.count());
+    }
+    return true;
+}
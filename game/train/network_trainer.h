@@ -0,0 +1,26 @@
+#pragma once
+
+#include "game/ai/ultimate_network.h"
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <functional>
+
+struct NetworkTrainerOptions {
+    int epochs = 10;
+    float learningRate = 0.01f;     // halved over the run, linearly
+    quint32 seed = 1;               // weight initialisation and sample order
+};
+
+// Fits UltimateNetwork's float model to decided and drawn Ultimate positions
+// from self-play shards: the output is the logit of X winning, trained with
+// cross-entropy against the game result (1, 0.5 or 0 for X) by plain SGD,
+// one position at a time in shuffled order. Layer-2 and output weights are
+// kept within what the int8 quantisation can hold. onEpoch, when set, gets
+// each epoch's mean loss. Returns false when a shard cannot be read or holds
+// no Ultimate positions.
+bool trainUltimateNetwork(const QStringList& shards, const NetworkTrainerOptions& options,
+                          UltimateNetwork::Weights& out, QString* error = nullptr,
+                          const std::function<void(int epoch, double loss)>& onEpoch = {});
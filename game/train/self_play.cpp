@@ -0,0 +1,123 @@
+#include "self_play.h"
+
+#include "game/ai/search_core.h"
+#include "game/ai/ultimate_board.h"
+#include "game/modes/score_mode_fixed.h"
+#include "game/modes/ultimate_mode.h"
+#include "game/train/training_shard.h"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <class Mode>
+bool randomMove(const Mode& game, std::mt19937& rng, int& outR, int& outC) {
+    const int N = game.boardSize();
+    std::vector<int> legal;
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            if (game.isMoveAllowed(r, c)) legal.push_back(r * N + c);
+        }
+    }
+    if (legal.empty()) return false;
+
+    const int pick = legal[std::uniform_int_distribution<int>(0, static_cast<int>(legal.size()) - 1)(rng)];
+    outR = pick / N;
+    outC = pick % N;
+    return true;
+}
+
+// search(game, r, c, value) picks the move and its value for the side to
+// move; result(outcome) maps the final outcome to 1 / -1 / 0 for X.
+template <class Mode, class Encode, class Search, class Result>
+std::vector<TrainingRecord> playGame(Mode game, std::mt19937& rng, int randomPlies,
+                                     Encode encode, Search search, Result result) {
+    std::vector<TrainingRecord> records;
+
+    while (game.isActive()) {
+        int r = -1, c = -1, value = 0;
+        if (game.movesMade() < randomPlies) {
+            // Opening plies are random and not searched, so they give no record.
+            if (!randomMove(game, rng, r, c)) break;
+        } else {
+            TrainingRecord rec = encode(game);
+            if (!search(game, r, c, value)) break;
+            rec.score = value;
+            records.push_back(rec);
+        }
+
+        const MoveOutcome out = game.applyMove(r, c);
+        if (!out.accepted) break;
+        if (out.finished) {
+            const qint8 winner = static_cast<qint8>(result(out));
+            for (TrainingRecord& t : records) t.result = winner;
+            return records;
+        }
+    }
+
+    // Unfinished games carry no label.
+    return {};
+}
+
+std::vector<TrainingRecord> playOne(const SelfPlayOptions& options, quint32 seed) {
+    std::mt19937 rng(seed);
+
+    if (options.mode == GameMode::Score10x10) {
+        GameConfig cfg = ScoreMode::defaultConfig();
+        cfg.seed = seed;
+        ScoreMode10x4 game(cfg);
+        game.setFillMode(options.fill);
+        game.startNewGame();
+
+        return playGame(
+            game, rng, options.randomPlies,
+            [](const ScoreMode10x4& g) { return TrainingRecord::fromScore(g); },
+            [](const ScoreMode10x4& g, int& r, int& c, int& value) {
+                return pickBestScoreMoveDepth2(g, g.currentPlayer(), r, c, &value);
+            },
+            [](const MoveOutcome& out) {
+                return (out.score.xTotal > out.score.oTotal) ? 1 : (out.score.oTotal > out.score.xTotal ? -1 : 0);
+            });
+    }
+
+    UltimateMode game;
+    game.startNewGame();
+    return playGame(
+        game, rng, options.randomPlies,
+        [](const UltimateMode& g) { return TrainingRecord::fromUltimate(UltimateBoard::fromMode(g)); },
+        [](const UltimateMode& g, int& r, int& c, int& value) {
+            return pickBestUltimateMoveDepth2(g, g.currentPlayer(), r, c, &value);
+        },
+        [](const MoveOutcome& out) { return out.classicWinner; });
+}
+
+} // namespace
+
+qint64 runSelfPlay(const SelfPlayOptions& options, TrainingShardWriter& out, const std::atomic<bool>* stop) {
+    int threads = options.threads;
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<qint64> positions{0};
+
+    auto worker = [&]() {
+        for (;;) {
+            if (stop && stop->load()) return;
+            const int g = nextGame.fetch_add(1);
+            if (g >= options.games) return;
+
+            std::vector<TrainingRecord> records = playOne(options, options.seed + static_cast<quint32>(g));
+            positions += static_cast<qint64>(records.size());
+            out.push(std::move(records));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) pool.emplace_back(worker);
+    for (std::thread& t : pool) t.join();
+
+    return positions.load();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "game/game_types.h"
+
+#include <QtGlobal>
+
+#include <atomic>
+
+class TrainingShardWriter;
+
+// Self-play with the computer player's own searches, turned into training
+// positions. Ultimate uses the depth-2 heuristic search, Score the depth-2
+// total-difference search; every position before a move is recorded with the
+// search value for the side to move and, once the game ends, its result.
+struct SelfPlayOptions {
+    GameMode mode = GameMode::Ultimate;   // Ultimate or Score10x10
+    FillMode fill = FillMode::Free;       // Score only
+    int games = 1000;
+    int threads = 0;                      // 0 = one per hardware thread
+    int randomPlies = 4;                  // opening moves played at random for variety, not recorded
+    quint32 seed = 1;                     // game g is seeded with seed + g
+};
+
+// Plays the games across worker threads and pushes each finished game's
+// positions to `out` as one batch. Returns the number of positions produced;
+// setting *stop ends the run after the games in progress.
+qint64 runSelfPlay(const SelfPlayOptions& options, TrainingShardWriter& out,
+                   const std::atomic<bool>* stop = nullptr);
@@ -0,0 +1,206 @@
+#include "training_shard.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[4] = { 'T', 'T', 'T', 'S' };
+constexpr quint32 kVersion = 1;
+constexpr qint64 kHeaderSize = 16;
+
+} // namespace
+
+TrainingRecord TrainingRecord::fromUltimate(const UltimateBoard& b) {
+    TrainingRecord rec;
+    rec.mode = static_cast<quint8>(GameMode::Ultimate);
+    rec.sideToMove = b.player;
+    for (int l = 0; l < 9; ++l) {
+        rec.ultimate.x[l] = b.x[l];
+        rec.ultimate.o[l] = b.o[l];
+        rec.ply = static_cast<quint8>(rec.ply + qPopulationCount(b.x[l]) + qPopulationCount(b.o[l]));
+    }
+    rec.ultimate.macroX = b.macroX;
+    rec.ultimate.macroO = b.macroO;
+    rec.ultimate.macroDrawn = b.macroDrawn;
+    rec.ultimate.forced = b.forced;
+    return rec;
+}
+
+UltimateBoard TrainingRecord::toUltimateBoard() const {
+    UltimateBoard b;
+    for (int l = 0; l < 9; ++l) {
+        b.x[l] = ultimate.x[l];
+        b.o[l] = ultimate.o[l];
+    }
+    b.macroX = ultimate.macroX;
+    b.macroO = ultimate.macroO;
+    b.macroDrawn = ultimate.macroDrawn;
+    b.forced = ultimate.forced;
+    b.player = sideToMove;
+    return b;
+}
+
+TrainingShardWriter::~TrainingShardWriter() {
+    finish();
+}
+
+bool TrainingShardWriter::start(const QString& prefix, qint64 recordsPerShard, QString* error) {
+    finish();
+
+    prefix_ = prefix;
+    perShard_ = recordsPerShard > 0 ? recordsPerShard : 1;
+    closing_ = false;
+    queued_ = 0;
+    inShard_ = 0;
+    written_ = 0;
+    shards_ = 0;
+    error_.clear();
+
+    if (!openShard()) {
+        if (error) *error = error_;
+        return false;
+    }
+
+    thread_ = std::thread(&TrainingShardWriter::run, this);
+    return true;
+}
+
+void TrainingShardWriter::push(std::vector<TrainingRecord> batch) {
+    if (batch.empty()) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this]() { return queued_ < kMaxQueued || closing_; });
+    if (closing_) return;
+
+    queued_ += batch.size();
+    queue_.push_back(std::move(batch));
+    notEmpty_.notify_one();
+}
+
+bool TrainingShardWriter::finish(QString* error) {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        thread_.join();
+    }
+    file_.close();
+
+    if (error) *error = error_;
+    return error_.isEmpty();
+}
+
+qint64 TrainingShardWriter::written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+int TrainingShardWriter::shardCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shards_;
+}
+
+bool TrainingShardWriter::openShard() {
+    file_.close();
+    file_.setFileName(prefix_ + QString::asprintf("-%05d.shard", shards_));
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error_ = file_.errorString();
+        return false;
+    }
+
+    char header[kHeaderSize] = {};
+    const quint32 recordSize = sizeof(TrainingRecord);
+    std::memcpy(header, kMagic, 4);
+    std::memcpy(header + 4, &kVersion, 4);
+    std::memcpy(header + 8, &recordSize, 4);
+    if (file_.write(header, kHeaderSize) != kHeaderSize) {
+        error_ = file_.errorString();
+        return false;
+    }
+
+    inShard_ = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_++;
+    return true;
+}
+
+// Batches may straddle a shard boundary; the remainder goes to a new file.
+void TrainingShardWriter::run() {
+    for (;;) {
+        std::vector<TrainingRecord> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return !queue_.empty() || closing_; });
+            if (queue_.empty()) return;
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+            queued_ -= batch.size();
+        }
+        notFull_.notify_all();
+
+        if (!error_.isEmpty()) continue;
+
+        size_t done = 0;
+        while (done < batch.size()) {
+            if (inShard_ == perShard_ && !openShard()) break;
+
+            const size_t n = std::min(batch.size() - done, static_cast<size_t>(perShard_ - inShard_));
+            const qint64 bytes = static_cast<qint64>(n * sizeof(TrainingRecord));
+            if (file_.write(reinterpret_cast<const char*>(batch.data() + done), bytes) != bytes) {
+                error_ = file_.errorString();
+                break;
+            }
+            done += n;
+            inShard_ += static_cast<qint64>(n);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            written_ += static_cast<qint64>(n);
+        }
+    }
+}
+
+TrainingShardReader::~TrainingShardReader() {
+    close();
+}
+
+bool TrainingShardReader::open(const QString& path, QString* error) {
+    close();
+
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        if (error) *error = file_.errorString();
+        return false;
+    }
+
+    const qint64 size = file_.size();
+    data_ = (size >= kHeaderSize) ? file_.map(0, size) : nullptr;
+
+    quint32 version = 0;
+    quint32 recordSize = 0;
+    if (data_) {
+        std::memcpy(&version, data_ + 4, 4);
+        std::memcpy(&recordSize, data_ + 8, 4);
+    }
+    if (!data_ || std::memcmp(data_, kMagic, 4) != 0 || version != kVersion ||
+        recordSize != sizeof(TrainingRecord)) {
+        if (error) *error = QStringLiteral("not a training shard");
+        close();
+        return false;
+    }
+
+    records_ = reinterpret_cast<const TrainingRecord*>(data_ + kHeaderSize);
+    count_ = (size - kHeaderSize) / static_cast<qint64>(sizeof(TrainingRecord));
+    return true;
+}
+
+void TrainingShardReader::close() {
+    if (data_) file_.unmap(const_cast<uchar*>(data_));
+    data_ = nullptr;
+    records_ = nullptr;
+    count_ = 0;
+    file_.close();
+}
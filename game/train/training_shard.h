@@ -0,0 +1,167 @@
+#pragma once
+
+#include "game/ai/ultimate_board.h"
+#include "game/game_types.h"
+#include "game/modes/igame_mode.h"
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One training position: the state before a move, the search value for the
+// side to move and the final result. Fixed 64 bytes so shards can be mapped
+// and indexed directly.
+struct TrainingRecord {
+    struct Ultimate {
+        quint16 x[9];
+        quint16 o[9];
+        quint16 macroX;
+        quint16 macroO;
+        quint16 macroDrawn;
+        qint8 forced;
+    };
+
+    // Bit r * 10 + c of x / o (low word first) for a 10x10 board.
+    struct Score {
+        quint64 x[2];
+        quint64 o[2];
+        qint16 xLine;
+        qint16 oLine;
+        qint16 xSpent;
+        qint16 oSpent;
+        qint8 activeRow;
+        qint8 activeCol;
+        quint8 fill;
+    };
+
+    quint8 mode = 0;         // GameMode
+    qint8 sideToMove = 1;    // 1 = X, -1 = O
+    qint8 result = 0;        // final result for X: 1, -1 or 0
+    quint8 ply = 0;
+    qint32 score = 0;        // search value for the side to move
+
+    union {
+        Ultimate ultimate;
+        Score score10;
+        quint8 raw[56];
+    };
+
+    TrainingRecord() : raw{} {}
+
+    // Result from the point of view of the side to move.
+    int resultForMover() const { return result * sideToMove; }
+
+    static TrainingRecord fromUltimate(const UltimateBoard& b);
+    UltimateBoard toUltimateBoard() const;
+
+    template <class Mode>
+    static TrainingRecord fromScore(const Mode& state);
+};
+
+static_assert(sizeof(TrainingRecord) == 64, "training records are 64 bytes");
+
+// Writes records to numbered shard files ("<prefix>-00000.shard", ...) of at
+// most recordsPerShard records each. Producers hand over whole batches;
+// a single writer thread owns the files, so producers only wait when the
+// queue is full, never on the disk itself.
+//
+// Shard layout: 16-byte header ("TTTS", version, record size), then records.
+class TrainingShardWriter {
+public:
+    TrainingShardWriter() = default;
+    ~TrainingShardWriter();
+
+    TrainingShardWriter(const TrainingShardWriter&) = delete;
+    TrainingShardWriter& operator=(const TrainingShardWriter&) = delete;
+
+    bool start(const QString& prefix, qint64 recordsPerShard = 1 << 20, QString* error = nullptr);
+
+    // Thread-safe.
+    void push(std::vector<TrainingRecord> batch);
+
+    // Drains the queue and closes the last shard. Returns false if a write
+    // failed along the way.
+    bool finish(QString* error = nullptr);
+
+    qint64 written() const;
+    int shardCount() const;
+
+private:
+    void run();
+    bool openShard();
+
+private:
+    static constexpr size_t kMaxQueued = 1 << 16;
+
+    QString prefix_;
+    qint64 perShard_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<std::vector<TrainingRecord>> queue_;
+    size_t queued_ = 0;
+    bool closing_ = false;
+    std::thread thread_;
+
+    QFile file_;
+    qint64 inShard_ = 0;
+    qint64 written_ = 0;
+    int shards_ = 0;
+    QString error_;
+};
+
+// Read-only view of one shard, mapped on open.
+class TrainingShardReader {
+public:
+    TrainingShardReader() = default;
+    ~TrainingShardReader();
+
+    TrainingShardReader(const TrainingShardReader&) = delete;
+    TrainingShardReader& operator=(const TrainingShardReader&) = delete;
+
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+
+    qint64 count() const { return count_; }
+    const TrainingRecord& at(qint64 i) const { return records_[i]; }
+    const TrainingRecord* begin() const { return records_; }
+    const TrainingRecord* end() const { return records_ + count_; }
+
+private:
+    QFile file_;
+    const uchar* data_ = nullptr;
+    const TrainingRecord* records_ = nullptr;
+    qint64 count_ = 0;
+};
+
+template <class Mode>
+TrainingRecord TrainingRecord::fromScore(const Mode& state) {
+    TrainingRecord rec;
+    rec.mode = static_cast<quint8>(GameMode::Score10x10);
+    rec.sideToMove = static_cast<qint8>(state.currentPlayer());
+    rec.ply = static_cast<quint8>(state.movesMade());
+
+    const int N = state.boardSize();
+    for (int i = 0; i < N * N && i < 128; ++i) {
+        const int owner = state.cellOwner(i / N, i % N);
+        if (owner == 1) rec.score10.x[i >> 6] |= quint64(1) << (i & 63);
+        else if (owner == -1) rec.score10.o[i >> 6] |= quint64(1) << (i & 63);
+    }
+
+    const ScoreSnapshot s = state.currentScore();
+    rec.score10.xLine = static_cast<qint16>(s.xLine);
+    rec.score10.oLine = static_cast<qint16>(s.oLine);
+    rec.score10.xSpent = static_cast<qint16>(s.xSpent);
+    rec.score10.oSpent = static_cast<qint16>(s.oSpent);
+    rec.score10.activeRow = static_cast<qint8>(state.activeRow());
+    rec.score10.activeCol = static_cast<qint8>(state.activeCol());
+    rec.score10.fill = static_cast<quint8>(state.fillMode());
+    return rec;
+}
@@ -3,17 +3,22 @@
 #include "statsdialog.h"
 #include "ui/rulesdialog.h"
 
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QWidget>
 #include <QPushButton>
 #include <QComboBox>
 #include <QLabel>
 #include <QCheckBox>
+#include <QSpinBox>
 #include <QTimer>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QGroupBox>
 #include <QString>
 
+#include <algorithm>
+
 static QString markText(int p) {
 if (p == 1) return "X";
 if (p == -1) return "O";
@@ -27,9 +32,21 @@ retranslateUi();
 cbLanguage_->setCurrentIndex(0);
 cbMode_->setCurrentIndex(0);
 cbFill_->setCurrentIndex(0);
+cbClassicSize_->setCurrentIndex(0);
 
 cbXComputer_->setChecked(false);
 cbOComputer_->setChecked(true);
+cbPonder_->setChecked(true);
+engine_.setPonderEnabled(true);
+engine_.setClassicTablebasePath(QCoreApplication::applicationDirPath() + "/classic4.tb");
+engine_.setUltimateNetworkPath(QCoreApplication::applicationDirPath() + "/ultimate.nnue");
+engine_.setUltimateBookPath(QCoreApplication::applicationDirPath() + "/ultimate.book");
+UltimateHeuristicParams ultimateParams;
+if (ultimateParams.load(QCoreApplication::applicationDirPath() + "/ultimate.params")) {
+    engine_.setUltimateHeuristicParams(ultimateParams);
+}
+engine_.setGameLogPath(QCoreApplication::applicationDirPath() + "/games.tlog");
+stats_.open(QCoreApplication::applicationDirPath() + "/stats.tstat");
 
 connect(btnNewGame_, &QPushButton::clicked, this, &MainWindow::onNewGame);
 connect(btnStats_, &QPushButton::clicked, this, &MainWindow::onShowStats);
@@ -39,15 +56,34 @@ connect(cbLanguage_, QOverload<int>::of(&QComboBox::currentIndexChanged),
         this, &MainWindow::onLanguageChanged);
 connect(cbMode_, QOverload<int>::of(&QComboBox::currentIndexChanged),
         this, &MainWindow::onModeChanged);
+connect(cbClassicSize_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+        this, &MainWindow::onClassicSizeChanged);
 connect(cbFill_, QOverload<int>::of(&QComboBox::currentIndexChanged),
         this, &MainWindow::onFillModeChanged);
 
 connect(cbXComputer_, &QCheckBox::toggled, this, &MainWindow::onPlayerTypeChanged);
 connect(cbOComputer_, &QCheckBox::toggled, this, &MainWindow::onPlayerTypeChanged);
+connect(cbPonder_, &QCheckBox::toggled, this, &MainWindow::onPonderToggled);
+connect(cbAnalysis_, &QCheckBox::toggled, this, &MainWindow::onAnalysisToggled);
+connect(cbNetwork_, &QCheckBox::toggled, this, &MainWindow::onNetworkToggled);
 
 connect(showWeightsCheck_, &QCheckBox::toggled, this, &MainWindow::onShowWeightsToggled);
 
+thinkTimer_ = new QTimer(this);
+thinkTimer_->setInterval(33);
+connect(thinkTimer_, &QTimer::timeout, this, &MainWindow::onThinkTick);
+
+analysisTimer_ = new QTimer(this);
+analysisTimer_->setInterval(100);
+connect(analysisTimer_, &QTimer::timeout, this, &MainWindow::onAnalysisTick);
+
+seriesTimer_ = new QTimer(this);
+seriesTimer_->setInterval(33);
+connect(seriesTimer_, &QTimer::timeout, this, &MainWindow::onSeriesTick);
+connect(btnSeries_, &QPushButton::clicked, this, &MainWindow::onSeriesClicked);
+
 connect(board_, &BoardWidget::cellClicked, this, &MainWindow::onCellClicked);
+connect(board_, &BoardWidget::cellHovered, this, &MainWindow::onCellHovered);
 
 setMinimumSize(900, 600);
 
@@ -57,6 +93,8 @@ refreshBoard();
 updateInfoLabel();
 updateRulesButton();
 updateShowWeightsControls();
+updateClassicSizeControls();
+updateNetworkControls();
 maybeScheduleComputer();
 
 
@@ -95,6 +133,12 @@ cbMode_ = new QComboBox(grpSettings);
 cbMode_->addItem("3x3 mode");
 cbMode_->addItem("10x10 mode");
 cbMode_->addItem("Ultimate mode");
+cbMode_->addItem("15x15 five in a row");
+cbMode_->addItem("Ultimate 27x27");
+
+cbClassicSize_ = new QComboBox(grpSettings);
+cbClassicSize_->addItem("3x3");
+cbClassicSize_->addItem("4x4");
 
 lblFill_ = new QLabel(grpSettings);
 cbFill_ = new QComboBox(grpSettings);
@@ -112,6 +156,15 @@ showWeightsCheck_->setVisible(false);
 
 cbXComputer_ = new QCheckBox(root);
 cbOComputer_ = new QCheckBox(root);
+cbPonder_ = new QCheckBox(root);
+cbAnalysis_ = new QCheckBox(root);
+cbNetwork_ = new QCheckBox(root);
+
+lblSeries_ = new QLabel(grpSettings);
+spSeriesGames_ = new QSpinBox(grpSettings);
+spSeriesGames_->setRange(1, 1000000);
+spSeriesGames_->setValue(100);
+btnSeries_ = new QPushButton(grpSettings);
 
 settingsLayout->addWidget(lblLanguage_);
 settingsLayout->addWidget(cbLanguage_);
@@ -119,6 +172,7 @@ settingsLayout->addSpacing(8);
 
 settingsLayout->addWidget(lblMode_);
 settingsLayout->addWidget(cbMode_);
+settingsLayout->addWidget(cbClassicSize_);
 settingsLayout->addSpacing(8);
 
 settingsLayout->addWidget(lblFill_);
@@ -130,6 +184,14 @@ settingsLayout->addWidget(showWeightsCheck_);
 settingsLayout->addSpacing(8);
 settingsLayout->addWidget(cbXComputer_);
 settingsLayout->addWidget(cbOComputer_);
+settingsLayout->addWidget(cbPonder_);
+settingsLayout->addWidget(cbAnalysis_);
+settingsLayout->addWidget(cbNetwork_);
+
+settingsLayout->addSpacing(8);
+settingsLayout->addWidget(lblSeries_);
+settingsLayout->addWidget(spSeriesGames_);
+settingsLayout->addWidget(btnSeries_);
 
 grpSettings->setLayout(settingsLayout);
 leftPanel->addWidget(grpSettings);
@@ -163,6 +225,10 @@ if (lang_ == UiLang::RU) {
     lblFill_->setText("Заполнение (только Score)");
     cbXComputer_->setText("X — компьютер");
     cbOComputer_->setText("O — компьютер");
+    cbPonder_->setText("Думать во время хода соперника");
+    cbAnalysis_->setText("Анализ ходов");
+    cbNetwork_->setText("Нейросеть (Ultimate)");
+    lblSeries_->setText("Серия компьютер — компьютер, партий");
 
     cbFill_->setItemText(0, "Свободно");
     cbFill_->setItemText(1, "Сверху вниз (строки)");
@@ -184,6 +250,10 @@ if (lang_ == UiLang::RU) {
     lblFill_->setText("Fill (Score only)");
     cbXComputer_->setText("X is computer");
     cbOComputer_->setText("O is computer");
+    cbPonder_->setText("Think on opponent's time");
+    cbAnalysis_->setText("Move analysis");
+    cbNetwork_->setText("Network evaluation (Ultimate)");
+    lblSeries_->setText("Computer vs computer series, games");
 
     cbFill_->setItemText(0, "Free");
     cbFill_->setItemText(1, "Top-down rows");
@@ -196,7 +266,9 @@ if (lang_ == UiLang::RU) {
     showWeightsCheck_->setText("Show cell weights");
 }
 
-updateInfoLabel();
+updateSeriesControls();
+if (isSeriesActive()) showSeriesProgress();
+else updateInfoLabel();
 updateRulesButton();
 updateShowWeightsControls();
 
@@ -205,6 +277,7 @@ updateShowWeightsControls();
 
 void MainWindow::syncUiToEngine() {
 GameMode mode = static_cast<GameMode>(cbMode_->currentIndex());
+engine_.setClassicBoardSize(3 + cbClassicSize_->currentIndex());
 engine_.setMode(mode);
 
 FillMode fill = static_cast<FillMode>(cbFill_->currentIndex());
@@ -228,18 +301,47 @@ if (!score) {
 
 }
 
+void MainWindow::updateClassicSizeControls() {
+cbClassicSize_->setVisible(engine_.mode() == GameMode::Classic3x3);
+}
+
+// Shown in Ultimate only; usable only when ultimate.nnue was found next to
+// the executable.
+void MainWindow::updateNetworkControls() {
+cbNetwork_->setVisible(engine_.mode() == GameMode::Ultimate);
+cbNetwork_->setEnabled(engine_.hasUltimateNetwork());
+}
+
+void MainWindow::onNetworkToggled(bool checked) {
+stopAnalysis();
+engine_.setUltimateEvaluator(checked ? UltimateEvaluator::Network : UltimateEvaluator::Heuristic);
+updateAnalysis();
+maybeScheduleComputer();
+}
+
 void MainWindow::onShowWeightsToggled(bool checked) {
 Q_UNUSED(checked);
 refreshBoard();
 }
 
-void MainWindow::refreshBoard() {
-const int N = engine_.boardSize();
+void MainWindow::setBoardGeometry(int N) {
 board_->setBoardSize(N);
 
 if (N == 3) board_->setCellSizePx(140);
+else if (N == 4) board_->setCellSizePx(110);
 else if (N == 9) board_->setCellSizePx(48);
+else if (N >= 27) board_->setCellSizePx(22);
+else if (N >= 15) board_->setCellSizePx(36);
 else board_->setCellSizePx(64);
+}
+
+void MainWindow::refreshBoard() {
+if (isSeriesActive()) return;
+
+const int N = engine_.boardSize();
+setBoardGeometry(N);
+board_->setHoverPreview(-1, -1, QString());
+hoverPreview_ = false;
 
 const bool score = (engine_.mode() == GameMode::Score10x10);
 board_->setShowWeights(score && showWeightsCheck_->isChecked());
@@ -260,6 +362,8 @@ for (int r = 0; r < N; ++r) {
     }
 }
 
+updateAnalysis();
+
 
 }
 
@@ -301,9 +405,10 @@ return "";
 }
 
 void MainWindow::updateInfoLabel() {
+if (isSeriesActive()) return;
 if (!engine_.isActive()) return;
 
-if (engine_.mode() == GameMode::Classic3x3) {
+if (engine_.mode() == GameMode::Classic3x3 || engine_.mode() == GameMode::KInARow) {
     lblInfo_->setText(
         (lang_ == UiLang::RU)
             ? QString("Ход: %1").arg(markText(engine_.currentPlayer()))
@@ -336,6 +441,35 @@ if (engine_.mode() == GameMode::Ultimate) {
     return;
 }
 
+if (engine_.mode() == GameMode::UltimateRecursive) {
+    const int level = engine_.activeBoardLevel();
+    const int ar = engine_.activeRow();
+    const int ac = engine_.activeCol();
+
+    QString boardInfo;
+    if (level < 0) {
+        boardInfo = (lang_ == UiLang::RU) ? "Можно ходить в любое поле" : "You can play in any board";
+    } else if (level == 1) {
+        boardInfo = (lang_ == UiLang::RU)
+            ? QString("Активное малое поле: (%1,%2)").arg(ar + 1).arg(ac + 1)
+            : QString("Active local board: (%1,%2)").arg(ar + 1).arg(ac + 1);
+    } else {
+        boardInfo = (lang_ == UiLang::RU)
+            ? QString("Активное поле 9×9: (%1,%2)").arg(ar + 1).arg(ac + 1)
+            : QString("Active 9×9 board: (%1,%2)").arg(ar + 1).arg(ac + 1);
+    }
+
+    lblInfo_->setText(
+        QString("Ultimate 27×27\n") +
+        boardInfo +
+        QString("\n\n") +
+        ((lang_ == UiLang::RU)
+            ? QString("Ход: %1").arg(markText(engine_.currentPlayer()))
+            : QString("Turn: %1").arg(markText(engine_.currentPlayer())))
+    );
+    return;
+}
+
 ScoreSnapshot s = engine_.currentScore();
 lblInfo_->setText(
     (lang_ == UiLang::RU ? "Score mode\n" : "Score mode\n") +
@@ -357,8 +491,20 @@ btnRules_->setEnabled(engine_.mode() != GameMode::Classic3x3);
 
 void MainWindow::maybeScheduleComputer() {
 if (computerStepScheduled_) return;
+if (thinkTimer_ && thinkTimer_->isActive()) return;
+if (isSeriesActive()) return;
 if (!engine_.isActive()) return;
-if (!engine_.isCurrentPlayerComputer()) return;
+if (!engine_.isCurrentPlayerComputer()) {
+    engine_.startPondering();
+    return;
+}
+
+// A pondered reply needs no search, so it is played at once rather than
+// after the delay.
+if (engine_.hasPonderedReply() && engine_.startComputerMove()) {
+    onThinkTick();
+    return;
+}
 
 computerStepScheduled_ = true;
 QTimer::singleShot(150, this, &MainWindow::doComputerStep);
@@ -368,12 +514,32 @@ QTimer::singleShot(150, this, &MainWindow::doComputerStep);
 
 void MainWindow::doComputerStep() {
 computerStepScheduled_ = false;
+if (isSeriesActive()) return;
 
 if (!engine_.isActive()) return;
 if (!engine_.isCurrentPlayerComputer()) return;
+if (!engine_.startComputerMove()) return;
 
-MoveOutcome out = engine_.doComputerMove();
-if (!out.accepted) return;
+thinkSeq_ = 0;
+thinkTimer_->start();
+}
+
+// A search cancelled by a new game or a settings change yields no move; the
+// new position may still want one.
+void MainWindow::onThinkTick() {
+if (engine_.isThinking()) {
+    showSearchProgress();
+    return;
+}
+
+thinkTimer_->stop();
+board_->setHighlightedCell(-1, -1);
+
+MoveOutcome out = engine_.finishComputerMove();
+if (!out.accepted) {
+    maybeScheduleComputer();
+    return;
+}
 
 refreshBoard();
 
@@ -388,11 +554,30 @@ maybeScheduleComputer();
 
 }
 
+void MainWindow::showSearchProgress() {
+SearchProgress p;
+if (!engine_.searchProgress().read(p, thinkSeq_)) return;
+
+board_->setHighlightedCell(p.bestR, p.bestC);
+
+const bool ru = (lang_ == UiLang::RU);
+const QString depth = (p.depth > 0) ? QString::number(p.depth) : (ru ? "решатель" : "solver");
+const QString best = (p.bestR >= 0) ? QString("(%1,%2)").arg(p.bestR + 1).arg(p.bestC + 1) : QString("—");
+
+updateInfoLabel();
+lblInfo_->setText(lblInfo_->text() + "\n\n" + (ru
+    ? QString("Компьютер думает…\nГлубина: %1, лучший ход: %2, оценка: %3\nУзлов: %4 (%5 в секунду)")
+    : QString("Computer is thinking…\nDepth: %1, best move: %2, score: %3\nNodes: %4 (%5 per second)"))
+    .arg(depth, best).arg(p.score).arg(p.nodes).arg(p.nodesPerSecond));
+}
+
 void MainWindow::applyFinishedResult(const MoveOutcome& out) {
-if (engine_.mode() == GameMode::Classic3x3 || engine_.mode() == GameMode::Ultimate) {
+if (engine_.mode() == GameMode::Classic3x3 || engine_.mode() == GameMode::Ultimate ||
+    engine_.mode() == GameMode::KInARow || engine_.mode() == GameMode::UltimateRecursive) {
 if (out.classicWinner == 1) xWins_++;
 else if (out.classicWinner == -1) oWins_++;
 else draws_++;
+recordResult(out.classicWinner);
 
     if (lang_ == UiLang::RU) {
         lblInfo_->setText(out.classicWinner == 0 ? "Ничья." : QString("Победа %1!").arg(markText(out.classicWinner)));
@@ -406,6 +591,7 @@ ScoreSnapshot s = out.score;
 if (s.xTotal > s.oTotal) xWins_++;
 else if (s.oTotal > s.xTotal) oWins_++;
 else draws_++;
+recordResult((s.xTotal > s.oTotal) - (s.oTotal > s.xTotal));
 
 QString result = (s.xTotal > s.oTotal) ? "X" : (s.oTotal > s.xTotal ? "O" : "D");
 
@@ -428,6 +614,24 @@ if (lang_ == UiLang::RU) {
 
 }
 
+void MainWindow::recordResult(int winner) {
+StatsResult r;
+r.timestamp = QDateTime::currentMSecsSinceEpoch();
+r.mode = engine_.mode();
+r.fill = engine_.fillMode();
+r.xType = engine_.playerTypeX();
+r.oType = engine_.playerTypeO();
+r.winner = winner;
+r.boardSize = engine_.boardSize();
+r.moves = engine_.movesMade();
+stats_.record(r);
+}
+
+void MainWindow::onPonderToggled(bool checked) {
+engine_.setPonderEnabled(checked);
+maybeScheduleComputer();
+}
+
 void MainWindow::onPlayerTypeChanged() {
 syncUiToEngine();
 refreshBoard();
@@ -451,6 +655,7 @@ maybeScheduleComputer();
 }
 
 void MainWindow::onCellClicked(int r, int c) {
+if (isSeriesActive()) return;
 if (!engine_.isActive()) return;
 
 MoveOutcome out = engine_.applyMove(r, c);
@@ -469,9 +674,212 @@ maybeScheduleComputer();
 
 }
 
+// Score: shows what the hovered move would add to the line score and spend
+// for the human to move, from one batched pass over the board.
+void MainWindow::onCellHovered(int r, int c) {
+std::vector<ScoreMoveDelta> deltas;
+const bool preview = r >= 0 && c >= 0 && !isSeriesActive() && engine_.isActive() &&
+                     !engine_.isCurrentPlayerComputer() && engine_.isMoveAllowed(r, c) &&
+                     engine_.scoreMoveDeltas(deltas);
+if (!preview) {
+    board_->setHoverPreview(-1, -1, QString());
+    if (hoverPreview_) updateInfoLabel();
+    hoverPreview_ = false;
+    return;
+}
+
+const ScoreMoveDelta& d = deltas[r * engine_.boardSize() + c];
+const int net = d.net();
+const QString netText = (net > 0) ? QString("+%1").arg(net) : QString::number(net);
+board_->setHoverPreview(r, c, netText);
+
+updateInfoLabel();
+lblInfo_->setText(lblInfo_->text() + "\n\n" + ((lang_ == UiLang::RU)
+    ? QString("Ход (%1,%2): линии +%3, расход %4, итог %5").arg(r + 1).arg(c + 1).arg(d.line).arg(d.spend).arg(netText)
+    : QString("Move (%1,%2): lines +%3, spend %4, net %5").arg(r + 1).arg(c + 1).arg(d.line).arg(d.spend).arg(netText)));
+hoverPreview_ = true;
+}
+
+// Runs while a human is to move in a game on screen; the analysis works on a
+// copy, so only a different position needs a restart.
+void MainWindow::updateAnalysis() {
+const bool wanted = cbAnalysis_->isChecked() && !isSeriesActive() &&
+                    engine_.isActive() && !engine_.isCurrentPlayerComputer();
+if (!wanted) {
+    stopAnalysis();
+    return;
+}
+
+const quint64 hash = engine_.positionHash();
+if (analysisShown_ && hash == analysedHash_) return;
+
+board_->clearHeat();
+engine_.startAnalysis();
+analysedHash_ = hash;
+analysisShown_ = true;
+analysisVersion_ = 0;
+analysisTimer_->start();
+}
+
+void MainWindow::stopAnalysis() {
+if (!analysisShown_) return;
+engine_.stopAnalysis();
+analysisTimer_->stop();
+board_->clearHeat();
+analysisShown_ = false;
+}
+
+void MainWindow::onAnalysisToggled(bool) {
+updateAnalysis();
+}
+
+void MainWindow::onAnalysisTick() {
+const bool running = engine_.isAnalysing();
+
+std::vector<MoveEval> evals;
+if (engine_.analysis(evals, analysisVersion_)) showAnalysis(evals);
+if (!running) analysisTimer_->stop();
+}
+
+// Shades by rank rather than by value: a single winning or losing score
+// would otherwise squeeze every other move into one colour.
+void MainWindow::showAnalysis(const std::vector<MoveEval>& evals) {
+const int N = engine_.boardSize();
+if (static_cast<int>(evals.size()) != N * N) return;
+
+std::vector<int> scores;
+for (const MoveEval& e : evals) {
+    if (e.depth > 0) scores.push_back(e.score);
+}
+std::sort(scores.begin(), scores.end());
+scores.erase(std::unique(scores.begin(), scores.end()), scores.end());
+
+for (int i = 0; i < N * N; ++i) {
+    const MoveEval& e = evals[i];
+    if (e.depth == 0) {
+        board_->setCellHeat(i / N, i % N, -1.0, QString());
+        continue;
+    }
+
+    const int rank = static_cast<int>(std::lower_bound(scores.begin(), scores.end(), e.score) - scores.begin());
+    const double heat = (scores.size() > 1) ? static_cast<double>(rank) / (scores.size() - 1) : 1.0;
+    const QString label = (e.score > 0) ? QString("+%1").arg(e.score) : QString::number(e.score);
+    board_->setCellHeat(i / N, i % N, heat, label);
+}
+}
+
+bool MainWindow::isSeriesActive() const {
+return seriesTimer_ && seriesTimer_->isActive();
+}
+
+void MainWindow::onSeriesClicked() {
+if (isSeriesActive()) series_.stop();
+else startSeries();
+}
+
+// The series uses the mode settings on screen with both sides played by the
+// computer; the game in the main engine is left as it is and shown again
+// when the series ends.
+void MainWindow::startSeries() {
+engine_.cancelComputerMove();
+engine_.stopPondering();
+stopAnalysis();
+thinkTimer_->stop();
+board_->setHighlightedCell(-1, -1);
+
+SeriesOptions options;
+options.mode = static_cast<GameMode>(cbMode_->currentIndex());
+options.classicBoardSize = 3 + cbClassicSize_->currentIndex();
+options.fill = static_cast<FillMode>(cbFill_->currentIndex());
+options.games = spSeriesGames_->value();
+options.classicTablebasePath = QCoreApplication::applicationDirPath() + "/classic4.tb";
+options.ultimateParams = engine_.ultimateHeuristicParams();
+if (engine_.hasUltimateBook()) options.ultimateBookPath = QCoreApplication::applicationDirPath() + "/ultimate.book";
+if (cbNetwork_->isChecked()) options.ultimateNetworkPath = QCoreApplication::applicationDirPath() + "/ultimate.nnue";
+
+seriesProgress_ = SeriesProgress();
+seriesVersion_ = 0;
+series_.start(options, &stats_);
+seriesTimer_->start();
+
+board_->setShowWeights(false);
+updateSeriesControls();
+showSeriesProgress();
+}
+
+void MainWindow::onSeriesTick() {
+if (!series_.progress(seriesProgress_, seriesVersion_)) return;
+
+showSeriesProgress();
+if (!seriesProgress_.running) finishSeries();
+}
+
+void MainWindow::finishSeries() {
+seriesTimer_->stop();
+series_.stop();
+
+gamesPlayed_ += seriesProgress_.gamesDone;
+xWins_ += seriesProgress_.xWins;
+oWins_ += seriesProgress_.oWins;
+draws_ += seriesProgress_.draws;
+
+updateSeriesControls();
+refreshBoard();
+updateInfoLabel();
+maybeScheduleComputer();
+}
+
+void MainWindow::showSeriesProgress() {
+const SeriesProgress& p = seriesProgress_;
+const int N = p.boardSize;
+if (N > 0 && static_cast<int>(p.cells.size()) == N * N) {
+    if (board_->boardSize() != N) setBoardGeometry(N);
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            board_->setCellText(r, c, markText(p.cells[r * N + c]), false);
+        }
+    }
+}
+
+const double seconds = p.elapsedMs / 1000.0;
+const double movesPerSecond = seconds > 0 ? p.moves / seconds : 0.0;
+if (lang_ == UiLang::RU) {
+    lblInfo_->setText(
+        QString("Серия: партия %1 из %2\n").arg(qMin(p.gamesDone + 1, p.games)).arg(p.games) +
+        QString("Победы X: %1, O: %2, ничьи: %3\n").arg(p.xWins).arg(p.oWins).arg(p.draws) +
+        QString("Ходов: %1 (%2 в секунду)").arg(p.moves).arg(movesPerSecond, 0, 'f', 0)
+    );
+} else {
+    lblInfo_->setText(
+        QString("Series: game %1 of %2\n").arg(qMin(p.gamesDone + 1, p.games)).arg(p.games) +
+        QString("X wins: %1, O wins: %2, draws: %3\n").arg(p.xWins).arg(p.oWins).arg(p.draws) +
+        QString("Moves: %1 (%2 per second)").arg(p.moves).arg(movesPerSecond, 0, 'f', 0)
+    );
+}
+}
+
+void MainWindow::updateSeriesControls() {
+const bool active = isSeriesActive();
+if (lang_ == UiLang::RU) btnSeries_->setText(active ? "Остановить серию" : "Сыграть серию");
+else btnSeries_->setText(active ? "Stop series" : "Play series");
+
+btnNewGame_->setEnabled(!active);
+cbMode_->setEnabled(!active);
+cbClassicSize_->setEnabled(!active);
+cbFill_->setEnabled(!active);
+cbXComputer_->setEnabled(!active);
+cbOComputer_->setEnabled(!active);
+cbNetwork_->setEnabled(!active && engine_.hasUltimateNetwork());
+spSeriesGames_->setEnabled(!active);
+}
+
 void MainWindow::onShowStats() {
 StatsDialog dlg(this);
 dlg.setStats(gamesPlayed_, xWins_, oWins_, draws_, lang_ == UiLang::RU);
+
+QStringList modeNames;
+for (int i = 0; i < cbMode_->count(); ++i) modeNames << cbMode_->itemText(i);
+dlg.setStore(&stats_, modeNames, lang_ == UiLang::RU);
 dlg.exec();
 }
 
@@ -488,9 +896,16 @@ retranslateUi();
 void MainWindow::onModeChanged(int) {
 onNewGame();
 updateShowWeightsControls();
+updateClassicSizeControls();
+updateNetworkControls();
 maybeScheduleComputer();
 }
 
+void MainWindow::onClassicSizeChanged(int) {
+if (engine_.mode() != GameMode::Classic3x3) return;
+onNewGame();
+}
+
 void MainWindow::onFillModeChanged(int) {
 if (engine_.mode() != GameMode::Score10x10) return;
 syncUiToEngine();
@@ -3,12 +3,16 @@
 #include <QMainWindow>
 
 #include "game/game_engine.h"
+#include "game/game_series.h"
+#include "game/log/stats_store.h"
 
 class BoardWidget;
 class QPushButton;
 class QComboBox;
 class QLabel;
 class QCheckBox;
+class QSpinBox;
+class QTimer;
 
 enum class UiLang { RU, EN };
 
@@ -25,12 +29,22 @@ private slots:
 
     void onLanguageChanged(int index);
     void onModeChanged(int index);
+    void onClassicSizeChanged(int index);
     void onFillModeChanged(int index);
     void onPlayerTypeChanged();
 
     void onShowWeightsToggled(bool checked);
+    void onPonderToggled(bool checked);
+    void onAnalysisToggled(bool checked);
+    void onNetworkToggled(bool checked);
 
     void onCellClicked(int r, int c);
+    void onCellHovered(int r, int c);
+
+    void onSeriesClicked();
+    void onSeriesTick();
+    void onThinkTick();
+    void onAnalysisTick();
 
 private:
     void buildUi();
@@ -41,15 +55,51 @@ private:
     void updateInfoLabel();
     void updateRulesButton();
     void updateShowWeightsControls();
+    void updateClassicSizeControls();
+    void updateNetworkControls();
 
     QString stripeInfoText() const;
 
     void maybeScheduleComputer();
     void doComputerStep();
+    void showSearchProgress();
+    void updateAnalysis();
+    void stopAnalysis();
+    void showAnalysis(const std::vector<MoveEval>& evals);
     void applyFinishedResult(const MoveOutcome& out);
+    void setBoardGeometry(int N);
+
+    bool isSeriesActive() const;
+    void startSeries();
+    void finishSeries();
+    void showSeriesProgress();
+    void updateSeriesControls();
+    void recordResult(int winner);
 
 private:
     GameEngine engine_;
+    StatsStore stats_;
+
+    // Polls the engine's background search (~30 Hz) for progress and its move.
+    QTimer* thinkTimer_ = nullptr;
+    quint32 thinkSeq_ = 0;
+
+    // Move analysis of the position on screen while a human is to move,
+    // polled for refined scores; restarted when the position changes.
+    QTimer* analysisTimer_ = nullptr;
+    quint64 analysisVersion_ = 0;
+    quint64 analysedHash_ = 0;
+    bool analysisShown_ = false;
+
+    // A Score move preview is on the hovered cell and in the info label.
+    bool hoverPreview_ = false;
+
+    // Turbo computer-vs-computer series: played on a worker, shown by a
+    // ~30 Hz timer.
+    GameSeries series_;
+    QTimer* seriesTimer_ = nullptr;
+    SeriesProgress seriesProgress_;
+    quint64 seriesVersion_ = 0;
 
     BoardWidget* board_ = nullptr;
 
@@ -62,6 +112,7 @@ private:
 
     QLabel* lblMode_ = nullptr;
     QComboBox* cbMode_ = nullptr;
+    QComboBox* cbClassicSize_ = nullptr;
 
     QLabel* lblFill_ = nullptr;
     QComboBox* cbFill_ = nullptr;
@@ -70,6 +121,13 @@ private:
 
     QCheckBox* cbXComputer_ = nullptr;
     QCheckBox* cbOComputer_ = nullptr;
+    QCheckBox* cbPonder_ = nullptr;
+    QCheckBox* cbAnalysis_ = nullptr;
+    QCheckBox* cbNetwork_ = nullptr;
+
+    QLabel* lblSeries_ = nullptr;
+    QSpinBox* spSeriesGames_ = nullptr;
+    QPushButton* btnSeries_ = nullptr;
 
     QLabel* lblInfo_ = nullptr;
 
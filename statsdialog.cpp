@@ -1,8 +1,24 @@
 #include "statsdialog.h"
+#include "game/log/stats_store.h"
+
+#include <QComboBox>
+#include <QDateTime>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QPushButton>
 
+namespace {
+
+QString totalsLine(const StatsTotals& t, bool ru) {
+    if (ru) {
+        return QString("игр %1, X %2, O %3, ничьих %4").arg(t.games).arg(t.xWins).arg(t.oWins).arg(t.draws);
+    }
+    return QString("%1 games, X %2, O %3, draws %4").arg(t.games).arg(t.xWins).arg(t.oWins).arg(t.draws);
+}
+
+} // namespace
+
 StatsDialog::StatsDialog(QWidget* parent) : QDialog(parent) {
     setModal(true);
     setMinimumWidth(320);
@@ -11,10 +27,29 @@ StatsDialog::StatsDialog(QWidget* parent) : QDialog(parent) {
     label_ = new QLabel(this);
     label_->setWordWrap(true);
 
+    cbMode_ = new QComboBox(this);
+    cbPlayers_ = new QComboBox(this);
+    cbPeriod_ = new QComboBox(this);
+    historyLabel_ = new QLabel(this);
+    historyLabel_->setWordWrap(true);
+
+    auto* filters = new QHBoxLayout();
+    filters->addWidget(cbMode_);
+    filters->addWidget(cbPlayers_);
+    filters->addWidget(cbPeriod_);
+
+    for (QComboBox* cb : { cbMode_, cbPlayers_, cbPeriod_ }) {
+        cb->setVisible(false);
+        connect(cb, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &StatsDialog::refreshHistory);
+    }
+    historyLabel_->setVisible(false);
+
     auto* btnClose = new QPushButton("OK", this);
     connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
 
     layout->addWidget(label_);
+    layout->addLayout(filters);
+    layout->addWidget(historyLabel_);
     layout->addWidget(btnClose);
 }
 
@@ -31,3 +66,83 @@ void StatsDialog::setStats(int games, int xWins, int oWins, int draws, bool ru)
     }
     label_->setText(text);
 }
+
+void StatsDialog::setStore(const StatsStore* store, const QStringList& modeNames, bool ru) {
+    store_ = nullptr;
+    modeNames_ = modeNames;
+    ru_ = ru;
+
+    cbMode_->clear();
+    cbMode_->addItem(ru ? "Все режимы" : "All modes");
+    cbMode_->addItems(modeNames);
+
+    cbPlayers_->clear();
+    if (ru) {
+        cbPlayers_->addItems({ "Все игроки", "Человек — человек", "Человек — компьютер", "Компьютер — компьютер" });
+        cbPeriod_->clear();
+        cbPeriod_->addItems({ "За всё время", "За сутки", "За неделю" });
+    } else {
+        cbPlayers_->addItems({ "All players", "Human vs human", "Human vs computer", "Computer vs computer" });
+        cbPeriod_->clear();
+        cbPeriod_->addItems({ "All time", "Last 24 hours", "Last 7 days" });
+    }
+
+    store_ = (store && store->isOpen()) ? store : nullptr;
+    for (QWidget* w : { static_cast<QWidget*>(cbMode_), static_cast<QWidget*>(cbPlayers_),
+                        static_cast<QWidget*>(cbPeriod_), static_cast<QWidget*>(historyLabel_) }) {
+        w->setVisible(store_ != nullptr);
+    }
+    refreshHistory();
+}
+
+// Mixed games count both ways round; the period goes through the log, the
+// rest is summed from the store's running totals.
+StatsTotals StatsDialog::query(StatsFilter filter) const {
+    const int players = cbPlayers_->currentIndex();
+    if (players == 1) filter.xType = filter.oType = static_cast<int>(PlayerType::Human);
+    if (players == 3) filter.xType = filter.oType = static_cast<int>(PlayerType::Computer);
+
+    auto run = [this](const StatsFilter& f) {
+        const int period = cbPeriod_->currentIndex();
+        if (period <= 0) return store_->totals(f);
+        const qint64 day = 24LL * 60 * 60 * 1000;
+        return store_->totalsSince(QDateTime::currentMSecsSinceEpoch() - (period == 1 ? day : 7 * day), f);
+    };
+
+    if (players != 2) return run(filter);
+
+    StatsFilter humanX = filter, humanO = filter;
+    humanX.xType = humanO.oType = static_cast<int>(PlayerType::Human);
+    humanX.oType = humanO.xType = static_cast<int>(PlayerType::Computer);
+    StatsTotals sum = run(humanX);
+    sum += run(humanO);
+    return sum;
+}
+
+void StatsDialog::refreshHistory() {
+    if (!store_) return;
+
+    StatsFilter filter;
+    filter.mode = cbMode_->currentIndex() - 1;
+
+    // Classic is the one mode played on more than one board size.
+    auto bySize = [this](StatsFilter f) {
+        QString lines;
+        if (f.mode != static_cast<int>(GameMode::Classic3x3)) return lines;
+        for (int n = 3; n <= 4; ++n) {
+            f.boardSize = n;
+            lines += QString("\n  %1x%1: %2").arg(n).arg(totalsLine(query(f), ru_));
+        }
+        return lines;
+    };
+
+    QString text = (ru_ ? "Всего: " : "Total: ") + totalsLine(query(filter), ru_) + bySize(filter);
+    if (filter.mode < 0) {
+        text += ru_ ? "\n\nПо режимам:" : "\n\nBy mode:";
+        for (int m = 0; m < modeNames_.size(); ++m) {
+            filter.mode = m;
+            text += QString("\n%1: %2").arg(modeNames_[m], totalsLine(query(filter), ru_)) + bySize(filter);
+        }
+    }
+    historyLabel_->setText(text);
+}
@@ -1,8 +1,13 @@
 #pragma once
 
 #include <QDialog>
+#include <QStringList>
 
+class QComboBox;
 class QLabel;
+class StatsStore;
+struct StatsFilter;
+struct StatsTotals;
 
 class StatsDialog : public QDialog {
     Q_OBJECT
@@ -11,6 +16,24 @@ public:
 
     void setStats(int games, int xWins, int oWins, int draws, bool ru);
 
+    // All-time results from the store, filtered by mode, players and period.
+    // modeNames[i] names GameMode i.
+    void setStore(const StatsStore* store, const QStringList& modeNames, bool ru);
+
+private slots:
+    void refreshHistory();
+
 private:
+    StatsTotals query(StatsFilter filter) const;
+
     QLabel* label_ = nullptr;
+
+    QComboBox* cbMode_ = nullptr;
+    QComboBox* cbPlayers_ = nullptr;
+    QComboBox* cbPeriod_ = nullptr;
+    QLabel* historyLabel_ = nullptr;
+
+    const StatsStore* store_ = nullptr;
+    QStringList modeNames_;
+    bool ru_ = true;
 };
@@ -0,0 +1,170 @@
+#include "game/log/stats_store.h"
+#include "game/modes/score_mode.h"
+#include "game/server/game_server.h"
+
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+QTextStream& err() {
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (condition) return;
+    ++failures;
+    err() << "FAILED: " << what << "\n";
+    err().flush();
+}
+
+// First move the position allows, as row * N + col.
+int firstAllowed(const IGameMode& game) {
+    const int N = game.boardSize();
+    for (int i = 0; i < N * N; ++i) {
+        if (game.isMoveAllowed(i / N, i % N)) return i;
+    }
+    return -1;
+}
+
+// Fills the active row and returns the row drawn after it.
+int nextRow(IGameMode& game) {
+    const int N = game.boardSize();
+    const int row = game.activeRow();
+    while (game.isActive() && game.activeRow() == row) {
+        const int move = firstAllowed(game);
+        if (move < 0) return -1;
+        game.applyMove(move / N, move % N);
+    }
+    return game.activeRow();
+}
+
+void testSearchCopyDrawsOwnStripes() {
+    GameConfig cfg = ScoreMode::defaultConfig();
+    cfg.seed = 12345;
+    ScoreMode live(cfg);
+    live.setFillMode(FillMode::RandomRow);
+    live.startNewGame();
+
+    std::unique_ptr<IGameMode> plain = live.clone();
+    std::vector<std::unique_ptr<IGameMode>> searched;
+    for (int i = 0; i < 32; ++i) {
+        searched.push_back(live.clone());
+        searched.back()->reseedForSearch();
+    }
+
+    const int row = nextRow(live);
+    check(row >= 0, "random row mode draws the next row");
+
+    // A plain copy replays the game; a search copy must not know its future.
+    check(nextRow(*plain) == row, "a plain copy draws the live game's stripe");
+    bool differs = false;
+    for (const auto& copy : searched) differs = differs || nextRow(*copy) != row;
+    check(differs, "a search copy draws stripes of its own");
+}
+
+StatsResult classicResult(int boardSize, int winner) {
+    StatsResult r;
+    r.timestamp = 1000;
+    r.mode = GameMode::Classic3x3;
+    r.boardSize = boardSize;
+    r.winner = winner;
+    return r;
+}
+
+void checkClassicSizes(const StatsStore& store) {
+    StatsFilter f;
+    f.mode = static_cast<int>(GameMode::Classic3x3);
+    const StatsTotals all = store.totals(f);
+    f.boardSize = 3;
+    const StatsTotals small = store.totals(f);
+    const StatsTotals smallSince = store.totalsSince(0, f);
+    f.boardSize = 4;
+    const StatsTotals large = store.totals(f);
+
+    check(all.games == 2, "both Classic games are counted");
+    check(small.games == 1 && small.xWins == 1, "the 3x3 game is reported on its own");
+    check(smallSince.games == 1 && smallSince.xWins == 1, "the 3x3 game is reported on its own by period");
+    check(large.games == 1 && large.oWins == 1, "the 4x4 game is reported on its own");
+}
+
+void testStatsKeepBoardSizesApart() {
+    QTemporaryDir dir;
+    check(dir.isValid(), "temporary directory");
+    if (!dir.isValid()) return;
+    const QString path = dir.filePath("stats.tstat");
+
+    {
+        StatsStore store;
+        QString error;
+        check(store.open(path, &error), "stats store opens");
+        store.record(classicResult(3, 1));
+        store.record(classicResult(4, -1));
+        checkClassicSizes(store);
+        check(store.flush(), "stats store writes");
+    }
+
+    StatsStore store;
+    check(store.open(path), "stats store reopens");
+    checkClassicSizes(store);
+}
+
+void testServerQuitStopsComputerGames() {
+    using namespace std::chrono;
+
+    ServerOptions options;
+    options.threads = 2;
+    options.moveBudgetMs = 10;
+
+    std::atomic<int> moves{0};
+    const GameServer::Sink sink = [&moves](const QString& line) {
+        if (line.startsWith("move ")) moves.fetch_add(1);
+    };
+
+    int before = 0;
+    {
+        GameServer server(options);
+        check(server.start(), "server starts");
+        for (int i = 0; i < 8; ++i) server.handle(0, "new ultimate x=computer o=computer", sink);
+
+        const auto giveUp = steady_clock::now() + seconds(10);
+        while (moves.load() < 16 && steady_clock::now() < giveUp) std::this_thread::sleep_for(milliseconds(5));
+        check(moves.load() >= 16, "computer against computer games move");
+
+        before = moves.load();
+        check(!server.handle(0, "quit", sink), "quit ends the command loop");
+    }
+
+    // Only the searches running at quit may still report a move.
+    check(moves.load() - before <= 2 * options.threads, "no computer move starts after quit");
+}
+
+} // namespace
+
+// Checks for game_core that need no window; run by ctest.
+int main() {
+    const std::vector<std::pair<const char*, std::function<void()>>> tests = {
+        { "searchCopyDrawsOwnStripes", testSearchCopyDrawsOwnStripes },
+        { "statsKeepBoardSizesApart", testStatsKeepBoardSizesApart },
+        { "serverQuitStopsComputerGames", testServerQuitStopsComputerGames },
+    };
+
+    for (const auto& test : tests) {
+        const int before = failures;
+        test.second();
+        err() << (failures == before ? "ok   " : "FAIL ") << test.first << "\n";
+    }
+    err().flush();
+    return failures == 0 ? 0 : 1;
+}
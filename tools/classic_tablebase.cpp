@@ -0,0 +1,40 @@
+#include "game/ai/classic_tablebase.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+// Builds the Classic tablebase read by GameEngine. Put the output next to the
+// game executable as classic4.tb.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("classic_tablebase");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a win/draw/loss tablebase for Classic tic-tac-toe.");
+    parser.addHelpOption();
+
+    QCommandLineOption sizeOption(QStringList() << "n" << "size", "Board size (2-4).", "size", "4");
+    QCommandLineOption outOption(QStringList() << "o" << "output", "Output file.", "file", "classic4.tb");
+    parser.addOption(sizeOption);
+    parser.addOption(outOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    bool ok = false;
+    const int size = parser.value(sizeOption).toInt(&ok);
+    if (!ok) {
+        err << "Invalid board size\n";
+        return 1;
+    }
+
+    QString error;
+    if (!ClassicTablebase::generate(size, parser.value(outOption), &error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    err << "Wrote " << ClassicTablebase::entryCount(size) << " entries to " << parser.value(outOption) << "\n";
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "game/log/game_log.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+// Summarises a game log written by GameEngine, or prints one position of one
+// game: game_log games.tlog --game 12 --ply 30.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("game_log");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Lists and replays recorded games.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("log", "Game log file.");
+
+    QCommandLineOption gameOption(QStringList() << "g" << "game", "Game number (from 0).", "n");
+    QCommandLineOption plyOption(QStringList() << "p" << "ply", "Moves to replay (default: all).", "ply");
+    parser.addOption(gameOption);
+    parser.addOption(plyOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    GameLogReader reader;
+    QString error;
+    if (!reader.open(args.first(), &error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    if (!parser.isSet(gameOption)) {
+        qint64 moves = 0, xWins = 0, oWins = 0, draws = 0, unfinished = 0;
+        for (qint64 g = 0; g < reader.gameCount(); ++g) {
+            GameRecord rec;
+            if (!reader.record(g, rec)) continue;
+            moves += rec.moveCount;
+            if (!rec.finished) unfinished++;
+            else if (rec.result == 1) xWins++;
+            else if (rec.result == -1) oWins++;
+            else draws++;
+        }
+        out << "Games: " << reader.gameCount() << ", moves: " << moves << "\n"
+            << "X wins: " << xWins << ", O wins: " << oWins << ", draws: " << draws
+            << ", unfinished: " << unfinished << "\n";
+        return 0;
+    }
+
+    const qint64 game = parser.value(gameOption).toLongLong();
+    GameRecord rec;
+    if (!reader.record(game, rec)) {
+        err << "No game " << game << "\n";
+        return 1;
+    }
+
+    const int ply = parser.isSet(plyOption) ? parser.value(plyOption).toInt() : rec.moveCount;
+    std::unique_ptr<IGameMode> pos = reader.position(game, ply);
+    if (!pos) {
+        err << "Game " << game << " has " << rec.moveCount << " moves\n";
+        return 1;
+    }
+
+    out << "Game " << game << ", mode " << static_cast<int>(rec.mode) << ", fill " << static_cast<int>(rec.fill)
+        << ", seed " << rec.seed << ", ply " << ply << "/" << rec.moveCount << "\n";
+
+    const int N = pos->boardSize();
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            const int owner = pos->cellOwner(r, c);
+            out << (owner == 1 ? 'X' : (owner == -1 ? 'O' : '.'));
+        }
+        out << "\n";
+    }
+
+    if (rec.mode == GameMode::Score10x10) {
+        const ScoreSnapshot s = pos->currentScore();
+        out << "Total: X=" << s.xTotal << ", O=" << s.oTotal << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "game/server/game_server.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QTextStream>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// One client on stdin/stdout; returns when stdin ends or on quit. At the end
+// of input the computer moves still being searched are waited for.
+int serveStdin(GameServer& server) {
+    QTextStream in(stdin);
+    QTextStream out(stdout);
+    std::mutex outMutex;
+    const GameServer::Sink sink = [&out, &outMutex](const QString& line) {
+        std::lock_guard<std::mutex> lock(outMutex);
+        out << line << "\n";
+        out.flush();
+    };
+
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (!server.handle(0, line, sink)) return 0;
+    }
+    while (server.thinkingCount() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return 0;
+}
+
+} // namespace
+
+// Hosts many games at once for bots and test rigs, reading commands from
+// stdin or, with --socket, from any number of local socket clients:
+// game_server --socket tictactoe --book ultimate.book --budget 100
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("game_server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless multi-session game server; see game/server/game_server.h "
+                                     "for the protocol.");
+    parser.addHelpOption();
+
+    QCommandLineOption socketOption("socket", "Listen on this local socket instead of stdin.", "name");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Search threads (0 = all cores).", "n", "0");
+    QCommandLineOption budgetOption("budget", "Default time for a computer reply, in ms.", "ms", "200");
+    QCommandLineOption maxOption("max-sessions", "Games open at once.", "n", "100000");
+    QCommandLineOption tablebaseOption("tablebase", "Classic tablebase file.", "file");
+    QCommandLineOption bookOption("book", "Ultimate opening book.", "file");
+    QCommandLineOption networkOption("network", "Ultimate evaluation network.", "file");
+    QCommandLineOption paramsOption("params", "Ultimate heuristic weights.", "file");
+    for (const QCommandLineOption& o : { socketOption, threadsOption, budgetOption, maxOption, tablebaseOption,
+                                         bookOption, networkOption, paramsOption }) {
+        parser.addOption(o);
+    }
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    ServerOptions options;
+    options.threads = parser.value(threadsOption).toInt();
+    options.moveBudgetMs = parser.value(budgetOption).toInt();
+    options.maxSessions = parser.value(maxOption).toInt();
+    options.engine.classicTablebasePath = parser.value(tablebaseOption);
+    options.engine.ultimateBookPath = parser.value(bookOption);
+    options.engine.ultimateNetworkPath = parser.value(networkOption);
+
+    QString error;
+    if (parser.isSet(paramsOption) && !options.engine.ultimateParams.load(parser.value(paramsOption), &error)) {
+        err << parser.value(paramsOption) << ": " << error << "\n";
+        return 1;
+    }
+
+    GameServer server(options);
+    if (!server.start(&error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    if (!parser.isSet(socketOption)) return serveStdin(server);
+
+    QLocalServer listener;
+    QLocalServer::removeServer(parser.value(socketOption));
+    if (!listener.listen(parser.value(socketOption))) {
+        err << "Failed: " << listener.errorString() << "\n";
+        return 1;
+    }
+    err << "Listening on " << listener.fullServerName() << "\n";
+    err.flush();
+
+    int nextClient = 1;
+    QObject::connect(&listener, &QLocalServer::newConnection, [&]() {
+        while (QLocalSocket* socket = listener.nextPendingConnection()) {
+            const int client = nextClient++;
+
+            // Replies from pool threads are handed to the main thread, which
+            // owns the socket; they are dropped once the socket is gone.
+            const QPointer<QLocalSocket> guard(socket);
+            const GameServer::Sink sink = [guard](const QString& line) {
+                QMetaObject::invokeMethod(qApp, [guard, line]() {
+                    if (guard) guard->write((line + "\n").toUtf8());
+                }, Qt::QueuedConnection);
+            };
+
+            QObject::connect(socket, &QLocalSocket::readyRead, socket, [&server, &app, socket, client, sink]() {
+                while (socket->canReadLine()) {
+                    const QString line = QString::fromUtf8(socket->readLine());
+                    if (!server.handle(client, line, sink)) {
+                        app.quit();
+                        return;
+                    }
+                }
+            });
+            QObject::connect(socket, &QLocalSocket::disconnected, socket, [&server, socket, client]() {
+                server.dropClient(client);
+                socket->deleteLater();
+            });
+        }
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,186 @@
+#include "game/ai/search_core.h"
+#include "game/ai/ultimate_network.h"
+#include "game/ai/ultimate_playout.h"
+#include "game/train/network_trainer.h"
+#include "game/train/self_play.h"
+#include "game/train/training_shard.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+namespace {
+
+int sign(qint64 v) { return (v > 0) - (v < 0); }
+
+// For decided games: how often the sign of ultimateHeuristic, of the stored
+// search value, of the network when one is given and, with playouts > 0, of
+// random-playout wins minus losses agree with the result for the side to
+// move.
+int check(const QStringList& shards, int playouts, const UltimateNetwork* network, QTextStream& out,
+          QTextStream& err) {
+    qint64 positions = 0, decided = 0, heuristicHits = 0, searchHits = 0, networkHits = 0, playoutHits = 0;
+    UltimateAccumulator acc;
+
+    std::vector<UltimateBoard> boards;
+    std::vector<int> results;
+    auto runPlayouts = [&]() {
+        const std::vector<PlayoutTally> tallies = runUltimatePlayouts(boards, playouts, 1, 0);
+        for (size_t i = 0; i < tallies.size(); ++i) {
+            if (sign(tallies[i].wins - tallies[i].losses) == results[i]) playoutHits++;
+        }
+        boards.clear();
+        results.clear();
+    };
+
+    for (const QString& path : shards) {
+        TrainingShardReader reader;
+        QString error;
+        if (!reader.open(path, &error)) {
+            err << path << ": " << error << "\n";
+            return 1;
+        }
+
+        for (const TrainingRecord& rec : reader) {
+            positions++;
+            if (rec.mode != static_cast<quint8>(GameMode::Ultimate) || rec.result == 0) continue;
+
+            decided++;
+            const UltimateBoard board = rec.toUltimateBoard();
+            const int heuristic = ultimateHeuristic(board, rec.sideToMove);
+            if (sign(heuristic) == rec.resultForMover()) heuristicHits++;
+            if (sign(rec.score) == rec.resultForMover()) searchHits++;
+            if (network) {
+                network->refresh(acc, board);
+                if (sign(network->evaluate(acc)) * rec.sideToMove == rec.resultForMover()) networkHits++;
+            }
+
+            if (playouts > 0) {
+                boards.push_back(board);
+                results.push_back(rec.resultForMover());
+                if (boards.size() == 4096) runPlayouts();
+            }
+        }
+    }
+    if (!boards.empty()) runPlayouts();
+
+    out << "Positions: " << positions << ", decided Ultimate: " << decided << "\n";
+    if (decided > 0) {
+        out << "ultimateHeuristic sign agrees with result: " << (100.0 * heuristicHits / decided) << "%\n"
+            << "depth-2 search sign agrees with result: " << (100.0 * searchHits / decided) << "%\n";
+        if (network) out << "network sign agrees with result: " << (100.0 * networkHits / decided) << "%\n";
+        if (playouts > 0) {
+            out << playouts << " random playouts agree with result: " << (100.0 * playoutHits / decided) << "%\n";
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+// Generates training shards from self-play, or checks existing ones against
+// ultimateHeuristic: selfplay --mode ultimate --games 10000 -o data/ultimate
+// writes data/ultimate-00000.shard, ...; selfplay --check data/*.shard
+// (--playouts 200 also scores each position by random playouts, --network
+// ultimate.nnue by the network). selfplay --train-network ultimate.nnue
+// data/*.shard fits the Ultimate evaluation network to the shards.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("selfplay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Self-play training positions for Ultimate and Score.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("shards", "Shards to check (with --check).");
+
+    QCommandLineOption modeOption(QStringList() << "m" << "mode", "ultimate or score.", "mode", "ultimate");
+    QCommandLineOption fillOption(QStringList() << "f" << "fill", "Score fill mode (0-6).", "fill", "0");
+    QCommandLineOption gamesOption(QStringList() << "g" << "games", "Number of games.", "n", "1000");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Worker threads (0 = all cores).", "n", "0");
+    QCommandLineOption randomOption("random-plies", "Opening moves played at random.", "n", "4");
+    QCommandLineOption seedOption("seed", "Seed of the first game.", "n", "1");
+    QCommandLineOption outOption(QStringList() << "o" << "output", "Shard file prefix.", "prefix", "selfplay");
+    QCommandLineOption shardOption("shard-size", "Records per shard.", "n", "1048576");
+    QCommandLineOption checkOption("check", "Check shards instead of generating.");
+    QCommandLineOption playoutsOption("playouts", "With --check: random playouts per Ultimate position.", "n", "0");
+    QCommandLineOption networkOption("network", "With --check: Ultimate network to score positions with.", "file");
+    QCommandLineOption trainOption("train-network", "Train the Ultimate network on the shards and save it.", "file");
+    QCommandLineOption epochsOption("epochs", "With --train-network: passes over the positions.", "n", "10");
+    QCommandLineOption rateOption("learning-rate", "With --train-network: initial SGD step.", "rate", "0.01");
+    for (const QCommandLineOption& o : { modeOption, fillOption, gamesOption, threadsOption, randomOption,
+                                         seedOption, outOption, shardOption, checkOption, playoutsOption,
+                                         networkOption, trainOption, epochsOption, rateOption }) {
+        parser.addOption(o);
+    }
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.isSet(checkOption)) {
+        UltimateNetwork network;
+        QString error;
+        const bool useNetwork = parser.isSet(networkOption);
+        if (useNetwork && !network.load(parser.value(networkOption), &error)) {
+            err << parser.value(networkOption) << ": " << error << "\n";
+            return 1;
+        }
+        return check(parser.positionalArguments(), parser.value(playoutsOption).toInt(),
+                     useNetwork ? &network : nullptr, out, err);
+    }
+
+    if (parser.isSet(trainOption)) {
+        NetworkTrainerOptions trainer;
+        trainer.epochs = parser.value(epochsOption).toInt();
+        trainer.learningRate = parser.value(rateOption).toFloat();
+        trainer.seed = parser.value(seedOption).toUInt();
+
+        UltimateNetwork::Weights weights;
+        QString error;
+        const bool trained = trainUltimateNetwork(parser.positionalArguments(), trainer, weights, &error,
+                                                  [&err](int epoch, double loss) {
+                                                      err << "Epoch " << epoch << ": loss " << loss << "\n";
+                                                      err.flush();
+                                                  });
+        UltimateNetwork network;
+        if (trained) network.setWeights(weights);
+        if (!trained || !network.save(parser.value(trainOption), &error)) {
+            err << "Failed: " << error << "\n";
+            return 1;
+        }
+        err << "Saved " << parser.value(trainOption) << "\n";
+        return 0;
+    }
+
+    SelfPlayOptions options;
+    const QString mode = parser.value(modeOption);
+    if (mode == "ultimate") {
+        options.mode = GameMode::Ultimate;
+    } else if (mode == "score") {
+        options.mode = GameMode::Score10x10;
+    } else {
+        err << "Unknown mode " << mode << "\n";
+        return 1;
+    }
+    options.fill = static_cast<FillMode>(parser.value(fillOption).toInt());
+    options.games = parser.value(gamesOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.randomPlies = parser.value(randomOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+
+    TrainingShardWriter writer;
+    QString error;
+    if (!writer.start(parser.value(outOption), parser.value(shardOption).toLongLong(), &error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    const qint64 positions = runSelfPlay(options, writer);
+    if (!writer.finish(&error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    err << "Wrote " << positions << " positions to " << writer.shardCount() << " shard(s)\n";
+    return 0;
+}
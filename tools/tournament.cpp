@@ -0,0 +1,165 @@
+#include "game/tournament.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <cmath>
+
+namespace {
+
+// "key=value,key=value" onto `config`; see the --a help text for the keys.
+bool parseEngine(const QString& spec, EngineConfig& config, QString& error) {
+    for (const QString& item : spec.split(',')) {
+        if (item.trimmed().isEmpty()) continue;
+        const int eq = item.indexOf('=');
+        const QString key = item.left(eq < 0 ? 0 : eq).trimmed();
+        const QString value = item.mid(eq < 0 ? 0 : eq + 1).trimmed();
+        bool ok = eq > 0;
+
+        if (key == "depth") {
+            config.classicSearchDepth = value.toInt(&ok);
+        } else if (key == "tablebase") {
+            config.classicTablebasePath = value;
+        } else if (key == "kinarow-nodes") {
+            config.kInARowProverLimits.maxNodes = value.toInt(&ok);
+        } else if (key == "kinarow-ms") {
+            config.kInARowProverLimits.maxMillis = value.toInt(&ok);
+        } else if (key == "ultimate-solver") {
+            config.ultimateSolverThreshold = value.toInt(&ok);
+        } else if (key == "ultimate-solver-nodes") {
+            config.ultimateSolverLimits.maxNodes = value.toLongLong(&ok);
+        } else if (key == "ultimate-solver-ms") {
+            config.ultimateSolverLimits.maxMillis = value.toInt(&ok);
+        } else if (key == "book") {
+            config.ultimateBookPath = value;
+        } else if (key == "network") {
+            config.ultimateNetworkPath = value;
+        } else if (key == "params") {
+            if (!config.ultimateParams.load(value, &error)) {
+                error = value + ": " + error;
+                return false;
+            }
+        } else if (key == "score-solver") {
+            config.scoreSolverThreshold = value.toInt(&ok);
+        } else if (key == "score-solver-ms") {
+            config.scoreSolverLimits.maxMillis = value.toInt(&ok);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = "bad engine setting \"" + item + "\"";
+            return false;
+        }
+    }
+    return true;
+}
+
+QString formatElo(const TournamentResult& r) {
+    if (!std::isfinite(r.elo)) return r.elo > 0 ? QStringLiteral("+inf") : QStringLiteral("-inf");
+    if (!std::isfinite(r.eloMargin)) return QString::asprintf("%+.1f +- inf", r.elo);
+    return QString::asprintf("%+.1f +- %.1f", r.elo, r.eloMargin);
+}
+
+} // namespace
+
+// Plays two engine configurations against each other in paired games from
+// shared random openings until the SPRT decides or the pairs run out:
+// tournament --mode ultimate --b params=build/ultimate.params --pairs 2000
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tournament");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Engine A against engine B, with Elo error bars and an SPRT.");
+    parser.addHelpOption();
+
+    QCommandLineOption aOption("a", "Engine A settings as key=value,... Keys: depth, tablebase, kinarow-nodes, "
+                                    "kinarow-ms, ultimate-solver, ultimate-solver-nodes, ultimate-solver-ms, "
+                                    "book, network, params, score-solver, score-solver-ms.", "spec");
+    QCommandLineOption bOption("b", "Engine B settings, same keys as --a.", "spec");
+    QCommandLineOption modeOption(QStringList() << "m" << "mode", "classic, kinarow, score, ultimate or recursive.",
+                                  "mode", "ultimate");
+    QCommandLineOption sizeOption("size", "Classic board size.", "n", "3");
+    QCommandLineOption fillOption(QStringList() << "f" << "fill", "Score fill mode (0-6).", "fill", "0");
+    QCommandLineOption pairsOption(QStringList() << "p" << "pairs", "Maximum number of game pairs.", "n", "1000");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Worker threads (0 = all cores).", "n", "0");
+    QCommandLineOption openingOption("opening-plies", "Random moves before the engines take over.", "n", "4");
+    QCommandLineOption seedOption("seed", "Seed of the first opening.", "n", "1");
+    QCommandLineOption noSprtOption("no-sprt", "Play all pairs instead of stopping on an SPRT decision.");
+    QCommandLineOption elo0Option("elo0", "SPRT H0: A is this many Elo stronger.", "elo", "0");
+    QCommandLineOption elo1Option("elo1", "SPRT H1: A is this many Elo stronger.", "elo", "5");
+    QCommandLineOption alphaOption("alpha", "SPRT false positive rate.", "p", "0.05");
+    QCommandLineOption betaOption("beta", "SPRT false negative rate.", "p", "0.05");
+    for (const QCommandLineOption& o : { aOption, bOption, modeOption, sizeOption, fillOption, pairsOption,
+                                         threadsOption, openingOption, seedOption, noSprtOption, elo0Option,
+                                         elo1Option, alphaOption, betaOption }) {
+        parser.addOption(o);
+    }
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    TournamentOptions options;
+    const QString mode = parser.value(modeOption);
+    if (mode == "classic") {
+        options.mode = GameMode::Classic3x3;
+    } else if (mode == "kinarow") {
+        options.mode = GameMode::KInARow;
+    } else if (mode == "score") {
+        options.mode = GameMode::Score10x10;
+    } else if (mode == "ultimate") {
+        options.mode = GameMode::Ultimate;
+    } else if (mode == "recursive") {
+        options.mode = GameMode::UltimateRecursive;
+    } else {
+        err << "Unknown mode " << mode << "\n";
+        return 1;
+    }
+    options.classicBoardSize = parser.value(sizeOption).toInt();
+    options.fill = static_cast<FillMode>(parser.value(fillOption).toInt());
+    options.pairs = parser.value(pairsOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.openingPlies = parser.value(openingOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    options.sprt = !parser.isSet(noSprtOption);
+    options.elo0 = parser.value(elo0Option).toDouble();
+    options.elo1 = parser.value(elo1Option).toDouble();
+    options.alpha = parser.value(alphaOption).toDouble();
+    options.beta = parser.value(betaOption).toDouble();
+
+    EngineConfig a, b;
+    QString error;
+    if (!parseEngine(parser.value(aOption), a, error) || !parseEngine(parser.value(bOption), b, error)) {
+        err << error << "\n";
+        return 1;
+    }
+
+    TournamentResult result;
+    const bool ran = runTournament(options, a, b, result, &error, nullptr, [&err](const TournamentResult& r) {
+        err << "Pair " << r.pairs << ": +" << r.wins << " =" << r.draws << " -" << r.losses << ", Elo "
+            << formatElo(r) << ", LLR " << QString::asprintf("%.2f", r.llr) << "\n";
+        err.flush();
+    });
+    if (!ran) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    out << "Games: " << 2 * result.pairs << " (+" << result.wins << " =" << result.draws << " -" << result.losses
+        << "), score " << QString::asprintf("%.3f", result.score) << "\n";
+    out << "Pairs by A's points (0, 0.5, 1, 1.5, 2):";
+    for (int k = 0; k < 5; ++k) out << " " << result.pentanomial[k];
+    out << "\n";
+    out << "Elo A - B: " << formatElo(result) << " (95%)\n";
+    if (options.sprt) {
+        out << "SPRT [" << options.elo0 << ", " << options.elo1 << "]: LLR "
+            << QString::asprintf("%.2f (%.2f, %.2f)", result.llr, result.lowerBound, result.upperBound) << ", ";
+        if (result.decision == TournamentResult::Decision::AcceptH1) out << "H1 accepted\n";
+        else if (result.decision == TournamentResult::Decision::AcceptH0) out << "H0 accepted\n";
+        else out << "no decision\n";
+    }
+    return 0;
+}
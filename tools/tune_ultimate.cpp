@@ -0,0 +1,266 @@
+#include "game/ai/search_core.h"
+#include "game/ai/ultimate_params.h"
+#include "game/train/training_shard.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kTerms = UltimateHeuristicParams::kTerms;
+
+// A position reduced to its heuristic terms for the side to move, and the
+// game result for that side as 1, 0.5 or 0.
+struct Sample {
+    std::array<qint8, kTerms> terms;
+    float target;
+};
+
+// Mean squared error between the results and sigmoid(eval / scale) over all
+// samples, split across threads that live as long as the pool. A call hands
+// the weights to every worker and sums their slices, so the fitting loop
+// neither allocates nor starts threads.
+class ErrorPool {
+public:
+    ErrorPool(const std::vector<Sample>& samples, int threads) : samples_(samples) {
+        if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        partial_.resize(threads);
+        for (int t = 1; t < threads; ++t) workers_.emplace_back([this, t]() { loop(t); });
+    }
+
+    ~ErrorPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& t : workers_) t.join();
+    }
+
+    double error(const int* weights, double scale) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::copy(weights, weights + kTerms, weights_);
+            scale_ = scale;
+            pending_ = static_cast<int>(workers_.size());
+            generation_++;
+        }
+        wake_.notify_all();
+
+        slice(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return pending_ == 0; });
+
+        double sum = 0.0;
+        for (const Partial& p : partial_) sum += p.sum;
+        return sum / static_cast<double>(samples_.size());
+    }
+
+private:
+    struct alignas(64) Partial {
+        double sum = 0.0;
+    };
+
+    void loop(int index) {
+        quint64 seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+                if (quit_) return;
+                seen = generation_;
+            }
+
+            slice(index);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+
+    void slice(int index) {
+        const size_t n = samples_.size();
+        const size_t parts = partial_.size();
+        const size_t begin = n * index / parts;
+        const size_t end = n * (index + 1) / parts;
+        const double inv = 1.0 / scale_;
+
+        double sum = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            const Sample& s = samples_[i];
+            int eval = 0;
+            for (int t = 0; t < kTerms; ++t) eval += weights_[t] * s.terms[t];
+            const double p = 1.0 / (1.0 + std::exp(-eval * inv));
+            sum += (s.target - p) * (s.target - p);
+        }
+        partial_[index].sum = sum;
+    }
+
+private:
+    const std::vector<Sample>& samples_;
+    std::vector<Partial> partial_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    quint64 generation_ = 0;
+    int pending_ = 0;
+    bool quit_ = false;
+
+    int weights_[kTerms] = {};
+    double scale_ = 1.0;
+};
+
+bool loadSamples(const QStringList& shards, std::vector<Sample>& out, QTextStream& err) {
+    int terms[kTerms];
+    for (const QString& path : shards) {
+        TrainingShardReader reader;
+        QString error;
+        if (!reader.open(path, &error)) {
+            err << path << ": " << error << "\n";
+            return false;
+        }
+
+        for (const TrainingRecord& rec : reader) {
+            if (rec.mode != static_cast<quint8>(GameMode::Ultimate)) continue;
+            if (ultimateHeuristicTerms(rec.toUltimateBoard(), rec.sideToMove, terms) != 0) continue;
+
+            Sample s;
+            for (int t = 0; t < kTerms; ++t) s.terms[t] = static_cast<qint8>(terms[t]);
+            s.target = 0.5f + 0.5f * rec.resultForMover();
+            out.push_back(s);
+        }
+    }
+    return true;
+}
+
+// Sigmoid scale that best fits the starting weights, by golden-section
+// search; the weights are then tuned with it fixed.
+double fitScale(ErrorPool& pool, const int* weights) {
+    double lo = 10.0, hi = 5000.0;
+    const double g = (std::sqrt(5.0) - 1.0) / 2.0;
+    double a = hi - g * (hi - lo), b = lo + g * (hi - lo);
+    double fa = pool.error(weights, a), fb = pool.error(weights, b);
+    for (int i = 0; i < 40; ++i) {
+        if (fa < fb) {
+            hi = b;
+            b = a;
+            fb = fa;
+            a = hi - g * (hi - lo);
+            fa = pool.error(weights, a);
+        } else {
+            lo = a;
+            a = b;
+            fa = fb;
+            b = lo + g * (hi - lo);
+            fb = pool.error(weights, b);
+        }
+    }
+    return (lo + hi) / 2.0;
+}
+
+} // namespace
+
+// Fits the ultimateHeuristic weights to self-play results, Texel style:
+// every position is reduced once to its term counts, the heuristic becomes a
+// dot product, and a local search moves one weight at a time while the mean
+// squared error between results and sigmoid(eval / scale) drops. The error
+// over all positions is spread across threads.
+//
+// tune_ultimate -o build/ultimate.params data/ultimate-*.shard
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tune_ultimate");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Texel tuning of the Ultimate heuristic weights on self-play shards.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("shards", "Self-play shards with Ultimate positions.");
+
+    QCommandLineOption outOption(QStringList() << "o" << "output", "Parameter file to write.", "file",
+                                 "ultimate.params");
+    QCommandLineOption startOption("start", "Parameter file to start from (default: built-in weights).", "file");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Worker threads (0 = all cores).", "n", "0");
+    QCommandLineOption stepOption("step", "Initial step; halved down to 1 whenever a pass finds nothing.", "n", "16");
+    QCommandLineOption passesOption("passes", "Maximum passes over the weights.", "n", "200");
+    for (const QCommandLineOption& o : { outOption, startOption, threadsOption, stepOption, passesOption }) {
+        parser.addOption(o);
+    }
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    UltimateHeuristicParams params;
+    if (parser.isSet(startOption)) {
+        QString error;
+        if (!params.load(parser.value(startOption), &error)) {
+            err << parser.value(startOption) << ": " << error << "\n";
+            return 1;
+        }
+    }
+    const UltimateHeuristicParams initial = params;
+
+    std::vector<Sample> samples;
+    if (!loadSamples(parser.positionalArguments(), samples, err)) return 1;
+    if (samples.empty()) {
+        err << "No undecided Ultimate positions in the shards\n";
+        return 1;
+    }
+
+    ErrorPool pool(samples, parser.value(threadsOption).toInt());
+    const double scale = fitScale(pool, params.weight);
+    double best = pool.error(params.weight, scale);
+    const double before = best;
+    out << samples.size() << " positions, scale " << scale << ", error " << before << "\n";
+    out.flush();
+
+    int step = std::max(1, parser.value(stepOption).toInt());
+    const int passes = parser.value(passesOption).toInt();
+    for (int pass = 0; pass < passes; ++pass) {
+        bool improved = false;
+        for (int t = 0; t < kTerms; ++t) {
+            for (int dir : { step, -step }) {
+                params.weight[t] += dir;
+                const double e = pool.error(params.weight, scale);
+                if (e < best) {
+                    best = e;
+                    improved = true;
+                    break;
+                }
+                params.weight[t] -= dir;
+            }
+        }
+
+        out << "Pass " << pass + 1 << ", step " << step << ": error " << best << "\n";
+        out.flush();
+        if (!improved) {
+            if (step == 1) break;
+            step /= 2;
+        }
+    }
+
+    for (int t = 0; t < kTerms; ++t) {
+        out << UltimateHeuristicParams::termName(t) << ": " << initial.weight[t] << " -> " << params.weight[t]
+            << "\n";
+    }
+    out << "Error " << before << " -> " << best << "\n";
+
+    QString error;
+    if (!params.save(parser.value(outOption), &error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+    err << "Saved " << parser.value(outOption) << "\n";
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "game/ai/ultimate_book.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+// Builds the Ultimate opening book read by GameEngine. Put the output next
+// to the game executable as ultimate.book.
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ultimate_book");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates an opening book for Ultimate tic-tac-toe.");
+    parser.addHelpOption();
+
+    QCommandLineOption outOption(QStringList() << "o" << "output", "Output file.", "file", "ultimate.book");
+    QCommandLineOption pliesOption("plies", "Moves of the game covered by the book.", "n", "5");
+    QCommandLineOption depthOption(QStringList() << "d" << "depth", "Search depth per position.", "n", "8");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Worker threads (0 = all cores).", "n", "0");
+    QCommandLineOption paramsOption("params", "Heuristic weights to search with (default: built-in).", "file");
+    for (const QCommandLineOption& o : { outOption, pliesOption, depthOption, threadsOption, paramsOption }) {
+        parser.addOption(o);
+    }
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    UltimateOpeningBook::BuildOptions options;
+    options.plies = parser.value(pliesOption).toInt();
+    options.depth = parser.value(depthOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+
+    QString error;
+    if (parser.isSet(paramsOption) && !options.params.load(parser.value(paramsOption), &error)) {
+        err << parser.value(paramsOption) << ": " << error << "\n";
+        return 1;
+    }
+
+    qint64 last = -1;
+    const bool built = UltimateOpeningBook::generate(options, parser.value(outOption), &error,
+                                                     [&err, &last](qint64 done, qint64 total) {
+                                                         const qint64 percent = done * 100 / total;
+                                                         if (percent == last) return;
+                                                         last = percent;
+                                                         err << "\r" << done << " / " << total;
+                                                         err.flush();
+                                                     });
+    if (!built) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+
+    UltimateOpeningBook book;
+    if (!book.open(parser.value(outOption), &error)) {
+        err << "Failed: " << error << "\n";
+        return 1;
+    }
+    err << "\nWrote " << book.size() << " positions to " << parser.value(outOption) << "\n";
+    return 0;
+}
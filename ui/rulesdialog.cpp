@@ -53,6 +53,29 @@ setWindowTitle("Правила");
         return;
     }
 
+    if (mode == GameMode::UltimateRecursive) {
+        text_->setText(
+            "Ultimate 27×27:\n"
+            "1) Правила Ultimate, вложенные на три уровня: поле 27×27 состоит из 9 полей 9×9, каждое из них — из 9 малых полей 3×3.\n"
+            "2) Малое поле выигрывается как обычные крестики-нолики; выигранное поле занимает свою клетку в поле уровнем выше.\n"
+            "3) Следующий игрок ходит в малое поле, соответствующее позиции клетки хода внутри её малого поля, причём внутри того поля 9×9, которое соответствует позиции этого малого поля внутри его поля 9×9.\n"
+            "4) Если требуемое малое поле закрыто (выиграно или заполнено), можно ходить в любое доступное малое поле его поля 9×9; если закрыто и оно — ход свободный.\n"
+            "5) Побеждает игрок, который выиграл три поля 9×9 подряд на верхнем поле 3×3.\n"
+            "6) Если ходов больше нет и победителя нет, фиксируется ничья."
+        );
+        return;
+    }
+
+    if (mode == GameMode::KInARow) {
+        text_->setText(
+            "Пять в ряд:\n"
+            "1) Поле 15×15, X ходят первыми.\n"
+            "2) Побеждает тот, кто первым выставит 5 своих символов подряд по горизонтали, вертикали или диагонали.\n"
+            "3) Если поле заполнено и победителя нет, фиксируется ничья."
+        );
+        return;
+    }
+
     text_->setText("Для этого режима отдельные правила не предусмотрены.");
     return;
 }
@@ -85,6 +108,29 @@ if (mode == GameMode::Ultimate) {
     return;
 }
 
+if (mode == GameMode::UltimateRecursive) {
+    text_->setText(
+        "Ultimate 27×27:\n"
+        "1) Ultimate rules nested three levels deep: the 27×27 board holds 9 boards of 9×9, each made of 9 local 3×3 boards.\n"
+        "2) A local board is won like normal tic-tac-toe; a won board claims its square in the board one level up.\n"
+        "3) The next player must play in the local board matching the position of the move inside its local board, within the 9×9 board matching the position of that local board inside its 9×9 board.\n"
+        "4) If that local board is closed (won or full), any available local board of its 9×9 board is allowed; if that one is closed too, the move is free.\n"
+        "5) You win by winning three 9×9 boards in a row on the top 3×3 board.\n"
+        "6) If no moves remain and there is no winner, the game is a draw."
+    );
+    return;
+}
+
+if (mode == GameMode::KInARow) {
+    text_->setText(
+        "Five in a row:\n"
+        "1) Board 15×15, X moves first.\n"
+        "2) The first player to place 5 marks in a row (row/column/diagonal) wins.\n"
+        "3) If the board is full and there is no winner, the game is a draw."
+    );
+    return;
+}
+
 text_->setText("No separate rules for this mode.");
 
 
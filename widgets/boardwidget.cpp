@@ -1,11 +1,13 @@
 #include "boardwidget.h"
 
+#include <QEvent>
 #include <QGridLayout>
 #include <QPushButton>
 #include <QResizeEvent>
 #include <QFont>
 #include <QSizePolicy>
 #include <QPainter>
+#include <QVariant>
 #include <algorithm>
 
 namespace {
@@ -20,11 +22,31 @@ public:
     void setShowWeight(bool on) { showWeight_ = on; update(); }
     bool showWeight() const { return showWeight_; }
 
+    void setHighlighted(bool on) {
+        if (highlighted_ == on) return;
+        highlighted_ = on;
+        update();
+    }
+
+    void setPreview(const QString& text) {
+        if (preview_ == text) return;
+        preview_ = text;
+        update();
+    }
+
+    void setHeat(double heat, const QString& label) {
+        if (heat_ == heat && heatLabel_ == label) return;
+        heat_ = heat;
+        heatLabel_ = label;
+        update();
+    }
+
 protected:
     void paintEvent(QPaintEvent* e) override {
         QPushButton::paintEvent(e);
 
-        if (!showWeight_ || weight_ == 0) return;
+        const bool weight = showWeight_ && weight_ != 0;
+        if (heat_ < 0 && !highlighted_ && !weight && preview_.isEmpty()) return;
 
         QPainter p(this);
         p.setRenderHint(QPainter::Antialiasing, true);
@@ -34,16 +56,40 @@ protected:
         f.setBold(true);
         p.setFont(f);
 
-        const QString s = (weight_ > 0) ? QString("+%1").arg(weight_) : QString::number(weight_);
         const int pad = 6;
         QRect r = rect().adjusted(pad, pad, -pad, -pad);
 
+        if (heat_ >= 0) {
+            // Red for the weakest move through yellow to green for the best.
+            p.fillRect(rect().adjusted(2, 2, -2, -2), QColor::fromHsv(static_cast<int>(heat_ * 120), 200, 235, 110));
+            if (width() >= 40 && !heatLabel_.isEmpty()) p.drawText(r, Qt::AlignLeft | Qt::AlignTop, heatLabel_);
+        }
+
+        if (highlighted_) {
+            p.setPen(QPen(QColor(230, 120, 0), 3));
+            p.drawRect(rect().adjusted(2, 2, -3, -3));
+            p.setPen(QPen(palette().color(QPalette::ButtonText)));
+        }
+
+        if (!preview_.isEmpty()) {
+            p.setPen(QPen(QColor(30, 90, 200)));
+            p.drawText(r, Qt::AlignLeft | Qt::AlignBottom, preview_);
+            p.setPen(QPen(palette().color(QPalette::ButtonText)));
+        }
+
+        if (!weight) return;
+
+        const QString s = (weight_ > 0) ? QString("+%1").arg(weight_) : QString::number(weight_);
         p.drawText(r, Qt::AlignRight | Qt::AlignBottom, s);
     }
 
 private:
     int weight_ = 0;
     bool showWeight_ = false;
+    bool highlighted_ = false;
+    double heat_ = -1.0;
+    QString heatLabel_;
+    QString preview_;
 };
 
 inline CellButton* asCell(QPushButton* b) { return static_cast<CellButton*>(b); }
@@ -98,6 +144,56 @@ void BoardWidget::setShowWeights(bool on) {
     }
 }
 
+void BoardWidget::setHighlightedCell(int r, int c) {
+    const int idx = (r >= 0 && c >= 0 && r < N_ && c < N_) ? r * N_ + c : -1;
+    if (idx == highlighted_) return;
+
+    if (highlighted_ >= 0 && highlighted_ < cellsCount_ && cells_[highlighted_]) {
+        asCell(cells_[highlighted_])->setHighlighted(false);
+    }
+    highlighted_ = idx;
+    if (highlighted_ >= 0 && highlighted_ < cellsCount_ && cells_[highlighted_]) {
+        asCell(cells_[highlighted_])->setHighlighted(true);
+    }
+}
+
+void BoardWidget::setCellHeat(int r, int c, double heat, const QString& label) {
+    if (r < 0 || c < 0 || r >= N_ || c >= N_) return;
+    const int idx = r * N_ + c;
+    if (!cells_ || idx >= cellsCount_ || !cells_[idx]) return;
+    asCell(cells_[idx])->setHeat(heat, label);
+}
+
+void BoardWidget::clearHeat() {
+    for (int i = 0; i < cellsCount_; ++i) {
+        if (cells_[i]) asCell(cells_[i])->setHeat(-1.0, QString());
+    }
+}
+
+void BoardWidget::setHoverPreview(int r, int c, const QString& text) {
+    const int idx = (r >= 0 && c >= 0 && r < N_ && c < N_) ? r * N_ + c : -1;
+
+    if (preview_ >= 0 && preview_ != idx && preview_ < cellsCount_ && cells_[preview_]) {
+        asCell(cells_[preview_])->setPreview(QString());
+    }
+    preview_ = text.isEmpty() ? -1 : idx;
+    if (preview_ >= 0 && preview_ < cellsCount_ && cells_[preview_]) {
+        asCell(cells_[preview_])->setPreview(text);
+    }
+}
+
+bool BoardWidget::eventFilter(QObject* watched, QEvent* event) {
+    if (event->type() == QEvent::Enter || event->type() == QEvent::Leave) {
+        const QVariant cell = watched->property("cell");
+        if (cell.isValid()) {
+            const int idx = cell.toInt();
+            if (event->type() == QEvent::Enter) emit cellHovered(idx / N_, idx % N_);
+            else emit cellHovered(-1, -1);
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
 void BoardWidget::setCellSizePx(int px) {
     cellSizePx_ = px;
     if (cellSizePx_ < 0) cellSizePx_ = 0;
@@ -110,9 +206,10 @@ void BoardWidget::setCellText(int r, int c, const QString& text, bool enabled) {
     if (!cells_ || idx < 0 || idx >= cellsCount_) return;
     if (!cells_[idx]) return;
 
-    cells_[idx]->setText(text);
-    cells_[idx]->setEnabled(enabled);
-    updateCellVisuals();
+    // Font and size do not depend on the text, so a full-board refresh stays
+    // linear in the number of cells.
+    if (cells_[idx]->text() != text) cells_[idx]->setText(text);
+    if (cells_[idx]->isEnabled() != enabled) cells_[idx]->setEnabled(enabled);
 }
 
 void BoardWidget::rebuild() {
@@ -123,6 +220,8 @@ void BoardWidget::rebuild() {
 
     delete[] cells_;
     delete[] weights_;
+    highlighted_ = -1;
+    preview_ = -1;
     cellsCount_ = N_ * N_;
     cells_ = new QPushButton*[cellsCount_];
     weights_ = new int[cellsCount_];
@@ -139,6 +238,8 @@ void BoardWidget::rebuild() {
             b->setText("");
             b->setShowWeight(showWeights_);
             b->setWeight(0);
+            b->setProperty("cell", r * N_ + c);
+            b->installEventFilter(this);
 
             const int rr = r;
             const int cc = c;
@@ -7,6 +7,7 @@
 class QPushButton;
 class QGridLayout;
 class QResizeEvent;
+class QEvent;
 
 class BoardWidget : public QWidget {
     Q_OBJECT
@@ -15,6 +16,7 @@ public:
     ~BoardWidget() override;
 
     void setBoardSize(int n);
+    int boardSize() const { return N_; }
     void resetBoard();
 
     void setCellText(int r, int c, const QString& text, bool enabled);
@@ -25,11 +27,26 @@ public:
 
     void setCellSizePx(int px);
 
+    // Frames one cell (the engine's current best move); -1 clears it.
+    void setHighlightedCell(int r, int c);
+
+    // Analysis shading: heat 0 (weakest move) .. 1 (best), with the score
+    // drawn in the corner on cells large enough; a negative heat clears it.
+    void setCellHeat(int r, int c, double heat, const QString& label);
+    void clearHeat();
+
+    // A short text drawn in the lower-left corner of one cell, e.g. what the
+    // hovered move would score; an empty text or -1 clears it.
+    void setHoverPreview(int r, int c, const QString& text);
+
 signals:
     void cellClicked(int r, int c);
+    // The mouse entered a cell; -1, -1 when it left one.
+    void cellHovered(int r, int c);
 
 protected:
     void resizeEvent(QResizeEvent* event) override;
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
 private:
     void rebuild();
@@ -45,4 +62,6 @@ private:
     int* weights_ = nullptr;
     bool showWeights_ = false;
     int cellSizePx_ = 0;
+    int highlighted_ = -1;
+    int preview_ = -1;
 };